@@ -0,0 +1,353 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <bitset>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "./declares.h"
+#include "./Workspace.h"
+#include "utility/utility.h"
+#include "utility/Span.h"
+
+using std::bitset;
+using std::array;
+using std::shared_ptr;
+using std::vector;
+
+namespace sdm {
+
+/*!\class AddressDecoder
+ * \brief Selects the hard locations an address activates. SDM only goes
+ *        through this interface, so the hard location addresses can be
+ *        stored and searched in whichever way suits the address width and
+ *        threshold (AddressRegister, BitSlicedAddressRegister,
+ *        MultiIndexHashing).
+ *
+ * The number of hard locations is set at construction and may be any
+ * count, so the memory can be sized to a RAM budget instead of a power of
+ * two.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count. Only sets the
+ *                                 default number of hard locations.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class AddressDecoder {
+ public:
+  /**
+   * Number of hard locations unless another is given to the constructor.
+   */
+  static constexpr size_t HARD_LOCATION_COUNT =
+    std::exp2(HARD_LOCATION_BIT_COUNT);
+
+  /**
+   * Number of words in a packed address.
+   */
+  static constexpr size_t WORD_COUNT = wordCount(ADDRESS_BIT_COUNT);
+
+  virtual ~AddressDecoder() {}
+
+  size_t getHardLocationCount() const;
+
+  /**
+   * Acquires the hard locations within threshold of an address.
+   * @param bits The address data.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @param activated Output, the activated hard location indices in
+   *                  increasing order.
+   */
+  void activate(const bitset<ADDRESS_BIT_COUNT>& bits,
+                size_t threshold,
+                activationList* activated) const;
+
+  /**
+   * @param address The address packed in WORD_COUNT words, bit i in bit
+   *                (i % WORD_BIT_SIZE) of word (i / WORD_BIT_SIZE).
+   * @throw std::invalid_argument if address is not WORD_COUNT words.
+   */
+  void activate(Span<const WORD_TYPE> address,
+                size_t threshold,
+                activationList* activated) const;
+
+  /**
+   * Acquires the count hard locations nearest to an address, instead of
+   * those within a threshold, so the activation size does not depend on the
+   * address. Ties at the largest activated distance go to the lowest
+   * indices.
+   * @param bits The address data.
+   * @param count Number of hard locations to activate.
+   * @param activated Output, the activated hard location indices in
+   *                  increasing order.
+   * @param workspace Scratch buffers to reuse, nullptr to allocate them.
+   * @throw std::invalid_argument if count is above getHardLocationCount().
+   */
+  void activateNearest(const bitset<ADDRESS_BIT_COUNT>& bits,
+                       size_t count,
+                       activationList* activated,
+                       Workspace* workspace = nullptr) const;
+
+  /**
+   * @param address The address packed in WORD_COUNT words.
+   * @throw std::invalid_argument if address is not WORD_COUNT words, or
+   *        count is above getHardLocationCount().
+   */
+  void activateNearest(Span<const WORD_TYPE> address,
+                       size_t count,
+                       activationList* activated,
+                       Workspace* workspace = nullptr) const;
+
+  /**
+   * Acquires the hard locations within threshold of each of several
+   * addresses.
+   * @param addresses The addresses.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @param activated Output, resized to addresses.size(). Element i holds
+   *                  the activated hard location indices of addresses[i].
+   * @param workspace Scratch buffers to reuse, nullptr to allocate them.
+   */
+  void activateBatch(Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+                     size_t threshold,
+                     vector<activationList>* activated,
+                     Workspace* workspace = nullptr) const;
+
+ protected:
+  /**
+   * @param hardLocationCount Number of hard locations.
+   * @throw std::invalid_argument if hardLocationCount is 0 or the indices
+   *        do not fit in LOCATION_INDEX_TYPE.
+   */
+  explicit AddressDecoder(size_t hardLocationCount);
+
+  /**
+   * Activates the hard locations within threshold of the packed address.
+   * @param address WORD_COUNT words, unused high bits cleared.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @param activated Output, the activated hard location indices in
+   *                  increasing order.
+   */
+  virtual void _activate(const WORD_TYPE* address,
+                         size_t threshold,
+                         activationList* activated) const = 0;
+
+  /**
+   * Activates the hard locations within threshold of each packed address.
+   * Activates them one by one unless overridden.
+   * @param addresses Row-major matrix of addressCount x WORD_COUNT words.
+   * @param addressCount Number of addresses.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @param activated Output, addressCount lists.
+   */
+  virtual void _activateBatch(const WORD_TYPE* addresses,
+                              size_t addressCount,
+                              size_t threshold,
+                              activationList* activated) const;
+
+  /**
+   * Activates the count hard locations nearest to the packed address. Unless
+   * overridden, binary searches the smallest threshold activating at least
+   * count locations, then drops the ties above count, at the cost of about
+   * log2(ADDRESS_BIT_COUNT) activations.
+   * @param address WORD_COUNT words, unused high bits cleared.
+   * @param count Number of hard locations to activate, at most
+   *              getHardLocationCount().
+   * @param activated Output, the activated hard location indices in
+   *                  increasing order.
+   * @param workspace Scratch buffers.
+   */
+  virtual void _activateNearest(const WORD_TYPE* address,
+                                size_t count,
+                                activationList* activated,
+                                Workspace* workspace) const;
+
+  /**
+   * @throw std::invalid_argument if count is above getHardLocationCount().
+   */
+  void _checkNearestCount(size_t count) const;
+
+ protected:
+  const size_t _hardLocationCount;
+};
+
+/*!\typedef spAddressDecoder
+ * \brief Wraps AddressDecoder in shared_ptr.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+using spAddressDecoder =
+shared_ptr<AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::AddressDecoder(
+  size_t hardLocationCount) : _hardLocationCount(hardLocationCount) {
+  if (hardLocationCount == 0 ||
+      hardLocationCount - 1 > LOCATION_INDEX_TYPE(-1)) {
+    throw std::invalid_argument(
+      "Hard location indices must fit in LOCATION_INDEX_TYPE.");
+  }
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getHardLocationCount() const {
+  return _hardLocationCount;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::activate(
+  const bitset<ADDRESS_BIT_COUNT>& bits,
+  size_t threshold,
+  activationList* activated) const {
+  array<WORD_TYPE, WORD_COUNT> address;
+  bitsetToWords(bits, address.data());
+  _activate(address.data(), threshold, activated);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::activate(
+  Span<const WORD_TYPE> address,
+  size_t threshold,
+  activationList* activated) const {
+  if (address.size() != WORD_COUNT) {
+    throw std::invalid_argument("Address must have WORD_COUNT words.");
+  }
+  _activate(address.data(), threshold, activated);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+activateNearest(
+  const bitset<ADDRESS_BIT_COUNT>& bits,
+  size_t count,
+  activationList* activated,
+  Workspace* workspace) const {
+  _checkNearestCount(count);
+  array<WORD_TYPE, WORD_COUNT> address;
+  bitsetToWords(bits, address.data());
+  Workspace localWorkspace;
+  _activateNearest(address.data(), count, activated,
+                   workspace ? workspace : &localWorkspace);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+activateNearest(
+  Span<const WORD_TYPE> address,
+  size_t count,
+  activationList* activated,
+  Workspace* workspace) const {
+  if (address.size() != WORD_COUNT) {
+    throw std::invalid_argument("Address must have WORD_COUNT words.");
+  }
+  _checkNearestCount(count);
+  Workspace localWorkspace;
+  _activateNearest(address.data(), count, activated,
+                   workspace ? workspace : &localWorkspace);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::activateBatch(
+  Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+  size_t threshold,
+  vector<activationList>* activated,
+  Workspace* workspace) const {
+  Workspace localWorkspace;
+  vector<WORD_TYPE>& words =
+    (workspace ? workspace : &localWorkspace)->addressWords;
+  words.resize(addresses.size() * WORD_COUNT);
+  for (size_t i = 0; i < addresses.size(); i++) {
+    bitsetToWords(addresses[i], words.data() + i * WORD_COUNT);
+  }
+
+  activated->resize(addresses.size());
+  _activateBatch(words.data(), addresses.size(), threshold,
+                 activated->data());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activateBatch(
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  activationList* activated) const {
+  for (size_t i = 0; i < addressCount; i++) {
+    _activate(addresses + i * WORD_COUNT, threshold, &activated[i]);
+  }
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activateNearest(
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated,
+  Workspace* workspace) const {
+  size_t low = 0;
+  size_t high = ADDRESS_BIT_COUNT;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    _activate(address, middle, activated);
+    if (activated->size() >= count) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+
+  _activate(address, low, activated);
+  if (activated->size() == count) {
+    return;
+  }
+
+  // Keep everything nearer than low, and the first ties at low.
+  activationList& nearer = workspace->nearer;
+  nearer.clear();
+  if (low > 0) {
+    _activate(address, low - 1, &nearer);
+  }
+  size_t ties = count - nearer.size();
+  size_t kept = 0;
+  auto next = nearer.begin();
+  for (LOCATION_INDEX_TYPE location : *activated) {
+    if (next != nearer.end() && *next == location) {
+      (*activated)[kept++] = location;
+      ++next;
+    } else if (ties > 0) {
+      (*activated)[kept++] = location;
+      ties--;
+    }
+  }
+  activated->resize(kept);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_checkNearestCount(size_t count) const {
+  if (count > getHardLocationCount()) {
+    throw std::invalid_argument(
+      "Cannot activate more than getHardLocationCount() locations.");
+  }
+}
+
+}  // namespace sdm
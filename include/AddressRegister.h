@@ -20,51 +20,301 @@
 
 #include <gmpxx.h>
 
+#include <algorithm>
 #include <bitset>
 #include <array>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "./declares.h"
+#include "./AddressDecoder.h"
+#include "kernel/hamming.h"
+#include "utility/utility.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
+#include "utility/random.h"
 
 using std::bitset;
 using std::array;
 using std::shared_ptr;
+using std::vector;
 
 namespace sdm {
 
 /*!\class AddressRegister
  * \brief Represents the address register for sdm.
+ *
+ * The hard location addresses are packed in one contiguous, cache line
+ * aligned array of getHardLocationCount() LocationAddress, that is a
+ * row-major matrix of getHardLocationCount() x WORD_COUNT words. Bit i of
+ * an address is bit (i % WORD_BIT_SIZE) of word (i / WORD_BIT_SIZE), and the
+ * unused high bits of the last word are always 0. The kernels have fully
+ * unrolled instantiations for 64, 128, 256 and 512-bit addresses.
  * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
- * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count. Only sets the
+ *                                 default number of hard locations.
  */
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-class AddressRegister {
+class AddressRegister :
+  public AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> {
  public:
-  static constexpr size_t HARD_LOCATION_COUNT =
-    std::exp2(HARD_LOCATION_BIT_COUNT);
+  using AddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT;
+  using AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::WORD_COUNT;
 
   /**
-   * No-arg constructor.
+   * A hard location address, its width fixed at compile time.
+   */
+  typedef array<WORD_TYPE, WORD_COUNT> LocationAddress;
+
+  static_assert(sizeof(LocationAddress) == WORD_COUNT * sizeof(WORD_TYPE),
+                "Location addresses must be contiguous rows of words.");
+
+  /**
+   * Number of early exit blocks in each hard location address.
+   */
+  static constexpr size_t BLOCK_COUNT = hammingBlockCount(WORD_COUNT);
+
+  /**
+   * Addresses with at least this many blocks are activated with the early
+   * exit scan, which stops on a location once it is past the threshold.
+   */
+  static constexpr size_t EARLY_EXIT_MIN_BLOCK_COUNT = 2;
+
+  /**
+   * The early exit scan is only used for thresholds below this. A random
+   * location is ADDRESS_BIT_COUNT / 2 away on average, so with a larger
+   * threshold most locations are only rejected in their last blocks, and the
+   * mispredicted checks cost more than the SIMD kernels save.
+   */
+  static constexpr size_t EARLY_EXIT_MAX_THRESHOLD = ADDRESS_BIT_COUNT / 8;
+
+  /**
+   * Number of hard locations sampled to estimate how often each address bit
+   * is set. Only used to order the early exit blocks.
+   */
+  static constexpr size_t BIT_PROBABILITY_SAMPLE_COUNT = 4096;
+
+  /**
+   * Number of random addresses calibrateThreshold compares to every hard
+   * location.
+   */
+  static constexpr size_t CALIBRATION_QUERY_COUNT = 16;
+
+  /**
+   * No-arg constructor. Draws HARD_LOCATION_COUNT addresses serially from
+   * GMP's generator seeded with 0, so every instance is the same.
    */
   AddressRegister();
 
   /**
-   * Acquires the hammingDistanceArray given an address.
+   * Draws the addresses from a counter-based generator, in parallel. Much
+   * faster than the no-arg constructor, see generateRandomRows.
+   * @param seed Selects the addresses. The same seed gives the same
+   *             addresses, whatever threadCount.
+   * @param threadCount Number of threads, 0 for one per hardware thread.
+   * @param hardLocationCount Number of hard locations, need not be a power
+   *                          of two. The first n addresses are the same
+   *                          whatever hardLocationCount.
+   * @throw std::invalid_argument if hardLocationCount is out of range.
+   */
+  explicit AddressRegister(uint64_t seed,
+                           size_t threadCount = 0,
+                           size_t hardLocationCount = HARD_LOCATION_COUNT);
+
+  /**
+   * Acquires the hamming distance of each hard location given an address.
    * @param bits The address data.
-   * @return hammingDistanceArray.
+   * @return getHardLocationCount() distances.
    */
-  hammingDistanceArray<HARD_LOCATION_COUNT> getHammingDistanceArray(
+  vector<size_t> getHammingDistanceArray(
       const bitset<ADDRESS_BIT_COUNT>& bits) const;
-  hammingDistanceArray<HARD_LOCATION_COUNT> getHammingDistanceArray(
-    const mpz_class& bits) const;
+  vector<size_t> getHammingDistanceArray(const mpz_class& bits) const;
 
-  const array<mpz_class, HARD_LOCATION_COUNT>& getLocationAddresses() const;
-  array<mpz_class, HARD_LOCATION_COUNT>& getLocationAddresses();
+  /**
+   * Acquires the hamming distances given an already packed address.
+   * @param address WORD_COUNT words laid out like getLocationAddress rows.
+   * @return getHardLocationCount() distances.
+   */
+  vector<size_t> getHammingDistanceArray(Span<const WORD_TYPE> address) const;
+
+  /**
+   * Distribution of the distances between addresses and the hard locations,
+   * computed in one pass over the register, see hammingDistanceHistogram.
+   * @param addresses The addresses.
+   * @return ADDRESS_BIT_COUNT + 1 counts. Entry d is the number of
+   *         (address, hard location) pairs at distance d.
+   */
+  vector<size_t> getDistanceHistogram(
+    Span<const bitset<ADDRESS_BIT_COUNT>> addresses) const;
+
+  /**
+   * Picks the threshold from the distance distribution instead of guessing
+   * it. Random addresses are compared to every hard location in one pass
+   * over the register, and the threshold is read off the cumulative
+   * histogram of their distances.
+   * @param activationFraction Target fraction of the hard locations an
+   *                           address activates, e.g. 0.001.
+   * @param queryCount Number of random addresses sampled.
+   * @param seed Selects the random addresses.
+   * @return The smallest threshold at which a random address activates on
+   *         average at least activationFraction of the hard locations.
+   * @throw std::invalid_argument if activationFraction is not within [0, 1]
+   *        or queryCount is 0.
+   */
+  size_t calibrateThreshold(FLOAT activationFraction,
+                            size_t queryCount = CALIBRATION_QUERY_COUNT,
+                            uint64_t seed = 0) const;
+
+  /**
+   * @return View of all the hard location addresses, one row per location.
+   */
+  MatrixSpan<const WORD_TYPE> getLocationAddresses() const;
+
+  /**
+   * @return Writable view of all the hard location addresses.
+   * @throw std::invalid_argument if the register is shared, see share.
+   */
+  MatrixSpan<WORD_TYPE> getLocationAddresses();
+
+  /**
+   * Reorders the hard locations along the reflected Gray code of the first
+   * 64 bits of their addresses, so locations next to each other differ in
+   * few of their leading bits. When the addresses are clustered, the
+   * locations an address activates then gather in fewer row ranges of the
+   * counter grid. Uniformly random addresses gain nothing: an activation
+   * only slightly favours the leading bits of the address, and stays spread
+   * over the whole grid. The same locations are activated, under new
+   * indices. Counters already written must be moved along, see
+   * UpDownCounters::permuteLocations.
+   * @return Permutation, location i is the former location permutation[i].
+   * @throw std::invalid_argument if the register is shared, see share.
+   */
+  vector<size_t> sortLocations();
+
+  /**
+   * @param location Hard location index.
+   * @return View of the words of the given hard location address.
+   */
+  Span<const WORD_TYPE> getLocationAddress(size_t location) const;
+
+  /**
+   * @param location Hard location index.
+   * @return Writable view of the words of the given hard location address.
+   * @throw std::invalid_argument if the register is shared, see share.
+   */
+  Span<WORD_TYPE> getLocationAddress(size_t location);
+
+  /**
+   * Makes the register read-only for good: sortLocations and the writable
+   * address views throw from then on. Call it before handing the register
+   * to more than one owner, e.g. several SDMs, since reordering or writing
+   * the addresses under one owner would silently change what the others
+   * activate. SharedAddressRegisterFactory shares every register it interns.
+   */
+  void share();
+
+  /**
+   * @return Whether share was called.
+   */
+  bool isShared() const;
+
+ protected:
+  /**
+   * Hamming distance of each hard location to the packed address.
+   * @param address WORD_COUNT words, unused high bits cleared.
+   * @return getHardLocationCount() distances.
+   */
+  vector<size_t> _getHammingDistanceArray(const WORD_TYPE* address) const;
+
+  /**
+   * @param addresses Row-major matrix of addressCount x WORD_COUNT words.
+   * @param addressCount Number of addresses.
+   * @return See getDistanceHistogram.
+   */
+  vector<size_t> _getDistanceHistogram(const WORD_TYPE* addresses,
+                                       size_t addressCount) const;
+
+  void _activate(const WORD_TYPE* address,
+                 size_t threshold,
+                 activationList* activated) const override;
+
+  /**
+   * The register is read once per batch instead of once per address, see
+   * activateLocationsBatch.
+   */
+  void _activateBatch(const WORD_TYPE* addresses,
+                      size_t addressCount,
+                      size_t threshold,
+                      activationList* activated) const override;
+
+  /**
+   * Counting select over the distance histogram, see
+   * activateNearestLocations.
+   */
+  void _activateNearest(const WORD_TYPE* address,
+                        size_t count,
+                        activationList* activated,
+                        Workspace* workspace) const override;
+
+  /**
+   * Orders the early exit blocks so those in which address is expected to
+   * differ the most from the hard locations come first, and most locations
+   * are rejected after reading as few blocks as possible.
+   * @param address WORD_COUNT words.
+   * @param blockOrder Output, permutation of the BLOCK_COUNT block indices.
+   */
+  void _getBlockOrder(const WORD_TYPE* address, size_t* blockOrder) const;
+
+  /**
+   * Estimates _bitProbabilities from a sample of the hard locations.
+   */
+  void _computeBitProbabilities();
+
+  /**
+   * @param address WORD_COUNT words.
+   * @return Rank of the first 64 bits of address in the reflected Gray code
+   *         sequence, bit 0 the most significant.
+   */
+  static uint64_t _getGrayRank(const WORD_TYPE* address);
+
+  /**
+   * Packs the lowest ADDRESS_BIT_COUNT bits of an mpz_class.
+   * @param bits Value to pack.
+   * @param words Destination, WORD_COUNT words.
+   */
+  static void _toWords(const mpz_class& bits, WORD_TYPE* words);
+
+  /**
+   * @return The first word of the first hard location address.
+   */
+  const WORD_TYPE* _getLocationWords() const;
+
+  /**
+   * @throw std::invalid_argument if the register is shared.
+   */
+  void _checkUnshared() const;
 
  protected:
-  array<mpz_class, HARD_LOCATION_COUNT> _locationAddresses;
+  AlignedBuffer<LocationAddress> _locationAddresses;
+
+  /**
+   * Estimated probability of each address bit being set in a hard location.
+   * Stale if the addresses are modified through getLocationAddresses, which
+   * only makes the early exit block order less effective.
+   */
+  array<FLOAT, ADDRESS_BIT_COUNT> _bitProbabilities;
+
+  /**
+   * Set by share, never cleared.
+   */
+  bool _shared;
 };
 
 /*!\typedef spAddressRegister
@@ -77,77 +327,355 @@ using spAddressRegister =
 shared_ptr<AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
 
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::AddressRegister() {
-  // Initialize all _locationAddresses to 0.
-  for (mpz_class& hardAddress : _locationAddresses) {
-    hardAddress = 0;
-  }
-
-  mpz_class* lastAddress = &_locationAddresses.at(0);
-
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::AddressRegister()
+  : AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+      HARD_LOCATION_COUNT),
+    _locationAddresses(HARD_LOCATION_COUNT),
+    _shared(false) {
   gmp_randstate_t gmp_randstate;
   gmp_randinit_default(gmp_randstate);
   gmp_randseed_ui(gmp_randstate, 0);
 
-  for (size_t addrIndex = 1;
-       addrIndex < _locationAddresses.size();
+  mpz_class randomAddress;
+  for (size_t addrIndex = 0;
+       addrIndex < HARD_LOCATION_COUNT;
        addrIndex++) {
-    mpz_urandomb(lastAddress->get_mpz_t(), gmp_randstate, ADDRESS_BIT_COUNT);
-    _locationAddresses.at(addrIndex) = *lastAddress;
+    mpz_urandomb(randomAddress.get_mpz_t(), gmp_randstate, ADDRESS_BIT_COUNT);
+    _toWords(randomAddress, _locationAddresses[addrIndex].data());
   }
+
+  gmp_randclear(gmp_randstate);
+
+  _computeBitProbabilities();
 }
 
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-hammingDistanceArray<
-  AddressRegister<ADDRESS_BIT_COUNT,
-                  HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::AddressRegister(
+  uint64_t seed, size_t threadCount, size_t hardLocationCount)
+  : AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+      hardLocationCount),
+    _locationAddresses(hardLocationCount, false),
+    _shared(false) {
+  generateRandomRows(seed, hardLocationCount, ADDRESS_BIT_COUNT,
+                     _locationAddresses[0].data(), threadCount);
+
+  _computeBitProbabilities();
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+vector<size_t>
 AddressRegister<ADDRESS_BIT_COUNT,
                 HARD_LOCATION_BIT_COUNT>::getHammingDistanceArray(
   const bitset<ADDRESS_BIT_COUNT>& bits) const {
-  auto bitStr = bits.to_string();
-  mpz_class mpBit(bitStr, 2);
-  return getHammingDistanceArray(mpBit);
+  array<WORD_TYPE, WORD_COUNT> address;
+  bitsetToWords(bits, address.data());
+  return _getHammingDistanceArray(address.data());
 }
+
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-hammingDistanceArray<
-  AddressRegister<ADDRESS_BIT_COUNT,
-                  HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>
-  AddressRegister<ADDRESS_BIT_COUNT,
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT,
                   HARD_LOCATION_BIT_COUNT>::getHammingDistanceArray(
   const mpz_class& bits) const {
-  hammingDistanceArray<AddressRegister<
-    ADDRESS_BIT_COUNT,
-    HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT> hda;
-  for (size_t addrIndex = 0;
-       addrIndex < _locationAddresses.size();
-       addrIndex++) {
-    hda[addrIndex] = mpz_hamdist(bits.get_mpz_t(),
-                                 _locationAddresses[addrIndex].get_mpz_t());
+  array<WORD_TYPE, WORD_COUNT> address;
+  _toWords(bits, address.data());
+  return _getHammingDistanceArray(address.data());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT,
+                  HARD_LOCATION_BIT_COUNT>::getHammingDistanceArray(
+  Span<const WORD_TYPE> address) const {
+  if (address.size() != WORD_COUNT) {
+    throw std::invalid_argument("Address must have WORD_COUNT words.");
   }
+  return _getHammingDistanceArray(address.data());
+}
 
-  return hda;
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getDistanceHistogram(Span<const bitset<ADDRESS_BIT_COUNT>> addresses) const {
+  vector<WORD_TYPE> words(addresses.size() * WORD_COUNT);
+  for (size_t i = 0; i < addresses.size(); i++) {
+    bitsetToWords(addresses[i], words.data() + i * WORD_COUNT);
+  }
+  return _getDistanceHistogram(words.data(), addresses.size());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+calibrateThreshold(
+  FLOAT activationFraction, size_t queryCount, uint64_t seed) const {
+  if (!(activationFraction >= 0 && activationFraction <= 1) ||
+      queryCount == 0) {
+    throw std::invalid_argument(
+      "The activation fraction must be within [0, 1], with queries.");
+  }
+
+  std::mt19937_64 rng(seed);
+  vector<WORD_TYPE> queries(queryCount * WORD_COUNT);
+  for (size_t q = 0; q < queryCount; q++) {
+    for (size_t w = 0; w < WORD_COUNT; w++) {
+      queries[q * WORD_COUNT + w] = rng();
+    }
+    queries[q * WORD_COUNT + WORD_COUNT - 1] &=
+      lastWordMask(ADDRESS_BIT_COUNT);
+  }
+  const vector<size_t> histogram =
+    _getDistanceHistogram(queries.data(), queryCount);
+
+  const FLOAT target =
+    activationFraction * queryCount * this->getHardLocationCount();
+  size_t threshold = 0;
+  size_t within = histogram[0];
+  while (within < target && threshold < ADDRESS_BIT_COUNT) {
+    within += histogram[++threshold];
+  }
+  return threshold;
 }
 
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-const array<
-  mpz_class,
-  AddressRegister<
-    ADDRESS_BIT_COUNT,
-    HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>&
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::sortLocations() {
+  _checkUnshared();
+  const size_t hardLocationCount = this->getHardLocationCount();
+  vector<uint64_t> ranks(hardLocationCount);
+  for (size_t i = 0; i < hardLocationCount; i++) {
+    ranks[i] = _getGrayRank(_locationAddresses[i].data());
+  }
+  vector<size_t> permutation(hardLocationCount);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::stable_sort(permutation.begin(), permutation.end(),
+                   [&ranks](size_t a, size_t b) {
+                     return ranks[a] < ranks[b];
+                   });
+
+  AlignedBuffer<LocationAddress> sorted(hardLocationCount, false);
+  for (size_t i = 0; i < hardLocationCount; i++) {
+    sorted[i] = _locationAddresses[permutation[i]];
+  }
+  swap(_locationAddresses, sorted);
+  return permutation;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+MatrixSpan<const WORD_TYPE>
 AddressRegister<ADDRESS_BIT_COUNT,
                 HARD_LOCATION_BIT_COUNT>::getLocationAddresses() const {
-  return this->_locationAddresses;
+  return MatrixSpan<const WORD_TYPE>(
+    _getLocationWords(), this->getHardLocationCount(), WORD_COUNT);
 }
 
 template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-array<
-  mpz_class,
-  AddressRegister<
-    ADDRESS_BIT_COUNT,
-    HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>&
+MatrixSpan<WORD_TYPE>
 AddressRegister<ADDRESS_BIT_COUNT,
                 HARD_LOCATION_BIT_COUNT>::getLocationAddresses() {
-  return this->_locationAddresses;
+  _checkUnshared();
+  return MatrixSpan<WORD_TYPE>(
+    _locationAddresses[0].data(), this->getHardLocationCount(), WORD_COUNT);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+Span<const WORD_TYPE>
+AddressRegister<ADDRESS_BIT_COUNT,
+                HARD_LOCATION_BIT_COUNT>::getLocationAddress(
+  size_t location) const {
+  return getLocationAddresses()[location];
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+Span<WORD_TYPE>
+AddressRegister<ADDRESS_BIT_COUNT,
+                HARD_LOCATION_BIT_COUNT>::getLocationAddress(size_t location) {
+  return getLocationAddresses()[location];
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::share() {
+  _shared = true;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+bool AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::isShared()
+  const {
+  return _shared;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT,
+                HARD_LOCATION_BIT_COUNT>::_getHammingDistanceArray(
+  const WORD_TYPE* address) const {
+  vector<size_t> hda(this->getHardLocationCount());
+  hammingDistances(_getLocationWords(), hda.size(), WORD_COUNT,
+                   address, hda.data());
+
+  return hda;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+vector<size_t>
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getDistanceHistogram(const WORD_TYPE* addresses, size_t addressCount) const {
+  vector<size_t> histogram(WORD_COUNT * WORD_BIT_SIZE + 1);
+  hammingDistanceHistogram(_getLocationWords(), this->getHardLocationCount(),
+                           WORD_COUNT, addresses, addressCount,
+                           histogram.data());
+  // The unused high bits never differ.
+  histogram.resize(ADDRESS_BIT_COUNT + 1);
+  return histogram;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::_activate(
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) const {
+  if (BLOCK_COUNT < EARLY_EXIT_MIN_BLOCK_COUNT ||
+      threshold >= EARLY_EXIT_MAX_THRESHOLD) {
+    activateLocations(_getLocationWords(), this->getHardLocationCount(),
+                      WORD_COUNT, address, threshold, activated);
+    return;
+  }
+
+  array<size_t, BLOCK_COUNT> blockOrder;
+  _getBlockOrder(address, blockOrder.data());
+  activateLocations(_getLocationWords(), this->getHardLocationCount(),
+                    WORD_COUNT, address, threshold, blockOrder.data(),
+                    activated);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activateBatch(
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  activationList* activated) const {
+  activateLocationsBatch(_getLocationWords(), this->getHardLocationCount(),
+                         WORD_COUNT, addresses, addressCount, threshold,
+                         activated);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activateNearest(
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated,
+  Workspace* workspace) const {
+  activateNearestLocations(_getLocationWords(), this->getHardLocationCount(),
+                           WORD_COUNT, address, count, activated,
+                           &workspace->distances, &workspace->histogram);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getBlockOrder(const WORD_TYPE* address, size_t* blockOrder) const {
+  // Expected number of differing bits in each block.
+  array<FLOAT, BLOCK_COUNT> expectedDistances;
+  expectedDistances.fill(0);
+  for (size_t i = 0; i < ADDRESS_BIT_COUNT; i++) {
+    const bool bit = (address[i / WORD_BIT_SIZE] >> (i % WORD_BIT_SIZE)) & 1;
+    expectedDistances[i / (WORD_BIT_SIZE * HAMMING_BLOCK_WORD_COUNT)] +=
+      bit ? 1 - _bitProbabilities[i] : _bitProbabilities[i];
+  }
+
+  for (size_t b = 0; b < BLOCK_COUNT; b++) {
+    blockOrder[b] = b;
+  }
+  std::sort(blockOrder, blockOrder + BLOCK_COUNT,
+            [&expectedDistances](size_t lhs, size_t rhs) {
+              return expectedDistances[lhs] > expectedDistances[rhs];
+            });
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_computeBitProbabilities() {
+  _bitProbabilities.fill(0.5);
+  if (BLOCK_COUNT < EARLY_EXIT_MIN_BLOCK_COUNT) {
+    return;
+  }
+
+  const size_t sampleCount =
+    std::min(BIT_PROBABILITY_SAMPLE_COUNT, this->getHardLocationCount());
+  const size_t stride = this->getHardLocationCount() / sampleCount;
+  array<size_t, ADDRESS_BIT_COUNT> setCounts;
+  setCounts.fill(0);
+  for (size_t s = 0; s < sampleCount; s++) {
+    const auto& location = _locationAddresses[s * stride];
+    for (size_t w = 0; w < WORD_COUNT; w++) {
+      for (WORD_TYPE word = location[w]; word != 0; word &= word - 1) {
+        setCounts[w * WORD_BIT_SIZE + __builtin_ctzll(word)]++;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < ADDRESS_BIT_COUNT; i++) {
+    _bitProbabilities[i] = FLOAT(setCounts[i]) / sampleCount;
+  }
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+uint64_t AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getGrayRank(const WORD_TYPE* address) {
+  // Reverse the bits so bit 0 is the most significant.
+  uint64_t code = address[0];
+  code = ((code >> 1) & 0x5555555555555555ULL) |
+         ((code & 0x5555555555555555ULL) << 1);
+  code = ((code >> 2) & 0x3333333333333333ULL) |
+         ((code & 0x3333333333333333ULL) << 2);
+  code = ((code >> 4) & 0x0f0f0f0f0f0f0f0fULL) |
+         ((code & 0x0f0f0f0f0f0f0f0fULL) << 4);
+  code = __builtin_bswap64(code);
+
+  // The rank is the prefix XOR of the code.
+  for (size_t shift = 1; shift < 64; shift <<= 1) {
+    code ^= code >> shift;
+  }
+  return code;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::_toWords(
+  const mpz_class& bits, WORD_TYPE* words) {
+  static_assert(WORD_BIT_SIZE % GMP_LIMB_BITS == 0,
+                "A word must hold a whole number of GMP limbs.");
+  constexpr size_t LIMBS_PER_WORD = WORD_BIT_SIZE / GMP_LIMB_BITS;
+
+  const size_t limbCount = mpz_size(bits.get_mpz_t());
+  for (size_t w = 0; w < WORD_COUNT; w++) {
+    WORD_TYPE word = 0;
+    for (size_t l = 0; l < LIMBS_PER_WORD; l++) {
+      const size_t limbIndex = w * LIMBS_PER_WORD + l;
+      if (limbIndex < limbCount) {
+        word |= static_cast<WORD_TYPE>(
+          mpz_getlimbn(bits.get_mpz_t(), limbIndex)) << (l * GMP_LIMB_BITS);
+      }
+    }
+    words[w] = word;
+  }
+
+  words[WORD_COUNT - 1] &= lastWordMask(ADDRESS_BIT_COUNT);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+const WORD_TYPE*
+AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getLocationWords() const {
+  return _locationAddresses[0].data();
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_checkUnshared() const {
+  if (_shared) {
+    throw std::invalid_argument(
+      "Cannot modify the addresses of a shared AddressRegister.");
+  }
 }
 
 }  // namespace sdm
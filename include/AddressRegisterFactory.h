@@ -42,6 +42,24 @@ class AddressRegisterFactory :
                                         HARD_LOCATION_BIT_COUNT>(
       new AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>);
   }
+
+  /**
+   * @param seed Selects the addresses, see AddressRegister(uint64_t,
+   *             size_t, size_t).
+   * @param threadCount Number of threads, 0 for one per hardware thread.
+   * @param hardLocationCount Number of hard locations.
+   */
+  explicit AddressRegisterFactory(
+    uint64_t seed,
+    size_t threadCount = 0,
+    size_t hardLocationCount =
+      AddressRegister<
+        ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT) {
+    this->_instance = spAddressRegister<ADDRESS_BIT_COUNT,
+                                        HARD_LOCATION_BIT_COUNT>(
+      new AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+        seed, threadCount, hardLocationCount));
+  }
 };
 
 }  // namespace sdm
@@ -0,0 +1,244 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "./declares.h"
+#include "./AddressDecoder.h"
+#include "./AddressRegister.h"
+#include "kernel/hamming.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
+
+using std::array;
+using std::bitset;
+using std::shared_ptr;
+using std::vector;
+
+namespace sdm {
+
+/*!\class BitSlicedAddressRegister
+ * \brief Address register storing the hard location addresses transposed:
+ *        for each slice of BIT_SLICE_LOCATION_COUNT locations, bit-plane i
+ *        holds bit i of every location of the slice, see
+ *        transposeToBitSlices.
+ *
+ * An activation XORs each bit-plane with the broadcast query bit and sums
+ * the mismatches with a bit-sliced adder network, so one instruction covers
+ * as many locations as the vector has bits. The threshold comparison is
+ * also bit-sliced and yields the activation mask directly. Activates the
+ * same locations as the AddressRegister it is built from, and holds the same
+ * number of bits, rounded up to whole slices.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class BitSlicedAddressRegister :
+  public AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> {
+ public:
+  using AddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT;
+  using AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::WORD_COUNT;
+
+  /**
+   * No-arg constructor. Same hard location addresses as AddressRegister's.
+   */
+  BitSlicedAddressRegister();
+
+  /**
+   * Transposes the hard location addresses of an AddressRegister.
+   * @param addressRegister Register to transpose, of any hard location
+   *                        count.
+   */
+  explicit BitSlicedAddressRegister(
+    const AddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressRegister);
+
+  /**
+   * @return Number of slices, the last is padded if getHardLocationCount()
+   *         is not a multiple of BIT_SLICE_LOCATION_COUNT.
+   */
+  size_t getSliceCount() const;
+
+  /**
+   * Number of bit-planes of the distances to an address.
+   */
+  static constexpr size_t DISTANCE_PLANE_COUNT =
+    bitSlicedDistancePlaneCount(ADDRESS_BIT_COUNT);
+
+  /**
+   * Distances of address to every hard location, the starting point of
+   * updateActivation. They are bit-sliced like the addresses, see
+   * bitSlicedDistances.
+   * @param address The address.
+   * @param distances Output, resized to getSliceCount() *
+   *                  DISTANCE_PLANE_COUNT * BIT_SLICE_WORD_COUNT words.
+   */
+  void getDistances(const bitset<ADDRESS_BIT_COUNT>& address,
+                    vector<WORD_TYPE>* distances) const;
+
+  /**
+   * @param distances Distances, see getDistances.
+   * @param location Hard location index.
+   * @return The distance of the hard location.
+   */
+  size_t getDistance(const vector<WORD_TYPE>& distances,
+                     size_t location) const;
+
+  /**
+   * Activates the hard locations near address, which differs from the
+   * address of distances in the flipped bits only. Only the bit-planes of
+   * the flipped bits are read, and each moves the bit-sliced distances of
+   * as many hard locations as the vector has bits at once, see
+   * updateBitSlicedDistances. A query that drifts by a few bits costs
+   * O(getHardLocationCount() x flippedBits.size()) instead of a full
+   * activation.
+   * @param address The new address.
+   * @param flippedBits Positions of the bits that differ from the previous
+   *                    address, each listed once.
+   * @param threshold Maximum distance of an activated location.
+   * @param distances Input, the distances to the previous address, see
+   *                  getDistances. Output, the distances to address.
+   * @param activated Output, indices of the activated hard locations.
+   * @throw std::invalid_argument if distances is not of the size
+   *        getDistances gives it, or a flipped bit is out of range or
+   *        listed twice.
+   */
+  void updateActivation(const bitset<ADDRESS_BIT_COUNT>& address,
+                        Span<const size_t> flippedBits,
+                        size_t threshold,
+                        vector<WORD_TYPE>* distances,
+                        activationList* activated) const;
+
+ protected:
+  void _activate(const WORD_TYPE* address,
+                 size_t threshold,
+                 activationList* activated) const override;
+
+ protected:
+  /**
+   * getSliceCount() x ADDRESS_BIT_COUNT bit-planes of BIT_SLICE_WORD_COUNT
+   * words.
+   */
+  AlignedBuffer<WORD_TYPE> _planes;
+};
+
+/*!\typedef spBitSlicedAddressRegister
+ * \brief Wraps BitSlicedAddressRegister in shared_ptr.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+using spBitSlicedAddressRegister =
+shared_ptr<BitSlicedAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+BitSlicedAddressRegister() :
+  BitSlicedAddressRegister(
+    AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>()) {
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+BitSlicedAddressRegister(
+  const AddressRegister<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressRegister) :
+  AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+    addressRegister.getHardLocationCount()),
+  _planes(bitSliceCount(addressRegister.getHardLocationCount()) *
+          ADDRESS_BIT_COUNT * BIT_SLICE_WORD_COUNT) {
+  transposeToBitSlices(addressRegister.getLocationAddresses()[0].data(),
+                       this->getHardLocationCount(), ADDRESS_BIT_COUNT,
+                       _planes.data());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getSliceCount() const {
+  return bitSliceCount(this->getHardLocationCount());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getDistances(
+  const bitset<ADDRESS_BIT_COUNT>& address,
+  vector<WORD_TYPE>* distances) const {
+  array<WORD_TYPE, WORD_COUNT> words;
+  bitsetToWords(address, words.data());
+  distances->resize(
+    getSliceCount() * DISTANCE_PLANE_COUNT * BIT_SLICE_WORD_COUNT);
+  bitSlicedDistances(_planes.data(), this->getHardLocationCount(),
+                     ADDRESS_BIT_COUNT, words.data(), distances->data());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getDistance(const vector<WORD_TYPE>& distances, size_t location) const {
+  return bitSlicedDistance(distances.data(), ADDRESS_BIT_COUNT, location);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+updateActivation(
+  const bitset<ADDRESS_BIT_COUNT>& address,
+  Span<const size_t> flippedBits,
+  size_t threshold,
+  vector<WORD_TYPE>* distances,
+  activationList* activated) const {
+  if (distances->size() !=
+      getSliceCount() * DISTANCE_PLANE_COUNT * BIT_SLICE_WORD_COUNT) {
+    throw std::invalid_argument("Distances must come from getDistances.");
+  }
+  bitset<ADDRESS_BIT_COUNT> seen;
+  for (size_t bit : flippedBits) {
+    if (bit >= ADDRESS_BIT_COUNT) {
+      throw std::invalid_argument("Flipped bit out of range.");
+    }
+    if (seen.test(bit)) {
+      throw std::invalid_argument("Flipped bit listed twice.");
+    }
+    seen.set(bit);
+  }
+
+  array<WORD_TYPE, WORD_COUNT> words;
+  bitsetToWords(address, words.data());
+  updateBitSlicedDistances(_planes.data(), this->getHardLocationCount(),
+                           ADDRESS_BIT_COUNT, words.data(),
+                           flippedBits.data(), flippedBits.size(), threshold,
+                           distances->data(), activated);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void BitSlicedAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activate(
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) const {
+  activateBitSliced(_planes.data(), this->getHardLocationCount(),
+                    ADDRESS_BIT_COUNT, address, threshold, activated);
+}
+
+}  // namespace sdm
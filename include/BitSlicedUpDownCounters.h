@@ -0,0 +1,238 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "./declares.h"
+#include "./UpDownCounters.h"
+#include "./UpDownCountersBase.h"
+#include "kernel/counters.h"
+#include "utility/utility.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
+
+using std::array;
+using std::bitset;
+using std::vector;
+
+namespace sdm {
+
+/*!\struct BitSlicedCounter
+ * \brief Counter type selecting bit-sliced UpDownCounters of PLANE_COUNT
+ *        bits, for UpDownCounters, SDM and their factories.
+ * \tparam PLANE_COUNT Bit count of a counter, from 2 to
+ *                     MAX_BIT_SLICED_COUNTER_PLANE_COUNT.
+ */
+template<size_t PLANE_COUNT>
+struct BitSlicedCounter {
+};
+
+/*!\brief Updown counters for sdm stored as bit-planes, the UpDownCounters
+ *        of BitSlicedCounter<PLANE_COUNT>.
+ *
+ * Each row holds PLANE_COUNT bit-planes of DATA_BIT_COUNT bits, plane k
+ * holding bit k of every counter of the hard location in two's complement,
+ * padded to whole cache lines. A write ripples the +1 or -1 of each counter
+ * through the planes as a carry or a borrow, and a read sums the planes
+ * with bit-sliced full adders, see writeBitSlicedCounterRows and
+ * readBitSlicedCounterRows, so one bitwise instruction covers as many
+ * counters as the vector has bits.
+ *
+ * Reads and writes the same data as UpDownCounters of a PLANE_COUNT bit
+ * integer type: the counters saturate at -2^(PLANE_COUNT - 1) and
+ * 2^(PLANE_COUNT - 1) - 1. A counter takes PLANE_COUNT bits, so a grid of 4
+ * bit counters takes half the memory of int8_t ones. Weighted writes and
+ * reads are not supported.
+ * \tparam DATA_BIT_COUNT Bit count of the data to be saved/retrieved.
+ * \tparam HARD_LOCATION_BIT_COUNT Bit count of the hard location. Only sets
+ *                                 the default number of hard locations.
+ * \tparam PLANE_COUNT Bit count of a counter.
+ */
+template <
+  size_t DATA_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t PLANE_COUNT>
+class UpDownCounters<
+  DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>> :
+  public UpDownCountersBase<
+    UpDownCounters<
+      DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>>,
+    CounterGridRow<WORD_TYPE, PLANE_COUNT * wordCount(DATA_BIT_COUNT)>,
+    DATA_BIT_COUNT> {
+  static_assert(PLANE_COUNT >= 2 &&
+                PLANE_COUNT <= MAX_BIT_SLICED_COUNTER_PLANE_COUNT,
+                "Bit-sliced counters have 2 to "
+                "MAX_BIT_SLICED_COUNTER_PLANE_COUNT bits.");
+
+ public:
+  /**
+   * Number of hard locations unless another is given to the constructor.
+   */
+  static constexpr size_t HARD_LOCATION_COUNT =
+    std::exp2(HARD_LOCATION_BIT_COUNT);
+
+  /**
+   * Number of words in a bit-plane.
+   */
+  static constexpr size_t PLANE_WORD_COUNT = wordCount(DATA_BIT_COUNT);
+
+  /**
+   * The bit-planes of a row of counters, padded to whole cache lines.
+   */
+  typedef CounterGridRow<WORD_TYPE, PLANE_COUNT * PLANE_WORD_COUNT>
+    CounterRow;
+
+  /**
+   * Distance in words between the start of two rows.
+   */
+  static constexpr size_t ROW_STRIDE = sizeof(CounterRow) / sizeof(WORD_TYPE);
+
+  /**
+   * @param geometricRatio
+   * @param hardLocationCount Number of hard locations, need not be a power
+   *                          of two.
+   * @param hugePages false to keep the grid off transparent huge pages.
+   * @throw std::invalid_argument if hardLocationCount is 0 or the indices
+   *        do not fit in LOCATION_INDEX_TYPE.
+   */
+  explicit UpDownCounters(FLOAT geometricRatio,
+                          size_t hardLocationCount = HARD_LOCATION_COUNT,
+                          bool hugePages = true);
+
+  // The update flag overloads.
+  using UpDownCountersBase<
+    UpDownCounters, CounterRow, DATA_BIT_COUNT>::write;
+  using UpDownCountersBase<
+    UpDownCounters, CounterRow, DATA_BIT_COUNT>::read;
+
+  /**
+   * Input the bits to the activated hard locations only, see
+   * writeBitSlicedCounterRows.
+   * @param activated Indices of the hard locations to update.
+   * @param bits Input bits.
+   * @throw std::invalid_argument if an index is not that of a hard location.
+   */
+  void write(Span<const LOCATION_INDEX_TYPE> activated,
+             const bitset<DATA_BIT_COUNT>& bits);
+
+  /**
+   * Output the bits summed over the activated hard locations only, see
+   * readBitSlicedCounterRows.
+   * @param activated Indices of the hard locations to read.
+   * @return The output.
+   * @throw std::invalid_argument if an index is not that of a hard location.
+   */
+  bitset<DATA_BIT_COUNT> read(Span<const LOCATION_INDEX_TYPE> activated) const;
+
+  /**
+   * @param location Index of the hard location.
+   * @param bit Index of the data bit.
+   * @return The counter of the data bit at the hard location, gathered from
+   *         its bit-planes.
+   */
+  COUNTER_TYPE getCounter(size_t location, size_t bit) const;
+};
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          size_t PLANE_COUNT>
+UpDownCounters<
+  DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>>::
+UpDownCounters(
+  FLOAT geometricRatio, size_t hardLocationCount, bool hugePages) :
+  UpDownCountersBase<UpDownCounters, CounterRow, DATA_BIT_COUNT>(
+    geometricRatio, hardLocationCount, hugePages) {
+}
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          size_t PLANE_COUNT>
+void UpDownCounters<
+  DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>>::
+write(Span<const LOCATION_INDEX_TYPE> activated,
+      const bitset<DATA_BIT_COUNT> &bits) {
+  this->_checkActivated(activated);
+  array<WORD_TYPE, PLANE_WORD_COUNT> words;
+  bitsetToWords(bits, words.data());
+  writeBitSlicedCounterRows(
+    reinterpret_cast<WORD_TYPE*>(this->_upDownCounters.data()), ROW_STRIDE,
+    PLANE_COUNT, activated.data(), activated.size(), words.data(),
+    DATA_BIT_COUNT);
+}
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          size_t PLANE_COUNT>
+bitset<DATA_BIT_COUNT> UpDownCounters<
+  DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>>::
+read(Span<const LOCATION_INDEX_TYPE> activated) const {
+  this->_checkActivated(activated);
+  array<WORD_TYPE, PLANE_WORD_COUNT> words;
+  readBitSlicedCounterRows(
+    reinterpret_cast<const WORD_TYPE*>(this->_upDownCounters.data()),
+    ROW_STRIDE, PLANE_COUNT, activated.data(), activated.size(),
+    DATA_BIT_COUNT, words.data());
+  return wordsToBitset<DATA_BIT_COUNT>(words.data());
+}
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          size_t PLANE_COUNT>
+COUNTER_TYPE UpDownCounters<
+  DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, BitSlicedCounter<PLANE_COUNT>>::
+getCounter(size_t location, size_t bit) const {
+  const CounterRow& row = this->_upDownCounters[location];
+  uint64_t counter = 0;
+  for (size_t k = 0; k < PLANE_COUNT; k++) {
+    counter |= ((row[k * PLANE_WORD_COUNT + bit / WORD_BIT_SIZE] >>
+                 (bit % WORD_BIT_SIZE)) & 1) << k;
+  }
+  // Sign extends the top bit-plane.
+  const uint64_t sign = uint64_t(1) << (PLANE_COUNT - 1);
+  return static_cast<COUNTER_TYPE>(counter ^ sign) -
+         static_cast<COUNTER_TYPE>(sign);
+}
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          size_t PLANE_COUNT>
+std::ostream& operator<<(
+  std::ostream& os,
+  const UpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT,
+    BitSlicedCounter<PLANE_COUNT>>& upDownCounters) {
+  for (size_t row = 0; row < upDownCounters.getHardLocationCount(); row++) {
+    for (size_t bit = 0; bit < DATA_BIT_COUNT; bit++) {
+      os << upDownCounters.getCounter(row, bit) << " ";
+    }
+    os << std::endl;
+  }
+  return os;
+}
+
+}  // namespace sdm
@@ -0,0 +1,288 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <bitset>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "./declares.h"
+#include "./SDM.h"
+#include "./UpDownCounters.h"
+#include "./Workspace.h"
+#include "utility/Span.h"
+
+using std::bitset;
+using std::shared_ptr;
+using std::vector;
+
+namespace sdm {
+
+/*!\class MultiBankSDM
+ * \brief SDM over several banks of UpDownCounters sharing one
+ *        AddressDecoder.
+ *
+ * Each bank is a memory of its own, but an address activates the same hard
+ * locations in all of them, so writeBanks and readBanks activate once and
+ * apply the activation to every bank. Bank 0 is also the counters of the
+ * SDM interface, so write and read on their own only use bank 0.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ * \tparam DATA_BIT_COUNT Number of bits in the data of each bank.
+ * \tparam COUNTER Counter type of the banks.
+ */
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
+class MultiBankSDM :
+  public SDM<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER> {
+ public:
+  /**
+   * @param addressDecoder AddressDecoder shared by the banks.
+   * @param banks The banks, at least one.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @throw std::invalid_argument if banks is empty, or a bank has another
+   *        number of hard locations than addressDecoder.
+   */
+  MultiBankSDM(
+    const spAddressDecoder<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressDecoder,
+    const vector<spUpDownCounters<
+      DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>>& banks,
+    size_t threshold);
+
+  size_t getBankCount() const;
+
+  /**
+   * @param bank Bank index.
+   * @return The counters of the bank.
+   */
+  const spUpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>& getBank(
+      size_t bank) const;
+
+  /**
+   * Writes data[b] to bank b at the locations selected by address.
+   * @param address
+   * @param data One per bank.
+   * @param workspace Scratch buffers to reuse, or nullptr to allocate them.
+   * @throw std::invalid_argument if there is not one data per bank.
+   */
+  void writeBanks(
+    const bitset<ADDRESS_BIT_COUNT>& address,
+    Span<const bitset<DATA_BIT_COUNT>> data,
+    Workspace* workspace = nullptr);
+
+  /**
+   * Reads every bank at the locations selected by address.
+   * @param address
+   * @param data Output, one per bank.
+   * @param workspace Scratch buffers to reuse, or nullptr to allocate them.
+   * @throw std::invalid_argument if there is not one data per bank.
+   */
+  void readBanks(
+    const bitset<ADDRESS_BIT_COUNT>& address,
+    Span<bitset<DATA_BIT_COUNT>> data,
+    Workspace* workspace = nullptr) const;
+
+ protected:
+  /**
+   * @param dataCount Number of data passed, one per bank.
+   * @throw std::invalid_argument if dataCount is not getBankCount().
+   */
+  void _checkBankCount(size_t dataCount) const;
+
+  void _permuteLocations(Span<const size_t> permutation) override;
+
+  /**
+   * @param banks
+   * @return The first bank.
+   * @throw std::invalid_argument if banks is empty.
+   */
+  static const spUpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>&
+  _getFirstBank(
+    const vector<spUpDownCounters<
+      DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>>& banks);
+
+ protected:
+  vector<spUpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>> _banks;
+};
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
+using spMultiBankSDM =
+shared_ptr<MultiBankSDM<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER>>;
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+MultiBankSDM<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER>::
+MultiBankSDM(
+  const spAddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressDecoder,
+  const vector<spUpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>>& banks,
+  size_t threshold) :
+  SDM<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER>(
+    addressDecoder, _getFirstBank(banks), threshold),
+  _banks(banks) {
+  for (const auto& bank : _banks) {
+    if (bank->getHardLocationCount() !=
+        addressDecoder->getHardLocationCount()) {
+      throw std::invalid_argument(
+        "Address decoder and banks must have as many hard locations.");
+    }
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+size_t MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getBankCount() const {
+  return _banks.size();
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+const spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>&
+MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getBank(size_t bank) const {
+  return _banks.at(bank);
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::writeBanks(
+  const bitset<ADDRESS_BIT_COUNT>& address,
+  Span<const bitset<DATA_BIT_COUNT>> data,
+  Workspace* workspace) {
+  _checkBankCount(data.size());
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  this->_getActivatedLocations(address, workspace);
+  for (size_t bank = 0; bank < _banks.size(); bank++) {
+    _banks[bank]->write(workspace->activated, data[bank]);
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::readBanks(
+  const bitset<ADDRESS_BIT_COUNT>& address,
+  Span<bitset<DATA_BIT_COUNT>> data,
+  Workspace* workspace) const {
+  _checkBankCount(data.size());
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  this->_getActivatedLocations(address, workspace);
+  for (size_t bank = 0; bank < _banks.size(); bank++) {
+    data[bank] = _banks[bank]->read(workspace->activated);
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_checkBankCount(size_t dataCount) const {
+  if (dataCount != _banks.size()) {
+    throw std::invalid_argument("One data per bank is required.");
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_permuteLocations(Span<const size_t> permutation) {
+  for (auto& bank : _banks) {
+    bank->permuteLocations(permutation);
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+const spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>&
+MultiBankSDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_getFirstBank(
+  const vector<spUpDownCounters<
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>>& banks) {
+  if (banks.empty()) {
+    throw std::invalid_argument("At least one bank is required.");
+  }
+  return banks[0];
+}
+
+}  // namespace sdm
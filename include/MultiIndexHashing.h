@@ -0,0 +1,350 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "./declares.h"
+#include "./AddressDecoder.h"
+#include "./AddressRegister.h"
+#include "utility/utility.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
+
+using std::bitset;
+using std::shared_ptr;
+using std::vector;
+
+namespace sdm {
+
+/*!\class MultiIndexHashing
+ * \brief Exact r-neighbor index over the hard location addresses of an
+ *        AddressRegister (Norouzi et al., multi-index hashing).
+ *
+ * Addresses are split in m disjoint substrings and each substring is
+ * indexed in its own table. By the pigeonhole principle, a location within
+ * r of a query is within floor(r / m) of it in at least one substring, so
+ * the candidates are found by probing each table with every substring value
+ * within floor(r / m) of the query's, then verified with their full
+ * distance. The cost is proportional to the number of probes and
+ * candidates instead of the number of hard locations, which pays off when
+ * r is small compared to ADDRESS_BIT_COUNT. When it does not, activate
+ * falls back to the linear scan of the AddressRegister.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class MultiIndexHashing :
+  public AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> {
+ public:
+  using AddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT;
+  using AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::WORD_COUNT;
+
+  /**
+   * Widest substring. Each table has 2^width buckets.
+   */
+  static constexpr size_t MAX_SUBSTRING_BIT_COUNT = 24;
+
+  /**
+   * Queries whose estimated cost (probes plus candidates) is above
+   * getHardLocationCount() / SCAN_COST_RATIO use the linear scan instead, which
+   * is sequential and vectorized.
+   */
+  static constexpr size_t SCAN_COST_RATIO = 8;
+
+  /**
+   * Builds the index.
+   * @param addressRegister Register to index. Its addresses must not be
+   *                        modified afterwards.
+   * @param substringCount Number of substrings, m. 0 picks the smallest m
+   *                       with substrings of at most
+   *                       ceil(log2(getHardLocationCount())) bits, so each
+   *                       table has about as many buckets as there are hard
+   *                       locations.
+   * @throw std::invalid_argument if the substrings would be wider than
+   *        MAX_SUBSTRING_BIT_COUNT or narrower than a bit.
+   */
+  explicit MultiIndexHashing(
+    const spAddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressRegister,
+    size_t substringCount = 0);
+
+  /**
+   * @param threshold Maximum hamming distance of an activated location.
+   * @return Expected number of table probes plus candidates of a random
+   *         query.
+   */
+  FLOAT getExpectedCost(size_t threshold) const;
+
+  size_t getSubstringCount() const;
+
+  const spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&
+  getAddressRegister() const;
+
+ protected:
+  /**
+   * Same result as AddressRegister::_activate.
+   */
+  void _activate(const WORD_TYPE* address,
+                 size_t threshold,
+                 activationList* activated) const override;
+
+  /**
+   * The index cannot bound the distance of the count-th nearest location,
+   * so this is the AddressRegister's counting select.
+   */
+  void _activateNearest(const WORD_TYPE* address,
+                        size_t count,
+                        activationList* activated,
+                        Workspace* workspace) const override;
+
+  /**
+   * @param address WORD_COUNT words.
+   * @param substring Substring index.
+   * @return The bits of the substring, in the lowest bits.
+   */
+  WORD_TYPE _getSubstring(const WORD_TYPE* address, size_t substring) const;
+
+  size_t _getSubstringBitCount(size_t substring) const;
+
+ protected:
+  spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+    _addressRegister;
+
+  /**
+   * First bit of each substring, followed by ADDRESS_BIT_COUNT.
+   */
+  vector<size_t> _substringOffsets;
+
+  /**
+   * For each table, the start of each bucket in _bucketLocations, followed
+   * by getHardLocationCount().
+   */
+  vector<AlignedBuffer<uint32_t>> _bucketOffsets;
+
+  /**
+   * For each table, the hard locations sorted by substring value.
+   */
+  vector<AlignedBuffer<LOCATION_INDEX_TYPE>> _bucketLocations;
+};
+
+/*!\typedef spMultiIndexHashing
+ * \brief Wraps MultiIndexHashing in shared_ptr.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+using spMultiIndexHashing =
+shared_ptr<MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+MultiIndexHashing(
+  const spAddressRegister<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressRegister,
+  size_t substringCount) :
+  AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+    addressRegister->getHardLocationCount()),
+  _addressRegister(addressRegister) {
+  if (substringCount == 0) {
+    size_t width = 1;
+    while ((size_t(1) << width) < this->getHardLocationCount()) {
+      width++;
+    }
+    substringCount = (ADDRESS_BIT_COUNT + width - 1) / width;
+  }
+  if (substringCount > ADDRESS_BIT_COUNT ||
+      (ADDRESS_BIT_COUNT + substringCount - 1) / substringCount >
+      MAX_SUBSTRING_BIT_COUNT) {
+    throw std::invalid_argument(
+      "Substrings must be between 1 and MAX_SUBSTRING_BIT_COUNT bits.");
+  }
+
+  // The first ADDRESS_BIT_COUNT % m substrings get the extra bits.
+  _substringOffsets.push_back(0);
+  for (size_t j = 0; j < substringCount; j++) {
+    const size_t width = ADDRESS_BIT_COUNT / substringCount +
+                         (j < ADDRESS_BIT_COUNT % substringCount ? 1 : 0);
+    _substringOffsets.push_back(_substringOffsets.back() + width);
+  }
+
+  // The const view, as a shared register refuses the writable one.
+  const auto locationAddresses =
+    static_cast<const AddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&>(*addressRegister)
+    .getLocationAddresses();
+
+  // Counting sort of the hard locations by substring value, per table.
+  _bucketOffsets.reserve(substringCount);
+  _bucketLocations.reserve(substringCount);
+  for (size_t j = 0; j < substringCount; j++) {
+    const size_t bucketCount = size_t(1) << _getSubstringBitCount(j);
+    AlignedBuffer<uint32_t> offsets(bucketCount + 1);
+    AlignedBuffer<LOCATION_INDEX_TYPE> locations(
+      this->getHardLocationCount());
+
+    for (size_t i = 0; i < this->getHardLocationCount(); i++) {
+      offsets[_getSubstring(locationAddresses[i].data(), j) + 1]++;
+    }
+    for (size_t b = 0; b < bucketCount; b++) {
+      offsets[b + 1] += offsets[b];
+    }
+    AlignedBuffer<uint32_t> next(offsets);
+    for (size_t i = 0; i < this->getHardLocationCount(); i++) {
+      const WORD_TYPE key = _getSubstring(locationAddresses[i].data(), j);
+      locations[next[key]++] = i;
+    }
+
+    _bucketOffsets.push_back(std::move(offsets));
+    _bucketLocations.push_back(std::move(locations));
+  }
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+FLOAT MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getExpectedCost(size_t threshold) const {
+  const size_t radius = threshold / getSubstringCount();
+  FLOAT cost = 0;
+  for (size_t j = 0; j < getSubstringCount(); j++) {
+    const size_t width = _getSubstringBitCount(j);
+
+    // Number of substring values within radius: sum of C(width, k).
+    FLOAT probes = 0;
+    FLOAT combinations = 1;
+    for (size_t k = 0; k <= std::min(radius, width); k++) {
+      probes += combinations;
+      combinations = combinations * (width - k) / (k + 1);
+    }
+
+    cost += probes +
+            probes * this->getHardLocationCount() / std::exp2(width);
+  }
+  return cost;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getSubstringCount() const {
+  return _substringOffsets.size() - 1;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+const spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&
+MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getAddressRegister() const {
+  return _addressRegister;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::_activate(
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) const {
+  if (getExpectedCost(threshold) * SCAN_COST_RATIO >
+      this->getHardLocationCount()) {
+    _addressRegister->activate(
+      Span<const WORD_TYPE>(address, WORD_COUNT), threshold, activated);
+    return;
+  }
+
+  // Candidates: every location sharing a bucket with a substring value
+  // within radius of the query's, in any table.
+  const size_t radius = threshold / getSubstringCount();
+  activated->clear();
+  for (size_t j = 0; j < getSubstringCount(); j++) {
+    const size_t width = _getSubstringBitCount(j);
+    const WORD_TYPE query = _getSubstring(address, j);
+    const uint32_t* offsets = _bucketOffsets[j].data();
+    const LOCATION_INDEX_TYPE* locations = _bucketLocations[j].data();
+    auto probe = [&](WORD_TYPE key) {
+      activated->insert(activated->end(),
+                        locations + offsets[key],
+                        locations + offsets[key + 1]);
+    };
+
+    probe(query);
+    const WORD_TYPE limit = WORD_TYPE(1) << width;
+    for (size_t k = 1; k <= std::min(radius, width); k++) {
+      // Every width-bit mask with k bits set, in increasing order (Gosper).
+      for (WORD_TYPE mask = (WORD_TYPE(1) << k) - 1; mask < limit;) {
+        probe(query ^ mask);
+        const WORD_TYPE lowest = mask & (~mask + 1);
+        const WORD_TYPE ripple = mask + lowest;
+        mask = (((ripple ^ mask) >> 2) / lowest) | ripple;
+      }
+    }
+  }
+
+  std::sort(activated->begin(), activated->end());
+  activated->erase(std::unique(activated->begin(), activated->end()),
+                   activated->end());
+
+  // Verify the candidates in place.
+  const auto locationAddresses =
+    static_cast<const AddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&>(*_addressRegister)
+    .getLocationAddresses();
+  activated->erase(
+    std::remove_if(
+      activated->begin(), activated->end(),
+      [&](LOCATION_INDEX_TYPE location) {
+        return hammingDistance(locationAddresses[location].data(), address,
+                               WORD_COUNT) > threshold;
+      }),
+    activated->end());
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activateNearest(
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated,
+  Workspace* workspace) const {
+  _addressRegister->activateNearest(
+    Span<const WORD_TYPE>(address, WORD_COUNT), count, activated, workspace);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+WORD_TYPE MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getSubstring(const WORD_TYPE* address, size_t substring) const {
+  const size_t offset = _substringOffsets[substring];
+  const size_t width = _getSubstringBitCount(substring);
+  const size_t word = offset / WORD_BIT_SIZE;
+  const size_t shift = offset % WORD_BIT_SIZE;
+
+  WORD_TYPE bits = address[word] >> shift;
+  if (shift + width > WORD_BIT_SIZE) {
+    bits |= address[word + 1] << (WORD_BIT_SIZE - shift);
+  }
+  return bits & ((WORD_TYPE(1) << width) - 1);
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t MultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_getSubstringBitCount(size_t substring) const {
+  return _substringOffsets[substring + 1] - _substringOffsets[substring];
+}
+
+}  // namespace sdm
@@ -0,0 +1,130 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "./declares.h"
+#include "./AddressDecoder.h"
+#include "kernel/hamming.h"
+#include "utility/random.h"
+
+using std::array;
+using std::shared_ptr;
+
+namespace sdm {
+
+/*!\class ProceduralAddressRegister
+ * \brief Address register that never stores the hard location addresses.
+ *
+ * Each address is regenerated from (seed, index) by the counter-based
+ * generator of generateRandomRows, inside the activation kernel, so the
+ * register takes no memory whatever the number of hard locations, and an
+ * activation costs ALU work instead of memory bandwidth. Activates the same
+ * locations as an AddressRegister of the same seed and hard location count.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class ProceduralAddressRegister :
+  public AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> {
+ public:
+  using AddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT;
+  using AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::WORD_COUNT;
+
+  typedef array<WORD_TYPE, WORD_COUNT> LocationAddress;
+
+  /**
+   * @param seed Selects the addresses.
+   * @param hardLocationCount Number of hard locations.
+   * @throw std::invalid_argument if hardLocationCount is out of range.
+   */
+  explicit ProceduralAddressRegister(
+    uint64_t seed, size_t hardLocationCount = HARD_LOCATION_COUNT);
+
+  /**
+   * @param location Hard location index.
+   * @return The regenerated hard location address.
+   */
+  LocationAddress getLocationAddress(size_t location) const;
+
+  uint64_t getSeed() const;
+
+ protected:
+  void _activate(const WORD_TYPE* address,
+                 size_t threshold,
+                 activationList* activated) const override;
+
+ protected:
+  const uint64_t _seed;
+};
+
+/*!\typedef spProceduralAddressRegister
+ * \brief Wraps ProceduralAddressRegister in shared_ptr.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+using spProceduralAddressRegister =
+shared_ptr<ProceduralAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+ProceduralAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+ProceduralAddressRegister(uint64_t seed, size_t hardLocationCount) :
+  AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+    hardLocationCount),
+  _seed(seed) {
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+typename ProceduralAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::LocationAddress
+ProceduralAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getLocationAddress(size_t location) const {
+  LocationAddress address;
+  for (size_t w = 0; w < WORD_COUNT; w++) {
+    address[w] = counterRandomWord(_seed, location * WORD_COUNT + w);
+  }
+  address[WORD_COUNT - 1] &= lastWordMask(ADDRESS_BIT_COUNT);
+  return address;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+uint64_t
+ProceduralAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getSeed() const {
+  return _seed;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void ProceduralAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activate(
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) const {
+  activateProceduralLocations(_seed, this->getHardLocationCount(),
+                              ADDRESS_BIT_COUNT, address, threshold,
+                              activated);
+}
+
+}  // namespace sdm
@@ -19,58 +19,186 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <fstream>
+#include <vector>
 
 #include "./declares.h"
 #include "utility/utility.h"
+#include "./AddressDecoder.h"
 #include "./AddressRegister.h"
+#include "./MultiIndexHashing.h"
 #include "./UpDownCounters.h"
+#include "./Workspace.h"
 
 using std::shared_ptr;
+using std::vector;
 
 namespace sdm {
 
 /*!\class SDM
- * \brief The sdm module itself. Aggregates AddressRegister and UpDownCounter.
+ * \brief The sdm module itself. Aggregates an AddressDecoder, usually an
+ *        AddressRegister, and UpDownCounter.
  * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
  * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
  * \tparam DATA_BIT_COUNT Number of bits in the data to be saved.
  *                        Defaults to ADDRESS_BIT_COUNT as in Mr. Karneva's paper.
+ * \tparam COUNTER Counter type of the UpDownCounters.
  */
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT>
+  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
 class SDM {
  public:
   /**
    * SDM constructor.
-   * @param addressRegister AddressRegister to be aggregated.
+   * @param addressDecoder AddressRegister, or other AddressDecoder, to be
+   *                       aggregated.
    * @param upDownCounters UpDownCounters to be aggregated.
+   * @throw std::invalid_argument if addressDecoder and upDownCounters have
+   *        different numbers of hard locations.
    */
   SDM(
-    const spAddressRegister<
-      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressRegister,
+    const spAddressDecoder<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& addressDecoder,
     const spUpDownCounters<
-      DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& upDownCounters,
+      DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>& upDownCounters,
     size_t threshold);
 
+  virtual ~SDM() {}
+
   /**
    * Writes data to locations selected by address.
    * @param address
    * @param data
+   * @param workspace Scratch buffers to reuse, so the write does not
+   *                  allocate, or nullptr to allocate them.
    */
   void write(
     const bitset<ADDRESS_BIT_COUNT>& address,
-    const bitset<DATA_BIT_COUNT> &data);
+    const bitset<DATA_BIT_COUNT> &data,
+    Workspace* workspace = nullptr);
 
   /**
    * Reads data from locations selected by address
    * @param address
+   * @param workspace Scratch buffers to reuse, so the read does not
+   *                  allocate, or nullptr to allocate them.
    * @return data
    */
-  bitset<DATA_BIT_COUNT> read(const bitset<ADDRESS_BIT_COUNT>& address) const;
+  bitset<DATA_BIT_COUNT> read(const bitset<ADDRESS_BIT_COUNT>& address,
+                              Workspace* workspace = nullptr) const;
+
+  /**
+   * @return The aggregated AddressDecoder.
+   */
+  const spAddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&
+  getAddressDecoder() const;
+
+  /**
+   * @return The aggregated AddressRegister, nullptr if the AddressDecoder is
+   *         not an AddressRegister.
+   */
+  spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+  getAddressRegister() const;
+
+  /**
+   * Activates hard locations through an index instead of scanning the whole
+   * address register.
+   * @param index Index built over this SDM's address register, or nullptr to
+   *              go back to the scan.
+   * @throw std::invalid_argument if index is over another address register,
+   *        or this SDM does not aggregate an AddressRegister.
+   */
+  void setIndex(
+    const spMultiIndexHashing<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& index);
+
+  size_t getThreshold() const;
+
+  /**
+   * @param threshold Maximum hamming distance of an activated location.
+   */
+  void setThreshold(size_t threshold);
+
+  /**
+   * Sets the threshold to the one activating about activationFraction of
+   * the hard locations, see AddressRegister::calibrateThreshold. Meant to
+   * be called right after construction, before any write.
+   * @param activationFraction Target fraction of the hard locations an
+   *                           address activates, e.g. 0.001.
+   * @param queryCount Number of random addresses sampled.
+   * @return The new threshold.
+   * @throw std::invalid_argument if activationFraction is not within [0, 1],
+   *        or this SDM does not aggregate an AddressRegister.
+   */
+  size_t calibrateThreshold(
+    FLOAT activationFraction,
+    size_t queryCount = AddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::CALIBRATION_QUERY_COUNT);
+
+  /**
+   * Reorders the hard locations of the AddressRegister and the rows of the
+   * counters together, see AddressRegister::sortLocations. What the SDM
+   * stores is unchanged.
+   * @throw std::invalid_argument if this SDM does not aggregate an
+   *        AddressRegister, the register is shared, see
+   *        AddressRegister::share, or the SDM has an index, whose location
+   *        indices would go stale.
+   */
+  void sortLocations();
+
+  /**
+   * Switches between the two activation policies.
+   * @param activationCount Number of nearest hard locations each address
+   *                        activates, whatever their distance, so the cost
+   *                        of a read or write is the same for every address.
+   *                        0 goes back to activating the hard locations
+   *                        within the threshold.
+   * @throw std::invalid_argument if activationCount is above the number of
+   *        hard locations.
+   */
+  void setActivationCount(size_t activationCount);
+
+  size_t getActivationCount() const;
+
+  /**
+   * Writes each data to the locations selected by the corresponding address,
+   * in order. Activation is computed for the whole batch at once.
+   * @param addresses
+   * @param data Same size as addresses.
+   * @param workspace Scratch buffers to reuse, or nullptr to allocate them.
+   * @throw std::invalid_argument if the sizes differ.
+   */
+  void writeBatch(
+    Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+    Span<const bitset<DATA_BIT_COUNT>> data,
+    Workspace* workspace = nullptr);
+
+  /**
+   * Reads data from the locations selected by each address. Activation is
+   * computed for the whole batch at once, reading the address register once
+   * instead of once per address.
+   * @param addresses
+   * @return data, one per address.
+   */
+  vector<bitset<DATA_BIT_COUNT>> readBatch(
+    Span<const bitset<ADDRESS_BIT_COUNT>> addresses) const;
+
+  /**
+   * Same as readBatch, into caller storage.
+   * @param addresses
+   * @param data Output, same size as addresses.
+   * @param workspace Scratch buffers to reuse, or nullptr to allocate them.
+   * @throw std::invalid_argument if the sizes differ.
+   */
+  void readBatch(
+    Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+    Span<bitset<DATA_BIT_COUNT>> data,
+    Workspace* workspace = nullptr) const;
 
   /**
    * Serializing Up/Down counter. Useful for debugging.
@@ -81,122 +209,412 @@ class SDM {
   friend std::ostream& operator<<(
     std::ostream& os,
     const SDM<
-      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT>& sdm) {
+      ADDRESS_BIT_COUNT,
+      HARD_LOCATION_BIT_COUNT,
+      DATA_BIT_COUNT,
+      COUNTER>& sdm) {
     os << (*sdm._upDownCounters);
     return os;
   }
 
  protected:
   /**
-   * Returns an array of boolean corresponding to each address. True if
-   * to update the counter, false otherwise.
+   * Acquires the hard locations to update/read for an address.
    * @param address
-   * @return Update flags.
+   * @param workspace Scratch buffers. The activated hard locations are left
+   *                  in workspace->activated.
    */
-  array<
-    bool,
-    UpDownCounters<
-      DATA_BIT_COUNT,
-      HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT> _getUpdateFlags(
-    const bitset<ADDRESS_BIT_COUNT>& address) const;
+  void _getActivatedLocations(
+    const bitset<ADDRESS_BIT_COUNT>& address,
+    Workspace* workspace) const;
+
+  /**
+   * Acquires the hard locations to update/read for several addresses.
+   * @param addresses
+   * @param workspace Scratch buffers. The activated hard locations of each
+   *                  address are left in workspace->batchActivated.
+   */
+  void _getActivatedLocations(
+    Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+    Workspace* workspace) const;
+
+  /**
+   * Moves the counter rows along with the sorted hard locations.
+   * @param permutation See AddressRegister::sortLocations.
+   */
+  virtual void _permuteLocations(Span<const size_t> permutation);
 
  protected:
-  spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
-    _addressRegister;
-  spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+  spAddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+    _addressDecoder;
+  spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>
     _upDownCounters;
-  const size_t _threshold;
+  spMultiIndexHashing<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> _index;
+  size_t _threshold;
+
+  /**
+   * Number of nearest hard locations to activate, 0 to use _threshold.
+   */
+  size_t _activationCount;
 };
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT>
+  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
 using spSDM =
-shared_ptr<SDM<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT>>;
+shared_ptr<SDM<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER>>;
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT>
-SDM<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT>::SDM(
-  const spAddressRegister<
-    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> &addressRegister,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+SDM<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT, DATA_BIT_COUNT, COUNTER>::SDM(
+  const spAddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> &addressDecoder,
   const spUpDownCounters<
-    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT> &upDownCounters,
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER> &upDownCounters,
   size_t threshold) :
-  _addressRegister(addressRegister),
+  _addressDecoder(addressDecoder),
   _upDownCounters(upDownCounters),
-  _threshold(threshold) {
+  _threshold(threshold),
+  _activationCount(0) {
+  if (addressDecoder->getHardLocationCount() !=
+      upDownCounters->getHardLocationCount()) {
+    throw std::invalid_argument(
+      "Address decoder and counters must have as many hard locations.");
+  }
 }
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT>
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
 void SDM<
   ADDRESS_BIT_COUNT,
   HARD_LOCATION_BIT_COUNT,
-  DATA_BIT_COUNT>::write(
+  DATA_BIT_COUNT,
+  COUNTER>::write(
   const bitset<ADDRESS_BIT_COUNT> &address,
-  const bitset<DATA_BIT_COUNT> &data) {
-  auto hammingDistances =
-    _addressRegister->getHammingDistanceArray(address);
-  auto updateFlags = _getUpdateFlags(address);
-  _upDownCounters->write(updateFlags, data);
+  const bitset<DATA_BIT_COUNT> &data,
+  Workspace* workspace) {
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  _getActivatedLocations(address, workspace);
+  _upDownCounters->write(workspace->activated, data);
 }
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT>
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
 bitset<DATA_BIT_COUNT>
 SDM<
   ADDRESS_BIT_COUNT,
   HARD_LOCATION_BIT_COUNT,
-  DATA_BIT_COUNT>::read(const bitset<ADDRESS_BIT_COUNT> &address) const {
-  auto updateFlags = _getUpdateFlags(address);
-  return _upDownCounters->read(updateFlags);
+  DATA_BIT_COUNT,
+  COUNTER>::read(
+  const bitset<ADDRESS_BIT_COUNT> &address,
+  Workspace* workspace) const {
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  _getActivatedLocations(address, workspace);
+  return _upDownCounters->read(workspace->activated);
 }
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT>
-array<
-  bool,
-  UpDownCounters<
-    DATA_BIT_COUNT,
-    HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::writeBatch(
+  Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+  Span<const bitset<DATA_BIT_COUNT>> data,
+  Workspace* workspace) {
+  if (addresses.size() != data.size()) {
+    throw std::invalid_argument("One data per address is required.");
+  }
+
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  _getActivatedLocations(addresses, workspace);
+  for (size_t i = 0; i < addresses.size(); i++) {
+    _upDownCounters->write(workspace->batchActivated[i], data[i]);
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+vector<bitset<DATA_BIT_COUNT>>
 SDM<
   ADDRESS_BIT_COUNT,
   HARD_LOCATION_BIT_COUNT,
-  DATA_BIT_COUNT>::_getUpdateFlags(
-  const bitset<ADDRESS_BIT_COUNT> &address) const {
-  auto hammingDistances =
-    _addressRegister->getHammingDistanceArray(address);
+  DATA_BIT_COUNT,
+  COUNTER>::readBatch(
+  Span<const bitset<ADDRESS_BIT_COUNT>> addresses) const {
+  vector<bitset<DATA_BIT_COUNT>> data(addresses.size());
+  readBatch(addresses, data);
+  return data;
+}
 
-  array<
-    bool,
-    UpDownCounters<
-      DATA_BIT_COUNT,
-      HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT> updateFlags;
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::readBatch(
+  Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+  Span<bitset<DATA_BIT_COUNT>> data,
+  Workspace* workspace) const {
+  if (addresses.size() != data.size()) {
+    throw std::invalid_argument("One data per address is required.");
+  }
 
-  for (size_t i = 0; i < hammingDistances.size(); i++) {
-    updateFlags[i] = hammingDistances[i] <= _threshold;
+  Workspace localWorkspace;
+  workspace = workspace ? workspace : &localWorkspace;
+  _getActivatedLocations(addresses, workspace);
+  for (size_t i = 0; i < addresses.size(); i++) {
+    data[i] = _upDownCounters->read(workspace->batchActivated[i]);
   }
+}
 
-  return updateFlags;
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_getActivatedLocations(
+  const bitset<ADDRESS_BIT_COUNT> &address,
+  Workspace* workspace) const {
+  activationList* activated = &workspace->activated;
+  if (_activationCount > 0) {
+    _addressDecoder->activateNearest(address, _activationCount, activated,
+                                     workspace);
+  } else if (_index) {
+    _index->activate(address, _threshold, activated);
+  } else {
+    _addressDecoder->activate(address, _threshold, activated);
+  }
 }
 
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT>
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_getActivatedLocations(
+  Span<const bitset<ADDRESS_BIT_COUNT>> addresses,
+  Workspace* workspace) const {
+  vector<activationList>* activated = &workspace->batchActivated;
+  if (_activationCount > 0) {
+    activated->resize(addresses.size());
+    for (size_t i = 0; i < addresses.size(); i++) {
+      _addressDecoder->activateNearest(addresses[i], _activationCount,
+                                       &(*activated)[i], workspace);
+    }
+  } else if (_index) {
+    _index->activateBatch(addresses, _threshold, activated, workspace);
+  } else {
+    _addressDecoder->activateBatch(addresses, _threshold, activated,
+                                   workspace);
+  }
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+const spAddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>&
+SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getAddressDecoder() const {
+  return _addressDecoder;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getAddressRegister() const {
+  return std::dynamic_pointer_cast<
+    AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>(
+      _addressDecoder);
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::setIndex(
+  const spMultiIndexHashing<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& index) {
+  if (index && index->getAddressRegister() != getAddressRegister()) {
+    throw std::invalid_argument(
+      "Index must be built over the SDM's address register.");
+  }
+  _index = index;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+size_t SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getThreshold() const {
+  return _threshold;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::setThreshold(size_t threshold) {
+  _threshold = threshold;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+size_t SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::calibrateThreshold(
+  FLOAT activationFraction, size_t queryCount) {
+  auto addressRegister = getAddressRegister();
+  if (!addressRegister) {
+    throw std::invalid_argument(
+      "Calibration needs the SDM to aggregate an AddressRegister.");
+  }
+  _threshold =
+    addressRegister->calibrateThreshold(activationFraction, queryCount);
+  return _threshold;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::sortLocations() {
+  auto addressRegister = getAddressRegister();
+  if (!addressRegister) {
+    throw std::invalid_argument(
+      "Sorting needs the SDM to aggregate an AddressRegister.");
+  }
+  if (_index) {
+    throw std::invalid_argument("Cannot sort the locations of an index.");
+  }
+  // Throws before anything moves if the register is shared.
+  _permuteLocations(addressRegister->sortLocations());
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::_permuteLocations(Span<const size_t> permutation) {
+  _upDownCounters->permuteLocations(permutation);
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+void SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::setActivationCount(size_t activationCount) {
+  if (activationCount > _addressDecoder->getHardLocationCount()) {
+    throw std::invalid_argument(
+      "Cannot activate more than the number of hard locations.");
+  }
+  _activationCount = activationCount;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
+size_t SDM<
+  ADDRESS_BIT_COUNT,
+  HARD_LOCATION_BIT_COUNT,
+  DATA_BIT_COUNT,
+  COUNTER>::getActivationCount() const {
+  return _activationCount;
+}
+
+template <
+  size_t ADDRESS_BIT_COUNT,
+  size_t HARD_LOCATION_BIT_COUNT,
+  size_t DATA_BIT_COUNT,
+  typename COUNTER>
 void
 SDM<ADDRESS_BIT_COUNT,
     HARD_LOCATION_BIT_COUNT,
-    DATA_BIT_COUNT>::serialize(
+    DATA_BIT_COUNT,
+    COUNTER>::serialize(
   const std::string& filePath) const {
   std::ofstream file(filePath);
   if (file.is_open()) {
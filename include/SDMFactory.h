@@ -23,48 +23,88 @@
 #include "./utility/FactoryAbstract.h"
 #include "./declares.h"
 #include "AddressRegister.h"
-#include "AddressRegisterFactory.h"
 #include "SDM.h"
+#include "SharedAddressRegisterFactory.h"
 #include "UpDownCounters.h"
+#include "UpDownCountersFactory.h"
 
 using std::shared_ptr;
 
 namespace sdm {
 
 /*!\class SDMFactory
- * \brief Factory for sdm.
+ * \brief Factory for sdm. SDMs of the same dimensions and seed share one
+ *        address register, see SharedAddressRegisterFactory.
  * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
  * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
  * \tparam DATA_BIT_COUNT Number of bits in the data to be saved.
  *                        Defaults to ADDRESS_BIT_COUNT as in Mr. Karneva's paper.
+ * \tparam COUNTER Counter type, see UpDownCounters.
  */
 template <
   size_t ADDRESS_BIT_COUNT,
   size_t HARD_LOCATION_BIT_COUNT,
-  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT>
+  size_t DATA_BIT_COUNT = ADDRESS_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
 class SDMFactory :
   public FactoryAbstract<
     SDM<
       ADDRESS_BIT_COUNT,
       HARD_LOCATION_BIT_COUNT,
-      DATA_BIT_COUNT>>{
+      DATA_BIT_COUNT,
+      COUNTER>>{
  public:
   explicit SDMFactory(size_t threshold, FLOAT commonRatio = 0.01F) {
     auto addressRegister =
-      sdm::AddressRegisterFactory<
+      sdm::SharedAddressRegisterFactory<
         ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>().get();
     auto upDownCounters =
       sdm::UpDownCountersFactory<
-        DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(commonRatio).get();
+        DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>(commonRatio).get();
     this->_instance =
       spSDM<
         ADDRESS_BIT_COUNT,
         HARD_LOCATION_BIT_COUNT,
-        DATA_BIT_COUNT>(
+        DATA_BIT_COUNT,
+        COUNTER>(
         new SDM<
           ADDRESS_BIT_COUNT,
           HARD_LOCATION_BIT_COUNT,
-          DATA_BIT_COUNT>(addressRegister, upDownCounters, threshold));
+          DATA_BIT_COUNT,
+          COUNTER>(addressRegister, upDownCounters, threshold));
+  }
+
+  /**
+   * Builds an sdm of any number of hard locations, with a seeded address
+   * register.
+   * @param threshold Maximum hamming distance of an activated location.
+   * @param commonRatio
+   * @param hardLocationCount Number of hard locations.
+   * @param seed Selects the hard location addresses.
+   */
+  SDMFactory(size_t threshold,
+             FLOAT commonRatio,
+             size_t hardLocationCount,
+             uint64_t seed = 0) {
+    auto addressRegister =
+      sdm::SharedAddressRegisterFactory<
+        ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+          seed, hardLocationCount).get();
+    auto upDownCounters =
+      sdm::UpDownCountersFactory<
+        DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>(
+          commonRatio, hardLocationCount).get();
+    this->_instance =
+      spSDM<
+        ADDRESS_BIT_COUNT,
+        HARD_LOCATION_BIT_COUNT,
+        DATA_BIT_COUNT,
+        COUNTER>(
+        new SDM<
+          ADDRESS_BIT_COUNT,
+          HARD_LOCATION_BIT_COUNT,
+          DATA_BIT_COUNT,
+          COUNTER>(addressRegister, upDownCounters, threshold));
   }
 };
 
@@ -0,0 +1,189 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "./declares.h"
+#include "./AddressDecoder.h"
+#include "kernel/hamming.h"
+#include "utility/random.h"
+
+using std::shared_ptr;
+using std::vector;
+
+namespace sdm {
+
+/*!\class SelectedCoordinateAddressRegister
+ * \brief Jaeckel's selected-coordinate design: each hard location is
+ *        defined by a few (bit index, required value) pairs instead of a
+ *        full random address.
+ *
+ * The distance of an address to a location is the number of its selected
+ * bits that differ from the required values, so threshold 0 activates the
+ * locations whose selected bits all match, about a 2^-k fraction of them
+ * for k selected bits. An activation costs k bit tests per location
+ * instead of a full-width Hamming distance, and a location takes 2k bytes
+ * instead of ADDRESS_BIT_COUNT bits.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class SelectedCoordinateAddressRegister :
+  public AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT> {
+ public:
+  using AddressDecoder<
+    ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT;
+
+  static_assert(ADDRESS_BIT_COUNT <= 32768,
+                "A coordinate packs a 15 bit index and a value bit.");
+
+  /**
+   * Number of selected bits per location unless another is given to the
+   * constructor: 10, as in Jaeckel's design, or the address width if
+   * smaller.
+   */
+  static constexpr size_t DEFAULT_SELECTED_BIT_COUNT =
+    ADDRESS_BIT_COUNT < 10 ? ADDRESS_BIT_COUNT : 10;
+
+  /**
+   * @param seed Selects the bits and their required values.
+   * @param selectedBitCount Number of distinct bits selected per location.
+   * @param hardLocationCount Number of hard locations.
+   * @throw std::invalid_argument if selectedBitCount is 0 or more than
+   *        ADDRESS_BIT_COUNT, or if hardLocationCount is out of range.
+   */
+  explicit SelectedCoordinateAddressRegister(
+    uint64_t seed,
+    size_t selectedBitCount = DEFAULT_SELECTED_BIT_COUNT,
+    size_t hardLocationCount = HARD_LOCATION_COUNT);
+
+  size_t getSelectedBitCount() const;
+
+  /**
+   * @param location Hard location index.
+   * @param j Selected bit, less than getSelectedBitCount().
+   * @return Index of the j-th address bit selected by location.
+   */
+  size_t getSelectedBit(size_t location, size_t j) const;
+
+  /**
+   * @param location Hard location index.
+   * @param j Selected bit, less than getSelectedBitCount().
+   * @return Value location requires of its j-th selected bit.
+   */
+  bool getRequiredValue(size_t location, size_t j) const;
+
+ protected:
+  void _activate(const WORD_TYPE* address,
+                 size_t threshold,
+                 activationList* activated) const override;
+
+ protected:
+  const size_t _selectedBitCount;
+
+  /**
+   * getHardLocationCount() x _selectedBitCount coordinates, each the bit
+   * index shifted left by one with the required value in the low bit.
+   */
+  vector<uint16_t> _coordinates;
+};
+
+/*!\typedef spSelectedCoordinateAddressRegister
+ * \brief Wraps SelectedCoordinateAddressRegister in shared_ptr.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+using spSelectedCoordinateAddressRegister =
+shared_ptr<SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+SelectedCoordinateAddressRegister(
+  uint64_t seed,
+  size_t selectedBitCount,
+  size_t hardLocationCount) :
+  AddressDecoder<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+    hardLocationCount),
+  _selectedBitCount(selectedBitCount) {
+  if (selectedBitCount == 0 || selectedBitCount > ADDRESS_BIT_COUNT) {
+    throw std::invalid_argument("Selected bit count out of range.");
+  }
+
+  _coordinates.resize(hardLocationCount * selectedBitCount);
+  uint64_t counter = 0;
+  for (size_t i = 0; i < hardLocationCount; i++) {
+    uint16_t* location = _coordinates.data() + i * selectedBitCount;
+    for (size_t j = 0; j < selectedBitCount; j++) {
+      // Rejection keeps the bits of a location distinct, and uniform.
+      bool distinct;
+      do {
+        const WORD_TYPE word = counterRandomWord(seed, counter++);
+        location[j] = static_cast<uint16_t>(
+          (word >> 1) % ADDRESS_BIT_COUNT << 1 | (word & 1));
+        distinct = true;
+        for (size_t k = 0; k < j; k++) {
+          distinct &= (location[k] >> 1) != (location[j] >> 1);
+        }
+      } while (!distinct);
+    }
+  }
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::getSelectedBitCount() const {
+  return _selectedBitCount;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+size_t SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getSelectedBit(size_t location, size_t j) const {
+  return _coordinates[location * _selectedBitCount + j] >> 1;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+bool SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+getRequiredValue(size_t location, size_t j) const {
+  return _coordinates[location * _selectedBitCount + j] & 1;
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+void SelectedCoordinateAddressRegister<
+  ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_activate(
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) const {
+  activateSelectedCoordinates(_coordinates.data(),
+                              this->getHardLocationCount(), _selectedBitCount,
+                              ADDRESS_BIT_COUNT, address, threshold,
+                              activated);
+}
+
+}  // namespace sdm
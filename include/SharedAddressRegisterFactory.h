@@ -0,0 +1,131 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include<cstdint>
+#include<iterator>
+#include<map>
+#include<memory>
+#include<mutex>
+#include<tuple>
+
+#include "./utility/FactoryAbstract.h"
+#include "AddressRegister.h"
+
+using std::shared_ptr;
+
+namespace sdm {
+
+/*!\class SharedAddressRegisterFactory
+ * \brief Factory method for an addressRegister shared by every caller
+ *        asking for the same one.
+ *
+ * Registers of the same dimensions, seed and hard location count hold the
+ * same addresses, so one instance is interned per (dimensions, seed, hard
+ * location count) and handed to every caller while any of them still holds
+ * it. Hundreds of SDMs then cost the address memory of one. The register
+ * is shared before it is handed out, see AddressRegister::share, so
+ * reordering or writing its addresses throws.
+ * \tparam ADDRESS_BIT_COUNT The bit count of the address data.
+ * \tparam HARD_LOCATION_BIT_COUNT Hard location bit count.
+ */
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+class SharedAddressRegisterFactory :
+  public FactoryAbstract<
+    AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>> {
+ public:
+  /**
+   * Shares the register of AddressRegister's no-arg constructor.
+   */
+  SharedAddressRegisterFactory();
+
+  /**
+   * Shares the register of AddressRegister(seed, 0, hardLocationCount).
+   * @param seed Selects the addresses.
+   * @param hardLocationCount Number of hard locations.
+   */
+  explicit SharedAddressRegisterFactory(
+    uint64_t seed,
+    size_t hardLocationCount =
+      AddressRegister<
+        ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT);
+
+ protected:
+  /**
+   * Whether the register is seeded, its seed and its hard location count.
+   */
+  typedef std::tuple<bool, uint64_t, size_t> Key;
+
+  /**
+   * @param key Identifies the register.
+   * @param make Builds the register if none is alive for key.
+   * @return The live register for key.
+   */
+  template<typename MAKE>
+  static spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+  _intern(const Key& key, MAKE make);
+};
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+SharedAddressRegisterFactory<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+SharedAddressRegisterFactory() {
+  this->_instance = _intern(
+    Key(false, 0, AddressRegister<
+      ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT),
+    []() {
+      return new AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>;
+    });
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+SharedAddressRegisterFactory<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+SharedAddressRegisterFactory(uint64_t seed, size_t hardLocationCount) {
+  this->_instance = _intern(
+    Key(true, seed, hardLocationCount),
+    [seed, hardLocationCount]() {
+      return new AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
+        seed, 0, hardLocationCount);
+    });
+}
+
+template<size_t ADDRESS_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+template<typename MAKE>
+spAddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>
+SharedAddressRegisterFactory<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::
+_intern(const Key& key, MAKE make) {
+  // Weak references, so a register is freed with its last user.
+  static std::map<Key, std::weak_ptr<
+    AddressRegister<ADDRESS_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>> registers;
+  static std::mutex mutex;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = registers.begin(); it != registers.end();) {
+    it = it->second.expired() ? registers.erase(it) : std::next(it);
+  }
+  auto addressRegister = registers[key].lock();
+  if (!addressRegister) {
+    addressRegister.reset(make());
+    addressRegister->share();
+    registers[key] = addressRegister;
+  }
+  return addressRegister;
+}
+
+}  // namespace sdm
@@ -24,68 +24,161 @@
 #include <memory>
 #include <iostream>
 #include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "./declares.h"
+#include "./UpDownCountersBase.h"
+#include "kernel/counters.h"
 #include "utility/utility.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
 
 using std::array;
 using std::bitset;
 using std::shared_ptr;
+using std::vector;
 
 namespace sdm {
 
+/*! \typedef COUNTER_TYPE
+ *  \brief Default counter, and the widest type counters are summed in on a
+ *         read.
+ */
 using COUNTER_TYPE = int64_t;
 
 /*!\class UpDownCounters
  * \brief Updown counters for sdm.
+ *
+ * The counters are one contiguous grid of getHardLocationCount() rows of
+ * DATA_BIT_COUNT counters. Each row starts on a cache line, its stride
+ * padded to whole cache lines, so a row never shares a line with its
+ * neighbours. The grid is backed by transparent huge pages unless asked
+ * otherwise.
+ *
+ * The counters saturate at the bounds of their type, so a narrow counter
+ * such as int8_t, which takes an eighth of the memory and bandwidth of the
+ * default, stays at its bound instead of wrapping around when a hard
+ * location is written more often than it can count. A read sums the
+ * counters in the narrowest type that cannot overflow, at most
+ * COUNTER_TYPE.
  * \tparam DATA_BIT_COUNT Bit count of the data to be saved/retrieved.
- * \tparam HARD_LOCATION_BIT_COUNT Bit count of the hard location.
+ * \tparam HARD_LOCATION_BIT_COUNT Bit count of the hard location. Only sets
+ *                                 the default number of hard locations.
+ * \tparam COUNTER Signed integer type of a counter.
  */
 template <
   size_t DATA_BIT_COUNT,
-  size_t HARD_LOCATION_BIT_COUNT>
-class UpDownCounters {
+  size_t HARD_LOCATION_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
+class UpDownCounters :
+  public UpDownCountersBase<
+    UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>,
+    CounterGridRow<COUNTER, DATA_BIT_COUNT>,
+    DATA_BIT_COUNT> {
+  static_assert(std::is_integral<COUNTER>::value &&
+                std::is_signed<COUNTER>::value,
+                "Counters must be signed integers.");
+  static_assert(sizeof(COUNTER) <= sizeof(COUNTER_TYPE),
+                "Counters must be summed without overflow.");
+
  public:
+  /**
+   * Number of hard locations unless another is given to the constructor.
+   */
   static constexpr size_t HARD_LOCATION_COUNT =
     std::exp2(HARD_LOCATION_BIT_COUNT);
 
   /**
-   * No-arg constructor.
+   * A row of counters, one per data bit, padded to whole cache lines.
    */
-  explicit UpDownCounters(FLOAT geometricRatio);
+  typedef CounterGridRow<COUNTER, DATA_BIT_COUNT> CounterRow;
 
   /**
-   * Input the bits given an array of hamming distance.
-   * @param updateFlags Array of boolean indicating whether to update.
+   * Distance in counters between the start of two rows.
+   */
+  static constexpr size_t ROW_STRIDE = sizeof(CounterRow) / sizeof(COUNTER);
+
+  /**
+   * @param geometricRatio
+   * @param hardLocationCount Number of hard locations, need not be a power
+   *                          of two.
+   * @param hugePages false to keep the grid off transparent huge pages.
+   * @throw std::invalid_argument if hardLocationCount is 0 or the indices
+   *        do not fit in LOCATION_INDEX_TYPE.
+   */
+  explicit UpDownCounters(FLOAT geometricRatio,
+                          size_t hardLocationCount = HARD_LOCATION_COUNT,
+                          bool hugePages = true);
+
+  // The update flag overloads.
+  using UpDownCountersBase<
+    UpDownCounters, CounterRow, DATA_BIT_COUNT>::write;
+  using UpDownCountersBase<
+    UpDownCounters, CounterRow, DATA_BIT_COUNT>::read;
+
+  /**
+   * Input the bits to the activated hard locations only. The bits are
+   * expanded once and added to every row with vector adds, see
+   * writeCounterRows.
+   * @param activated Indices of the hard locations to update.
    * @param bits Input bits.
+   * @throw std::invalid_argument if an index is not that of a hard location.
    */
-  void write(const array<bool, HARD_LOCATION_COUNT>& updateFlags,
+  void write(Span<const LOCATION_INDEX_TYPE> activated,
              const bitset<DATA_BIT_COUNT>& bits);
 
   /**
-   * Output the bits given an array of hamming distance.
-   * @param updateFlags Array of boolean indicating whether to update.
+   * Output the bits summed over the activated hard locations only. The rows
+   * are summed in place with vector adds, see readCounterRows.
+   * @param activated Indices of the hard locations to read.
    * @return The output.
+   * @throw std::invalid_argument if an index is not that of a hard location.
    */
-  bitset<DATA_BIT_COUNT> read(
-    const array<bool, HARD_LOCATION_COUNT>& updateFlags) const;
+  bitset<DATA_BIT_COUNT> read(Span<const LOCATION_INDEX_TYPE> activated) const;
 
   /**
-   * @return Counter grid.
+   * Input the bits to the activated hard locations, each with a weight: its
+   * counters move by the weight instead of 1, saturating.
+   * @param activated Indices of the hard locations to update.
+   * @param weights Weight of each activated hard location.
+   * @param bits Input bits.
+   * @throw std::invalid_argument if there is not one weight per activated
+   *        hard location, a weight is the minimum of COUNTER, or an index is
+   *        not that of a hard location.
    */
-  const array<
-    array<
-      COUNTER_TYPE, DATA_BIT_COUNT>, HARD_LOCATION_COUNT>& getCounters() const;
+  void write(Span<const LOCATION_INDEX_TYPE> activated,
+             Span<const COUNTER> weights,
+             const bitset<DATA_BIT_COUNT>& bits);
 
- protected:
-  void _writeRow(const bitset<DATA_BIT_COUNT>& bits, size_t row);
+  /**
+   * Output the bits summed over the activated hard locations, each counter
+   * multiplied by the weight of its hard location. Sums too large for
+   * int64_t saturate, see readCounterRows.
+   * @param activated Indices of the hard locations to read.
+   * @param weights Weight of each activated hard location.
+   * @return The output.
+   * @throw std::invalid_argument if there is not one weight per activated
+   *        hard location, or an index is not that of a hard location.
+   */
+  bitset<DATA_BIT_COUNT> read(Span<const LOCATION_INDEX_TYPE> activated,
+                              Span<const COUNTER> weights) const;
 
-  array<COUNTER_TYPE, DATA_BIT_COUNT> _readRow(size_t row) const;
+  /**
+   * @return Counter grid, one row per hard location, ROW_STRIDE apart.
+   */
+  MatrixSpan<const COUNTER> getCounters() const;
 
  protected:
-  FLOAT _geometricRatio;
-  array<
-    array<COUNTER_TYPE, DATA_BIT_COUNT>, HARD_LOCATION_COUNT> _upDownCounters;
+  /**
+   * @throw std::invalid_argument if there is not one weight per activated
+   *        hard location.
+   */
+  static void _checkWeights(Span<const LOCATION_INDEX_TYPE> activated,
+                            Span<const COUNTER> weights);
 };
 
 /*!\typedef spUpDownCounters
@@ -95,101 +188,123 @@ class UpDownCounters {
  */
 template <
   size_t DATA_BIT_COUNT,
-  size_t HARD_LOCATION_BIT_COUNT>
+  size_t HARD_LOCATION_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
 using spUpDownCounters =
-shared_ptr<UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>>;
-
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::UpDownCounters(
-  FLOAT geometricRatio) :
-  _geometricRatio(geometricRatio) {
-  for (array<COUNTER_TYPE, DATA_BIT_COUNT>& udc : _upDownCounters) {
-    udc.fill(0);
-  }
+shared_ptr<UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>>;
+
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::
+UpDownCounters(
+  FLOAT geometricRatio, size_t hardLocationCount, bool hugePages) :
+  UpDownCountersBase<UpDownCounters, CounterRow, DATA_BIT_COUNT>(
+    geometricRatio, hardLocationCount, hugePages) {
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-void UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::write(
-  const array<
-    bool,
-    UpDownCounters<
-      DATA_BIT_COUNT,
-      HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>& updateFlags,
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+void UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::write(
+  Span<const LOCATION_INDEX_TYPE> activated,
   const bitset<DATA_BIT_COUNT> &bits) {
-  for (size_t i = 0; i < updateFlags.size(); i++) {
-    if (updateFlags[i]) {
-      this->_writeRow(bits, i);
-    }
-  }
+  this->_checkActivated(activated);
+  array<WORD_TYPE, wordCount(DATA_BIT_COUNT)> words;
+  bitsetToWords(bits, words.data());
+  writeCounterRows(
+    reinterpret_cast<COUNTER*>(this->_upDownCounters.data()), ROW_STRIDE,
+    activated.data(), activated.size(), words.data(), DATA_BIT_COUNT);
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
 bitset<DATA_BIT_COUNT>
-UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::read(
-  const array<
-    bool,
-    UpDownCounters<
-      DATA_BIT_COUNT,
-      HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>& updateFlags) const {
-  array<COUNTER_TYPE , DATA_BIT_COUNT> sumArray;
-  sumArray.fill(0);
-  for (size_t i = 0; i < updateFlags.size(); i++) {
-    if (updateFlags[i]) {
-      sumArray = this->_readRow(i) + sumArray;
-    }
-  }
-
-  bitset<DATA_BIT_COUNT> bits;
-  for (size_t i = 0; i < sumArray.size(); i++) {
-    bits[i] = sumArray[i] > 0 ? 1 : 0;
-  }
-
-  return bits;
+UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::read(
+  Span<const LOCATION_INDEX_TYPE> activated) const {
+  this->_checkActivated(activated);
+  array<WORD_TYPE, wordCount(DATA_BIT_COUNT)> words;
+  readCounterRows(
+    reinterpret_cast<const COUNTER*>(this->_upDownCounters.data()),
+    ROW_STRIDE, activated.data(), activated.size(), DATA_BIT_COUNT,
+    words.data());
+  return wordsToBitset<DATA_BIT_COUNT>(words.data());
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-void UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::_writeRow(
-  const bitset<DATA_BIT_COUNT>& bits,
-  size_t row) {
-  array<
-    COUNTER_TYPE, DATA_BIT_COUNT>& rowUpDownCounters = _upDownCounters.at(row);
-  for (size_t i = 0; i < bits.size(); i++) {
-    COUNTER_TYPE direction = bits[i] ? 1 : -1;
-    rowUpDownCounters.at(i) += direction;
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+void UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::write(
+  Span<const LOCATION_INDEX_TYPE> activated,
+  Span<const COUNTER> weights,
+  const bitset<DATA_BIT_COUNT> &bits) {
+  this->_checkActivated(activated);
+  _checkWeights(activated, weights);
+  for (COUNTER weight : weights) {
+    if (weight == std::numeric_limits<COUNTER>::min()) {
+      throw std::invalid_argument("A weight cannot be negated.");
+    }
   }
+  array<WORD_TYPE, wordCount(DATA_BIT_COUNT)> words;
+  bitsetToWords(bits, words.data());
+  writeCounterRows(
+    reinterpret_cast<COUNTER*>(this->_upDownCounters.data()), ROW_STRIDE,
+    activated.data(), weights.data(), activated.size(), words.data(),
+    DATA_BIT_COUNT);
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-array<COUNTER_TYPE , DATA_BIT_COUNT>
-UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::_readRow(
-  size_t row) const {
-  array<COUNTER_TYPE, DATA_BIT_COUNT> sumArray;
-  sumArray.fill(0);
-  auto rowUpDownCounters = _upDownCounters.at(row);
-  for (size_t i = 0; i < rowUpDownCounters.size(); i++) {
-    sumArray.at(i) = rowUpDownCounters.at(i);
-  }
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+bitset<DATA_BIT_COUNT>
+UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::read(
+  Span<const LOCATION_INDEX_TYPE> activated,
+  Span<const COUNTER> weights) const {
+  this->_checkActivated(activated);
+  _checkWeights(activated, weights);
+  array<WORD_TYPE, wordCount(DATA_BIT_COUNT)> words;
+  readCounterRows(
+    reinterpret_cast<const COUNTER*>(this->_upDownCounters.data()),
+    ROW_STRIDE, activated.data(), weights.data(), activated.size(),
+    DATA_BIT_COUNT, words.data());
+  return wordsToBitset<DATA_BIT_COUNT>(words.data());
+}
 
-  return sumArray;
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+MatrixSpan<const COUNTER>
+UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::
+getCounters() const {
+  return MatrixSpan<const COUNTER>(
+    this->_upDownCounters[0].data(), this->getHardLocationCount(),
+    DATA_BIT_COUNT,
+    ROW_STRIDE);
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
-const array<
-  array<COUNTER_TYPE, DATA_BIT_COUNT>,
-  UpDownCounters<
-    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT>&
-UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::getCounters() const {
-  return _upDownCounters;
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
+void UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>::
+_checkWeights(Span<const LOCATION_INDEX_TYPE> activated,
+              Span<const COUNTER> weights) {
+  if (weights.size() != activated.size()) {
+    throw std::invalid_argument("One weight per activated hard location.");
+  }
 }
 
-template <size_t DATA_BIT_COUNT, size_t HARD_LOCATION_BIT_COUNT>
+template <size_t DATA_BIT_COUNT,
+          size_t HARD_LOCATION_BIT_COUNT,
+          typename COUNTER>
 std::ostream& operator<<(
   std::ostream& os,
   const UpDownCounters<
-    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>& upDownCounters) {
-  for (auto row : upDownCounters.getCounters()) {
-    for (auto col : row) {
-      os << col << " ";
+    DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>& upDownCounters) {
+  auto counters = upDownCounters.getCounters();
+  for (size_t row = 0; row < counters.size(); row++) {
+    for (auto col : counters[row]) {
+      os << static_cast<COUNTER_TYPE>(col) << " ";
     }
     os << std::endl;
   }
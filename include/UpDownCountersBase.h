@@ -0,0 +1,217 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "./declares.h"
+#include "utility/AlignedBuffer.h"
+#include "utility/Span.h"
+
+using std::array;
+using std::bitset;
+using std::vector;
+
+namespace sdm {
+
+/*!\struct CounterGridRow
+ * \brief A row of the counter grid, padded to whole cache lines so a row
+ *        never shares a line with its neighbours.
+ * \tparam ELEMENT Counter, or word of bit-planes.
+ * \tparam ELEMENT_COUNT Number of elements in the row.
+ */
+template<typename ELEMENT, size_t ELEMENT_COUNT>
+struct alignas(CACHE_LINE_SIZE) CounterGridRow :
+  public array<ELEMENT, ELEMENT_COUNT> {
+};
+
+/*!\class UpDownCountersBase
+ * \brief The grid of counter rows shared by UpDownCounters and its
+ *        bit-sliced specialization, with what does not depend on how a row
+ *        stores its counters: the update flag overloads of write and read,
+ *        permuteLocations and the checks before indices reach the kernels.
+ * \tparam DERIVED The UpDownCounters, which writes and reads the rows of
+ *                 activated hard locations.
+ * \tparam ROW A CounterGridRow.
+ * \tparam DATA_BIT_COUNT Bit count of the data to be saved/retrieved.
+ */
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+class UpDownCountersBase {
+  static_assert(sizeof(ROW) % CACHE_LINE_SIZE == 0,
+                "Counter rows must fill whole cache lines.");
+
+ public:
+  /**
+   * Input the bits given an array of hamming distance.
+   * @param updateFlags Boolean per hard location indicating whether to
+   *                    update.
+   * @param bits Input bits.
+   * @throw std::invalid_argument if there is not one flag per hard location.
+   */
+  void write(const vector<bool>& updateFlags,
+             const bitset<DATA_BIT_COUNT>& bits);
+
+  /**
+   * Output the bits given an array of hamming distance.
+   * @param updateFlags Boolean per hard location indicating whether to read.
+   * @return The output.
+   * @throw std::invalid_argument if there is not one flag per hard location.
+   */
+  bitset<DATA_BIT_COUNT> read(const vector<bool>& updateFlags) const;
+
+  size_t getHardLocationCount() const;
+
+  /**
+   * Moves the counter rows along with reordered hard locations, see
+   * AddressRegister::sortLocations.
+   * @param permutation Row i becomes the former row permutation[i].
+   * @throw std::invalid_argument if permutation is not a permutation of the
+   *        hard location indices.
+   */
+  void permuteLocations(Span<const size_t> permutation);
+
+ protected:
+  /**
+   * @param geometricRatio
+   * @param hardLocationCount Number of rows.
+   * @param hugePages false to keep the grid off transparent huge pages.
+   * @throw std::invalid_argument if hardLocationCount is 0 or the indices
+   *        do not fit in LOCATION_INDEX_TYPE.
+   */
+  UpDownCountersBase(FLOAT geometricRatio,
+                     size_t hardLocationCount,
+                     bool hugePages);
+
+  /**
+   * @return Indices of the hard locations whose flag is set.
+   * @throw std::invalid_argument if there is not one flag per hard location.
+   */
+  activationList _getActivated(const vector<bool>& updateFlags) const;
+
+  /**
+   * The kernels take the indices as row offsets, so they are checked first.
+   * @throw std::invalid_argument if an index is not that of a hard location.
+   */
+  void _checkActivated(Span<const LOCATION_INDEX_TYPE> activated) const;
+
+  /**
+   * Checked before the grid is allocated, as AddressDecoder does.
+   * @return hardLocationCount.
+   * @throw std::invalid_argument if hardLocationCount is 0 or the indices
+   *        do not fit in LOCATION_INDEX_TYPE.
+   */
+  static size_t _checkHardLocationCount(size_t hardLocationCount);
+
+ protected:
+  FLOAT _geometricRatio;
+  AlignedBuffer<ROW> _upDownCounters;
+};
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::UpDownCountersBase(
+  FLOAT geometricRatio, size_t hardLocationCount, bool hugePages) :
+  _geometricRatio(geometricRatio),
+  _upDownCounters(_checkHardLocationCount(hardLocationCount), true,
+                  hugePages) {
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+void UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::write(
+  const vector<bool>& updateFlags,
+  const bitset<DATA_BIT_COUNT> &bits) {
+  static_cast<DERIVED*>(this)->write(_getActivated(updateFlags), bits);
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+bitset<DATA_BIT_COUNT> UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::read(
+  const vector<bool>& updateFlags) const {
+  return static_cast<const DERIVED*>(this)->read(_getActivated(updateFlags));
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+size_t UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::
+getHardLocationCount() const {
+  return _upDownCounters.size();
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+void UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::permuteLocations(
+  Span<const size_t> permutation) {
+  const size_t hardLocationCount = getHardLocationCount();
+  if (permutation.size() != hardLocationCount) {
+    throw std::invalid_argument("One index per hard location.");
+  }
+  vector<bool> seen(hardLocationCount);
+  for (size_t row : permutation) {
+    if (row >= hardLocationCount || seen[row]) {
+      throw std::invalid_argument("Not a permutation of the hard locations.");
+    }
+    seen[row] = true;
+  }
+
+  AlignedBuffer<ROW> permuted(hardLocationCount, false,
+                              _upDownCounters.hasHugePages());
+  for (size_t i = 0; i < hardLocationCount; i++) {
+    permuted[i] = _upDownCounters[permutation[i]];
+  }
+  swap(_upDownCounters, permuted);
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+activationList UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::
+_getActivated(const vector<bool>& updateFlags) const {
+  if (updateFlags.size() != getHardLocationCount()) {
+    throw std::invalid_argument("One update flag per hard location.");
+  }
+  activationList activated;
+  for (size_t i = 0; i < updateFlags.size(); i++) {
+    if (updateFlags[i]) {
+      activated.push_back(static_cast<LOCATION_INDEX_TYPE>(i));
+    }
+  }
+  return activated;
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+void UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::_checkActivated(
+  Span<const LOCATION_INDEX_TYPE> activated) const {
+  const size_t hardLocationCount = getHardLocationCount();
+  for (LOCATION_INDEX_TYPE location : activated) {
+    if (location >= hardLocationCount) {
+      throw std::invalid_argument("Not a hard location index.");
+    }
+  }
+}
+
+template<typename DERIVED, typename ROW, size_t DATA_BIT_COUNT>
+size_t UpDownCountersBase<DERIVED, ROW, DATA_BIT_COUNT>::
+_checkHardLocationCount(size_t hardLocationCount) {
+  if (hardLocationCount == 0 ||
+      hardLocationCount - 1 > LOCATION_INDEX_TYPE(-1)) {
+    throw std::invalid_argument(
+      "Hard location indices must fit in LOCATION_INDEX_TYPE.");
+  }
+  return hardLocationCount;
+}
+
+}  // namespace sdm
@@ -28,19 +28,29 @@ namespace sdm {
  * \brief Factory method for UpDownCounters
  * \tparam DATA_BIT_COUNT Bit count of the data to be saved/retrieved.
  * \tparam HARD_LOCATION_BIT_COUNT Bit count of the hard location.
+ * \tparam COUNTER Counter type.
  */
 template <
   size_t DATA_BIT_COUNT,
-  size_t HARD_LOCATION_BIT_COUNT>
+  size_t HARD_LOCATION_BIT_COUNT,
+  typename COUNTER = COUNTER_TYPE>
 class UpDownCountersFactory :
   public FactoryAbstract<
-    UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>> {
+    UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>> {
  public:
-  explicit UpDownCountersFactory(FLOAT geometricRatio) {
+  /**
+   * @param geometricRatio
+   * @param hardLocationCount Number of hard locations.
+   */
+  explicit UpDownCountersFactory(
+    FLOAT geometricRatio,
+    size_t hardLocationCount =
+      UpDownCounters<
+        DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>::HARD_LOCATION_COUNT) {
     this->_instance =
-      spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
-        new UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT>(
-          geometricRatio));
+      spUpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>(
+        new UpDownCounters<DATA_BIT_COUNT, HARD_LOCATION_BIT_COUNT, COUNTER>(
+          geometricRatio, hardLocationCount));
   }
 };
 
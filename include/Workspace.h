@@ -0,0 +1,75 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "./declares.h"
+
+using std::vector;
+
+namespace sdm {
+
+/*!\class Workspace
+ * \brief Scratch buffers of a read or write, owned by the caller and reused
+ *        from one operation to the next.
+ *
+ * The buffers grow to the largest size an operation needs and are never
+ * shrunk, so once a workspace has served an operation of each size, reads
+ * and writes through it do not allocate. The large temporaries live on the
+ * heap, so the stack use of an operation does not depend on the number of
+ * hard locations. A workspace must not be shared between threads; keep one
+ * per thread.
+ */
+class Workspace {
+ public:
+  /**
+   * Hard locations activated by the current address.
+   */
+  activationList activated;
+
+  /**
+   * Hard locations activated by each address of the current batch.
+   */
+  vector<activationList> batchActivated;
+
+  /**
+   * Packed addresses of the current batch.
+   */
+  vector<WORD_TYPE> addressWords;
+
+  /**
+   * Distance of each hard location, see activateNearestLocations.
+   */
+  vector<uint16_t> distances;
+
+  /**
+   * Histogram of the distances, see activateNearestLocations.
+   */
+  vector<size_t> histogram;
+
+  /**
+   * Hard locations within the threshold below the current one, while a
+   * decoder searches the threshold of the nearest locations.
+   */
+  activationList nearer;
+};
+
+}  // namespace sdm
@@ -19,6 +19,9 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 using std::array;
 
@@ -26,6 +29,44 @@ namespace sdm {
 
 constexpr size_t BYTE_BIT_SIZE = 8;
 
+/*! \typedef WORD_TYPE
+ *  \brief Machine word in which packed addresses are stored.
+ */
+using WORD_TYPE = uint64_t;
+constexpr size_t WORD_BIT_SIZE = sizeof(WORD_TYPE) * BYTE_BIT_SIZE;
+
+/*!
+ * Alignment of the large buffers (address matrix, counter grid).
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/*!
+ * Size of a transparent huge page. Buffers at least this large that ask for
+ * huge pages start on one.
+ */
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * Number of words needed to hold the given number of bits.
+ * @param bitCount Number of bits.
+ * @return ceil(bitCount / WORD_BIT_SIZE).
+ */
+constexpr size_t wordCount(size_t bitCount) {
+  return (bitCount + WORD_BIT_SIZE - 1) / WORD_BIT_SIZE;
+}
+
+/**
+ * Mask of the bits in use in the last word of a packed bit string.
+ * @param bitCount Number of bits.
+ * @return Mask with the lowest (bitCount % WORD_BIT_SIZE) bits set, or all
+ *         bits set if the last word is full.
+ */
+constexpr WORD_TYPE lastWordMask(size_t bitCount) {
+  return bitCount % WORD_BIT_SIZE == 0 ?
+         ~WORD_TYPE(0) :
+         (WORD_TYPE(1) << (bitCount % WORD_BIT_SIZE)) - 1;
+}
+
 using FLOAT = double;
 constexpr size_t FLOAT_SIZE = sizeof(FLOAT) * BYTE_BIT_SIZE;
 
@@ -39,4 +80,14 @@ using floatArray = std::array<FLOAT, N>;
 template<size_t N>
 using hammingDistanceArray = array<size_t, N>;
 
+/*! \typedef LOCATION_INDEX_TYPE
+ *  \brief Index of a hard location.
+ */
+using LOCATION_INDEX_TYPE = uint32_t;
+
+/*! \typedef activationList
+ *  \brief Indices of the activated hard locations, in increasing order.
+ */
+using activationList = std::vector<LOCATION_INDEX_TYPE>;
+
 }  // namespace sdm
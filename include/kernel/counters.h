@@ -0,0 +1,303 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../declares.h"
+
+namespace sdm {
+
+/**
+ * Adds the data bits, as +1 for a set bit and -1 for a clear one, to each of
+ * the given rows of a counter grid. A counter at the bound of its type in
+ * the direction of its bit stays there. The bits are expanded into a vector
+ * of +1/-1 lanes once, then added to each row with vector adds, using the
+ * instruction set of getKernelISA(). The rows a few ahead of the one being
+ * added are prefetched.
+ * @param counters Row-major grid of counters, rowStride apart. A row must
+ *                 fill whole cache lines, that is rowStride *
+ *                 sizeof(*counters) is a multiple of CACHE_LINE_SIZE.
+ * @param rowStride Distance in counters between the start of two rows.
+ * @param rows Indices of the rows to update.
+ * @param rowCount Number of rows to update.
+ * @param bits The data, wordCount(bitCount) words.
+ * @param bitCount Number of data bits, the counters in use in a row, at most
+ *                 rowStride. The counters past bitCount are left unchanged.
+ */
+void writeCounterRows(
+  int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * Like writeCounterRows(int8_t*, ...), but adds weights[r] times +1 or -1
+ * to row rows[r], saturating at the bounds of the counters.
+ * @param weights One weight per row, above the minimum of the counter type.
+ */
+void writeCounterRows(
+  int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int8_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int16_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int32_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * See writeCounterRows(int8_t*, ...).
+ */
+void writeCounterRows(
+  int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int64_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * Sums the given rows of a counter grid and sets each data bit whose
+ * counters add up to a positive sum. The rows are accumulated in place in
+ * one block of sums, in the narrowest type that cannot overflow for
+ * rowCount rows, then compared to zero, using the instruction set of
+ * getKernelISA(). The rows a few ahead of the one being added are
+ * prefetched.
+ * @param counters Row-major grid of counters, as in writeCounterRows.
+ * @param rowStride Distance in counters between the start of two rows.
+ * @param rows Indices of the rows to sum.
+ * @param rowCount Number of rows to sum.
+ * @param bitCount Number of data bits, at most rowStride.
+ * @param bits Output, wordCount(bitCount) words, the unused high bits of the
+ *             last word are cleared.
+ */
+void readCounterRows(
+  const int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * Like readCounterRows(const int8_t*, ...), but sums weights[r] times row
+ * rows[r], in 64 bits. The sums are exact while the weight magnitudes add up
+ * to at most INT64_MAX >> (bits per counter - 1). Otherwise, and always for
+ * 64-bit counters, they are taken one at a time and saturate at the bounds
+ * of int64_t instead of overflowing.
+ * @param weights One weight per row.
+ */
+void readCounterRows(
+  const int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int8_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int16_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int32_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/**
+ * See readCounterRows(const int8_t*, ...).
+ */
+void readCounterRows(
+  const int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int64_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+/*!
+ * Most bit-planes of a bit-sliced counter, see writeBitSlicedCounterRows.
+ */
+constexpr size_t MAX_BIT_SLICED_COUNTER_PLANE_COUNT = 16;
+
+/**
+ * Like writeCounterRows, for a grid of bit-sliced counters: each row holds
+ * planeCount bit-planes of wordCount(bitCount) words, plane k holding bit k
+ * of every counter of the row, in two's complement. The +1 or -1 of each
+ * counter ripples through the bit-planes as a carry or a borrow, so one
+ * bitwise instruction updates as many counters as the vector has bits. A
+ * counter at the bound of planeCount bits in the direction of its bit stays
+ * there.
+ * @param counters Row-major grid of bit-planes, rowStride words apart.
+ * @param rowStride Distance in words between the start of two rows, at
+ *                  least planeCount * wordCount(bitCount).
+ * @param planeCount Number of bit-planes of a counter, from 2 to
+ *                   MAX_BIT_SLICED_COUNTER_PLANE_COUNT.
+ * @param rows Indices of the rows to update.
+ * @param rowCount Number of rows to update.
+ * @param bits The data, wordCount(bitCount) words.
+ * @param bitCount Number of data bits, the counters of a row. The counters
+ *                 past bitCount in the last word are left unchanged.
+ */
+void writeBitSlicedCounterRows(
+  WORD_TYPE* counters,
+  size_t rowStride,
+  size_t planeCount,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount);
+
+/**
+ * Like readCounterRows, for a grid of bit-sliced counters, see
+ * writeBitSlicedCounterRows. Each counter is offset to an unsigned value by
+ * flipping its sign bit and the rows are summed with bit-sliced full adders
+ * into as many bit-planes as rowCount rows need. A bit is set if its sum is
+ * above the sum of the offsets, compared from the most significant
+ * bit-plane down.
+ * @param counters Grid of bit-planes, as in writeBitSlicedCounterRows.
+ * @param rowStride Distance in words between the start of two rows.
+ * @param planeCount Number of bit-planes of a counter.
+ * @param rows Indices of the rows to sum.
+ * @param rowCount Number of rows to sum.
+ * @param bitCount Number of data bits.
+ * @param bits Output, wordCount(bitCount) words, the unused high bits of the
+ *             last word are cleared.
+ */
+void readBitSlicedCounterRows(
+  const WORD_TYPE* counters,
+  size_t rowStride,
+  size_t planeCount,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits);
+
+}  // namespace sdm
@@ -0,0 +1,441 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../declares.h"
+
+namespace sdm {
+
+/*!
+ * Number of words in the blocks the early exit activation accumulates and
+ * checks its partial distance on.
+ */
+constexpr size_t HAMMING_BLOCK_WORD_COUNT = 4;
+
+/**
+ * @param wordCount Number of words in an address.
+ * @return Number of early exit blocks in an address, the last may be partial.
+ */
+constexpr size_t hammingBlockCount(size_t wordCount) {
+  return (wordCount + HAMMING_BLOCK_WORD_COUNT - 1) / HAMMING_BLOCK_WORD_COUNT;
+}
+
+/*!
+ * Number of queries a batch kernel compares each loaded location against,
+ * while the location is in registers.
+ */
+constexpr size_t BATCH_QUERY_BLOCK_SIZE = 4;
+
+/*!
+ * Most bytes of locations a batch activation streams through every query
+ * before moving on, sized to stay in the L2 cache.
+ */
+constexpr size_t BATCH_TILE_BYTE_SIZE = 128 * 1024;
+
+/*!
+ * Most locations in a tile of a batch activation, the size of the buffers a
+ * tile is compacted into, one per address. Tiles of addresses narrower than
+ * 512 bits stop here before BATCH_TILE_BYTE_SIZE: at 64 bits a tile is
+ * 16 KiB and stays in the L1 cache, which measured faster than a 128 KiB
+ * tile.
+ */
+constexpr size_t BATCH_TILE_LOCATION_COUNT = 2048;
+
+/*!
+ * Number of locations in a bit slice. A bit-sliced matrix stores, for each
+ * slice and each address bit, one bit-plane holding that bit of every
+ * location of the slice.
+ */
+constexpr size_t BIT_SLICE_LOCATION_COUNT = 512;
+
+/*!
+ * Number of words in a bit-plane, one 512-bit vector.
+ */
+constexpr size_t BIT_SLICE_WORD_COUNT =
+  BIT_SLICE_LOCATION_COUNT / WORD_BIT_SIZE;
+
+/**
+ * @param locationCount Number of locations.
+ * @return Number of bit slices holding locationCount locations, the last may
+ *         be partial.
+ */
+constexpr size_t bitSliceCount(size_t locationCount) {
+  return (locationCount + BIT_SLICE_LOCATION_COUNT - 1) /
+         BIT_SLICE_LOCATION_COUNT;
+}
+
+/*!\enum KernelISA
+ * \brief Instruction set the distance kernels are compiled for. The best one
+ *        supported by both the build and the running CPU is selected when the
+ *        first kernel is called.
+ */
+enum class KernelISA {
+  GENERIC,  //!< Portable C++, no popcount instruction.
+  POPCNT,  //!< Scalar loop using the POPCNT instruction.
+  AVX2,  //!< 256-bit nibble lookup table popcount.
+  //! 512-bit VPOPCNTQ popcount, with AVX-512 BW, DQ and VL.
+  AVX512_VPOPCNTDQ
+};
+
+/**
+ * @param isa Instruction set.
+ * @return true if the kernels were compiled for isa and the CPU supports it.
+ */
+bool isKernelISASupported(KernelISA isa);
+
+/**
+ * @return Instruction set of the kernels currently in use.
+ */
+KernelISA getKernelISA();
+
+/**
+ * Overrides the instruction set chosen at startup. Mostly useful for tests
+ * and benchmarks.
+ * @param isa Instruction set.
+ * @throw std::invalid_argument if isa is not supported.
+ */
+void setKernelISA(KernelISA isa);
+
+/**
+ * Computes the hamming distance of address to each of the locations in a
+ * single pass over the location matrix.
+ * @param locations Row-major matrix of locationCount x wordCount words.
+ * @param locationCount Number of locations.
+ * @param wordCount Number of words per location and in address.
+ * @param address The address, wordCount words.
+ * @param distances Output, locationCount distances.
+ */
+void hammingDistances(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances);
+
+/**
+ * Computes the hamming distance of address to each of the locations and
+ * keeps the indices of those within threshold, in one pass and without
+ * materializing the distances.
+ * @param locations Row-major matrix of locationCount x wordCount words.
+ * @param locationCount Number of locations.
+ * @param wordCount Number of words per location and in address.
+ * @param address The address, wordCount words.
+ * @param threshold Maximum distance of an activated location.
+ * @param activated Output, cleared then filled with the indices of the
+ *                  locations whose distance is <= threshold. Its capacity is
+ *                  reused, so passing the same list again does not allocate.
+ */
+void activateLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated);
+
+/**
+ * Same as activateLocations, but the distance of each location is
+ * accumulated block by block in blockOrder, and the location is abandoned as
+ * soon as its partial distance exceeds threshold. Worth it for wide
+ * addresses, where most locations are rejected before all blocks are read.
+ * @param blockOrder Permutation of the hammingBlockCount(wordCount) block
+ *                   indices. Blocks likely to differ the most should come
+ *                   first.
+ */
+void activateLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  const size_t* blockOrder,
+  activationList* activated);
+
+/**
+ * Activates the count locations nearest to address, so the activation size
+ * does not depend on the query. The distances are computed by the
+ * distances kernel and kept in 16 bits, the radius is then found by a
+ * counting select over the histogram of the distances instead of a sort,
+ * and a last branch-free pass over the distances keeps the locations within
+ * it. Ties at the radius go to the lowest indices.
+ * @param locations Row-major matrix of locationCount x wordCount words.
+ * @param locationCount Number of locations.
+ * @param wordCount Number of words per location and in address.
+ * @param address The address, wordCount words.
+ * @param count Number of locations to activate, all of them if larger than
+ *              locationCount.
+ * @param activated Output, cleared then filled with the indices of the count
+ *                  nearest locations, in increasing order.
+ * @throw std::invalid_argument if a distance does not fit in 16 bits.
+ */
+void activateNearestLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated);
+
+/**
+ * Same as activateNearestLocations, with caller-provided scratch buffers
+ * that are reused instead of allocated.
+ * @param distances Scratch, resized to locationCount.
+ * @param histogram Scratch, resized to wordCount * WORD_BIT_SIZE + 1.
+ */
+void activateNearestLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated,
+  std::vector<uint16_t>* distances,
+  std::vector<size_t>* histogram);
+
+/**
+ * Same as activateLocations, for several addresses at once. The locations are
+ * processed in tiles of at most BATCH_TILE_BYTE_SIZE and
+ * BATCH_TILE_LOCATION_COUNT that every address is compared against while the
+ * tile is in cache, BATCH_QUERY_BLOCK_SIZE addresses per
+ * load of a location. Each location is read from memory once per batch
+ * instead of once per address.
+ * @param addresses Row-major matrix of addressCount x wordCount words.
+ * @param addressCount Number of addresses.
+ * @param activated Output, addressCount lists, each cleared then filled with
+ *                  the indices of the locations within threshold of the
+ *                  corresponding address.
+ */
+void activateLocationsBatch(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  activationList* activated);
+
+/**
+ * Histogram of the hamming distances between several addresses and every
+ * location, in one pass over the locations: each tile is compared to all the
+ * addresses while it is in cache, as in activateLocationsBatch.
+ * @param locations Row-major matrix of locationCount x wordCount words.
+ * @param locationCount Number of locations.
+ * @param wordCount Number of words per location and per address.
+ * @param addresses Row-major matrix of addressCount x wordCount words.
+ * @param addressCount Number of addresses.
+ * @param histogram Output, wordCount * WORD_BIT_SIZE + 1 counts. Entry d is
+ *                  set to the number of (address, location) pairs at
+ *                  distance d.
+ */
+void hammingDistanceHistogram(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t* histogram);
+
+/**
+ * Transposes a row-major location matrix into bit-planes. Bit-plane i of
+ * slice s is the BIT_SLICE_WORD_COUNT words at
+ * planes + (s * bitCount + i) * BIT_SLICE_WORD_COUNT, and bit j of it is bit
+ * i of location s * BIT_SLICE_LOCATION_COUNT + j. The bits of the locations
+ * past locationCount in the last slice are 0.
+ * @param locations Row-major matrix of locationCount x wordCount(bitCount)
+ *                  words.
+ * @param locationCount Number of locations.
+ * @param bitCount Number of bits per location.
+ * @param planes Output, bitSliceCount(locationCount) * bitCount *
+ *               BIT_SLICE_WORD_COUNT words.
+ */
+void transposeToBitSlices(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t bitCount,
+  WORD_TYPE* planes);
+
+/**
+ * Compares address to every location of a bit-sliced matrix. The mismatches
+ * of each bit-plane are summed by a bit-sliced adder network into per
+ * location counters, themselves stored as bit-planes, which are then
+ * compared to threshold bit-plane by bit-plane. Each instruction works on as
+ * many locations as the vector has bits.
+ * @param planes Bit-sliced matrix, see transposeToBitSlices.
+ * @param sliceCount Number of slices.
+ * @param bitCount Number of bits per location and in address.
+ * @param address The address, wordCount(bitCount) words.
+ * @param threshold Maximum distance of an activated location.
+ * @param masks Output, BIT_SLICE_WORD_COUNT words per slice. Bit j of the
+ *              words of slice s is set if location
+ *              s * BIT_SLICE_LOCATION_COUNT + j is within threshold.
+ */
+void bitSlicedActivationMasks(
+  const WORD_TYPE* planes,
+  size_t sliceCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  WORD_TYPE* masks);
+
+/**
+ * Same as activateLocations, on a bit-sliced matrix.
+ * @param planes Bit-sliced matrix, see transposeToBitSlices.
+ * @param locationCount Number of locations.
+ * @param bitCount Number of bits per location and in address.
+ * @param address The address, wordCount(bitCount) words.
+ * @param threshold Maximum distance of an activated location.
+ * @param activated Output, cleared then filled with the indices of the
+ *                  locations whose distance is <= threshold.
+ */
+void activateBitSliced(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated);
+
+/**
+ * @param bitCount Number of bits of the addresses.
+ * @return Number of bit-planes of bit-sliced distances to addresses of
+ *         bitCount bits, the bit width of bitCount, their largest distance.
+ */
+constexpr size_t bitSlicedDistancePlaneCount(size_t bitCount) {
+  return bitCount == 0 ? 0 : 1 + bitSlicedDistancePlaneCount(bitCount >> 1);
+}
+
+/**
+ * Hamming distance of address to each location of a bit-sliced matrix, kept
+ * bit-sliced as well: for each slice, bit-plane k holds bit k of the
+ * distance of every location of the slice. The starting point of
+ * updateBitSlicedDistances.
+ * @param planes Bit-sliced matrix, see transposeToBitSlices.
+ * @param locationCount Number of locations.
+ * @param bitCount Number of bits per location and in address.
+ * @param address The address, wordCount(bitCount) words.
+ * @param distances Output, bitSliceCount(locationCount) *
+ *                  bitSlicedDistancePlaneCount(bitCount) *
+ *                  BIT_SLICE_WORD_COUNT words. Bit-plane k of slice s is the
+ *                  BIT_SLICE_WORD_COUNT words at distances +
+ *                  (s * bitSlicedDistancePlaneCount(bitCount) + k) *
+ *                  BIT_SLICE_WORD_COUNT.
+ */
+void bitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  WORD_TYPE* distances);
+
+/**
+ * @param distances Bit-sliced distances, see bitSlicedDistances.
+ * @param bitCount Number of bits of the addresses.
+ * @param location Index of the location.
+ * @return The distance of the location.
+ */
+size_t bitSlicedDistance(
+  const WORD_TYPE* distances,
+  size_t bitCount,
+  size_t location);
+
+/**
+ * Turns the distances of the locations to a previous address into their
+ * distances to address, which differs from it in the flipped bits only, and
+ * activates the locations within threshold. Each flipped bit adds 1 to the
+ * locations its bit-plane now mismatches and removes 1 from the others: the
+ * +1 or -1 ripples through the bit-planes of the distances as a carry or a
+ * borrow, one bitwise operation covering as many locations as the vector has
+ * bits. The cost is proportional to flipCount instead of bitCount.
+ * @param planes Bit-sliced matrix, see transposeToBitSlices.
+ * @param locationCount Number of locations.
+ * @param bitCount Number of bits per location and in address.
+ * @param address The new address, wordCount(bitCount) words.
+ * @param flippedBits Positions of the bits that differ from the previous
+ *                    address, each listed once.
+ * @param flipCount Number of flipped bits.
+ * @param threshold Maximum distance of an activated location.
+ * @param distances Input and output, bit-sliced distances, see
+ *                  bitSlicedDistances.
+ * @param activated Output, cleared then filled with the indices of the
+ *                  locations whose distance is <= threshold.
+ */
+void updateBitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  const size_t* flippedBits,
+  size_t flipCount,
+  size_t threshold,
+  WORD_TYPE* distances,
+  activationList* activated);
+
+/**
+ * Same as activateLocations, on locations that are never stored. Word w of
+ * location r is counterRandomWord(seed, r * wordCount(bitCount) + w), the
+ * unused high bits of the last word cleared, as laid out by
+ * generateRandomRows. The kernels regenerate each word with a vectorized
+ * SplitMix64 right before comparing it.
+ * @param seed Selects the locations.
+ * @param locationCount Number of locations.
+ * @param bitCount Number of bits per location and in address.
+ * @param address The address, wordCount(bitCount) words.
+ * @param threshold Maximum distance of an activated location.
+ * @param activated Output, cleared then filled with the indices of the
+ *                  locations whose distance is <= threshold.
+ */
+void activateProceduralLocations(
+  uint64_t seed,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated);
+
+/**
+ * Activates the locations of a selected-coordinate register: location i is
+ * defined by selectedBitCount (bit index, required value) pairs, and its
+ * distance is the number of its selected bits whose address bit differs
+ * from the required value.
+ * @param coordinates locationCount x selectedBitCount coordinates,
+ *                    row-major, each the bit index shifted left by one with
+ *                    the required value in the low bit.
+ * @param locationCount Number of locations.
+ * @param selectedBitCount Number of selected bits per location.
+ * @param bitCount Number of bits in address.
+ * @param address The address, wordCount(bitCount) words.
+ * @param threshold Maximum distance of an activated location, 0 to require
+ *                  every selected bit to match.
+ * @param activated Output, cleared then filled with the indices of the
+ *                  locations whose distance is <= threshold.
+ */
+void activateSelectedCoordinates(
+  const uint16_t* coordinates,
+  size_t locationCount,
+  size_t selectedBitCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated);
+
+}  // namespace sdm
@@ -0,0 +1,152 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../declares.h"
+
+namespace sdm {
+
+/*!\class AlignedBuffer
+ * \brief Zero-initialized (by default), heap allocated, over-aligned buffer
+ *        of trivial elements. Backs the large grids so they are contiguous
+ *        and start on a cache line.
+ *
+ * A buffer may also ask for transparent huge pages: if it spans at least
+ * HUGE_PAGE_SIZE bytes it is then aligned to HUGE_PAGE_SIZE and advised with
+ * MADV_HUGEPAGE before it is first touched, so a multi-gigabyte grid takes a
+ * TLB entry per 2 MiB instead of per 4 KiB. The advice is a hint, ignored
+ * where it is not supported.
+ * \tparam T Element type. Must be trivial.
+ * \tparam ALIGNMENT Alignment in bytes of the first element.
+ */
+template<typename T, size_t ALIGNMENT = CACHE_LINE_SIZE>
+class AlignedBuffer {
+  static_assert(std::is_trivial<T>::value,
+                "AlignedBuffer only holds trivial types.");
+
+ public:
+  /**
+   * Allocates size zeroed elements.
+   * @param size Number of elements.
+   * @param zeroed false to leave the elements uninitialized, when they are
+   *               all written right away. The pages are then first touched
+   *               by whichever threads write them.
+   * @param hugePages true to back the buffer with transparent huge pages.
+   * @throw std::bad_alloc if size elements do not fit in memory.
+   */
+  explicit AlignedBuffer(size_t size = 0,
+                         bool zeroed = true,
+                         bool hugePages = false);
+
+  AlignedBuffer(const AlignedBuffer& other);
+  AlignedBuffer(AlignedBuffer&& other) noexcept;
+  AlignedBuffer& operator=(AlignedBuffer other);
+  ~AlignedBuffer();
+
+  T* data() { return _data; }
+  const T* data() const { return _data; }
+  size_t size() const { return _size; }
+  bool hasHugePages() const { return _hugePages; }
+
+  T& operator[](size_t i) { return _data[i]; }
+  const T& operator[](size_t i) const { return _data[i]; }
+
+  friend void swap(AlignedBuffer& lhs, AlignedBuffer& rhs) {
+    std::swap(lhs._data, rhs._data);
+    std::swap(lhs._size, rhs._size);
+    std::swap(lhs._hugePages, rhs._hugePages);
+  }
+
+ protected:
+  T* _data;
+  size_t _size;
+  bool _hugePages;
+};
+
+template<typename T, size_t ALIGNMENT>
+AlignedBuffer<T, ALIGNMENT>::AlignedBuffer(size_t size,
+                                           bool zeroed,
+                                           bool hugePages) :
+  _data(nullptr), _size(size), _hugePages(hugePages) {
+  if (size == 0) {
+    return;
+  }
+
+  if (size > SIZE_MAX / sizeof(T)) {
+    throw std::bad_alloc();
+  }
+  const size_t bytes = size * sizeof(T);
+  const bool huge = hugePages && bytes >= HUGE_PAGE_SIZE;
+  const size_t alignment = huge ? std::max(ALIGNMENT, HUGE_PAGE_SIZE) :
+                           ALIGNMENT;
+  void* memory = nullptr;
+  if (posix_memalign(&memory, alignment, bytes) != 0) {
+    throw std::bad_alloc();
+  }
+#ifdef MADV_HUGEPAGE
+  if (huge) {
+    madvise(memory, bytes, MADV_HUGEPAGE);
+  }
+#endif
+  if (zeroed) {
+    std::memset(memory, 0, bytes);
+  }
+  _data = static_cast<T*>(memory);
+}
+
+template<typename T, size_t ALIGNMENT>
+AlignedBuffer<T, ALIGNMENT>::AlignedBuffer(const AlignedBuffer& other) :
+  AlignedBuffer(other._size, false, other._hugePages) {
+  if (_size > 0) {
+    std::memcpy(_data, other._data, _size * sizeof(T));
+  }
+}
+
+template<typename T, size_t ALIGNMENT>
+AlignedBuffer<T, ALIGNMENT>::AlignedBuffer(AlignedBuffer&& other) noexcept :
+  _data(other._data), _size(other._size), _hugePages(other._hugePages) {
+  other._data = nullptr;
+  other._size = 0;
+}
+
+template<typename T, size_t ALIGNMENT>
+AlignedBuffer<T, ALIGNMENT>& AlignedBuffer<T, ALIGNMENT>::operator=(
+  AlignedBuffer other) {
+  swap(*this, other);
+  return *this;
+}
+
+template<typename T, size_t ALIGNMENT>
+AlignedBuffer<T, ALIGNMENT>::~AlignedBuffer() {
+  std::free(_data);
+}
+
+}  // namespace sdm
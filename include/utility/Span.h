@@ -0,0 +1,97 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace sdm {
+
+/*!\class Span
+ * \brief Non-owning view of a contiguous sequence.
+ * \tparam T Element type. Use a const T for read-only views.
+ */
+template<typename T>
+class Span {
+ public:
+  Span() : _data(nullptr), _size(0) {}
+  Span(T* data, size_t size) : _data(data), _size(size) {}
+
+  Span(std::vector<typename std::remove_const<T>::type>& v) :  // NOLINT
+    _data(v.data()), _size(v.size()) {}
+  Span(const std::vector<typename std::remove_const<T>::type>& v) :  // NOLINT
+    _data(v.data()), _size(v.size()) {}
+
+  T* data() const { return _data; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  T& operator[](size_t i) const { return _data[i]; }
+
+  T* begin() const { return _data; }
+  T* end() const { return _data + _size; }
+
+ protected:
+  T* _data;
+  size_t _size;
+};
+
+/*!\class MatrixSpan
+ * \brief Non-owning view of a row-major matrix. Each row is a Span.
+ * \tparam T Element type. Use a const T for read-only views.
+ */
+template<typename T>
+class MatrixSpan {
+ public:
+  MatrixSpan() : _data(nullptr), _rows(0), _columns(0), _stride(0) {}
+
+  /**
+   * @param data First element of the first row.
+   * @param rows Number of rows.
+   * @param columns Number of elements in each row.
+   * @param stride Distance in elements between the start of two rows.
+   */
+  MatrixSpan(T* data, size_t rows, size_t columns, size_t stride) :
+    _data(data), _rows(rows), _columns(columns), _stride(stride) {}
+
+  MatrixSpan(T* data, size_t rows, size_t columns) :
+    MatrixSpan(data, rows, columns, columns) {}
+
+  T* data() const { return _data; }
+
+  /**
+   * @return Number of rows.
+   */
+  size_t size() const { return _rows; }
+  size_t columns() const { return _columns; }
+  size_t stride() const { return _stride; }
+
+  Span<T> operator[](size_t row) const {
+    return Span<T>(_data + row * _stride, _columns);
+  }
+
+ protected:
+  T* _data;
+  size_t _rows;
+  size_t _columns;
+  size_t _stride;
+};
+
+}  // namespace sdm
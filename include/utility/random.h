@@ -0,0 +1,88 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "../declares.h"
+
+namespace sdm {
+
+/*!
+ * SplitMix64 constants: the counter increment and the multipliers of the
+ * output function. Also used by the kernels that regenerate addresses.
+ */
+constexpr uint64_t SPLITMIX_GAMMA = 0x9e3779b97f4a7c15ULL;
+constexpr uint64_t SPLITMIX_MULTIPLIER_1 = 0xbf58476d1ce4e5b9ULL;
+constexpr uint64_t SPLITMIX_MULTIPLIER_2 = 0x94d049bb133111ebULL;
+
+/**
+ * SplitMix64 output function.
+ * @param z State.
+ * @return Random word.
+ */
+inline WORD_TYPE splitMix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * SPLITMIX_MULTIPLIER_1;
+  z = (z ^ (z >> 27)) * SPLITMIX_MULTIPLIER_2;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Mixes a seed into the start of its stream, which keeps the streams of
+ * nearby seeds apart.
+ * @param seed Selects the stream.
+ * @return State before the first word of the stream.
+ */
+inline uint64_t counterRandomKey(uint64_t seed) {
+  const uint64_t z = seed * 0xd1342543de82ef95ULL + 0x2545f4914f6cdd1dULL;
+  return (z ^ (z >> 32)) * SPLITMIX_MULTIPLIER_1;
+}
+
+/**
+ * Counter-based random word, the SplitMix64 output of the counter-th element
+ * of the stream selected by seed. Every word is independent of the others,
+ * so any range of them can be generated in any order and by any number of
+ * threads with the same result.
+ * @param seed Selects the stream.
+ * @param counter Position in the stream.
+ * @return Random word.
+ */
+inline WORD_TYPE counterRandomWord(uint64_t seed, uint64_t counter) {
+  return splitMix64(counterRandomKey(seed) + (counter + 1) * SPLITMIX_GAMMA);
+}
+
+/**
+ * Fills a row-major matrix with random rows of bitCount bits. Word w of row
+ * r is counterRandomWord(seed, r * wordCount(bitCount) + w), with the unused
+ * high bits of the last word cleared. Rows are split across threads, the
+ * result does not depend on threadCount.
+ * @param seed Selects the random stream.
+ * @param rowCount Number of rows.
+ * @param bitCount Number of bits per row.
+ * @param rows Output, rowCount x wordCount(bitCount) words.
+ * @param threadCount Number of threads, 0 for one per hardware thread.
+ */
+void generateRandomRows(
+  uint64_t seed,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* rows,
+  size_t threadCount = 0);
+
+}  // namespace sdm
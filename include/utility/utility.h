@@ -47,6 +47,63 @@ array<T, N> operator+(const array<T, N>& lhs, const array<T, N>& rhs) {
   return rv;
 }
 
+/**
+ * Hamming distance between two packed bit strings.
+ * @param lhs LHS words.
+ * @param rhs RHS words.
+ * @param wordCount Number of words in both lhs and rhs.
+ * @return Number of differing bits.
+ */
+inline size_t hammingDistance(
+  const WORD_TYPE* lhs, const WORD_TYPE* rhs, size_t wordCount) {
+  size_t distance = 0;
+  for (size_t w = 0; w < wordCount; w++) {
+    distance += __builtin_popcountll(lhs[w] ^ rhs[w]);
+  }
+
+  return distance;
+}
+
+/**
+ * Packs a bitset into words without going through a string or an integer.
+ * Bit i of the bitset goes to bit (i % WORD_BIT_SIZE) of word
+ * (i / WORD_BIT_SIZE) and the unused high bits of the last word are cleared.
+ * Goes a word at a time through to_ullong, so it does not depend on how the
+ * standard library lays out a bitset.
+ * @tparam N Number of bits.
+ * @param bits The bitset.
+ * @param words Output, wordCount(N) words.
+ */
+template<size_t N>
+void bitsetToWords(const bitset<N>& bits, WORD_TYPE* words) {
+  constexpr size_t WORD_COUNT = wordCount(N);
+  const bitset<N> wordMask(~WORD_TYPE(0));
+  bitset<N> remaining = bits;
+  for (size_t w = 0; w < WORD_COUNT; w++) {
+    words[w] = (remaining & wordMask).to_ullong();
+    remaining >>= WORD_BIT_SIZE;
+  }
+}
+
+/**
+ * Unpacks words into a bitset, the inverse of bitsetToWords.
+ * @tparam N Number of bits.
+ * @param words wordCount(N) words, the unused high bits of the last word are
+ *              ignored.
+ * @return The bitset.
+ */
+template<size_t N>
+bitset<N> wordsToBitset(const WORD_TYPE* words) {
+  constexpr size_t WORD_COUNT = wordCount(N);
+  // The bitset constructor and the shifts drop the bits past N.
+  bitset<N> bits;
+  for (size_t w = WORD_COUNT; w-- > 0;) {
+    bits <<= WORD_BIT_SIZE;
+    bits |= bitset<N>(words[w]);
+  }
+  return bits;
+}
+
 /**
  * Stream for array. For debugging purposes.
  * @tparam T Data type of elements in array.
@@ -0,0 +1,62 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Operations on a vector of bit-planes, see hamming_bitsliced.h, shared by
+// hamming_avx2.cpp and counters_avx2.cpp, and by counters_avx512.cpp for
+// the words short of a 512-bit vector.
+
+#include <immintrin.h>
+
+#include <cstddef>
+
+#include "kernel/hamming.h"
+
+namespace sdm {
+namespace {  // NOLINT(build/namespaces)
+
+/*!\struct Avx2BitSliceOps
+ * \brief Bit-sliced operations on a 256-bit vector, 256 lanes.
+ */
+struct Avx2BitSliceOps {
+  typedef __m256i Vector;
+  static constexpr size_t WORD_COUNT = 4;
+
+  static Vector load(const WORD_TYPE* words) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+  }
+  static void store(WORD_TYPE* words, Vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), v);
+  }
+  static Vector broadcast(WORD_TYPE word) { return _mm256_set1_epi64x(word); }
+  static Vector zero() { return _mm256_setzero_si256(); }
+  static Vector bitAnd(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+  static Vector bitOr(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+  static Vector bitXor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+  static Vector andNot(Vector a, Vector b) { return _mm256_andnot_si256(a, b); }
+  static void carrySaveAdd(Vector a, Vector b, Vector c,
+                           Vector* high, Vector* low) {
+    const Vector u = _mm256_xor_si256(a, b);
+    *high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    *low = _mm256_xor_si256(u, c);
+  }
+};
+
+}  // namespace
+}  // namespace sdm
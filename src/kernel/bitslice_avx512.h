@@ -0,0 +1,63 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Operations on a vector of bit-planes, see hamming_bitsliced.h, shared by
+// hamming_avx512.cpp and counters_avx512.cpp.
+
+#include <immintrin.h>
+
+#include <cstddef>
+
+#include "kernel/hamming.h"
+
+namespace sdm {
+namespace {  // NOLINT(build/namespaces)
+
+/*!\struct Avx512BitSliceOps
+ * \brief Bit-sliced operations on a 512-bit vector, 512 lanes. The
+ *        full adder is two ternary logic instructions.
+ */
+struct Avx512BitSliceOps {
+  typedef __m512i Vector;
+  static constexpr size_t WORD_COUNT = 8;
+
+  static Vector load(const WORD_TYPE* words) {
+    return _mm512_loadu_si512(words);
+  }
+  static void store(WORD_TYPE* words, Vector v) {
+    _mm512_storeu_si512(words, v);
+  }
+  static Vector broadcast(WORD_TYPE word) { return _mm512_set1_epi64(word); }
+  static Vector zero() { return _mm512_setzero_si512(); }
+  static Vector bitAnd(Vector a, Vector b) { return _mm512_and_si512(a, b); }
+  static Vector bitOr(Vector a, Vector b) { return _mm512_or_si512(a, b); }
+  static Vector bitXor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+  static Vector andNot(Vector a, Vector b) {
+    return _mm512_andnot_si512(a, b);
+  }
+  static void carrySaveAdd(Vector a, Vector b, Vector c,
+                           Vector* high, Vector* low) {
+    *high = _mm512_ternarylogic_epi64(a, b, c, 0xe8);
+    *low = _mm512_ternarylogic_epi64(a, b, c, 0x96);
+  }
+};
+
+}  // namespace
+}  // namespace sdm
@@ -0,0 +1,56 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Operations on a vector of bit-planes, see hamming_bitsliced.h, shared by
+// the bit-sliced hamming and counter kernels. Included by translation units
+// compiled with different target flags, hence the anonymous namespace.
+
+#include <cstddef>
+
+#include "kernel/hamming.h"
+
+namespace sdm {
+namespace {  // NOLINT(build/namespaces)
+
+/*!\struct ScalarBitSliceOps
+ * \brief Bit-sliced operations on one word, 64 lanes.
+ */
+struct ScalarBitSliceOps {
+  typedef WORD_TYPE Vector;
+  static constexpr size_t WORD_COUNT = 1;
+
+  static Vector load(const WORD_TYPE* words) { return *words; }
+  static void store(WORD_TYPE* words, Vector v) { *words = v; }
+  static Vector broadcast(WORD_TYPE word) { return word; }
+  static Vector zero() { return 0; }
+  static Vector bitAnd(Vector a, Vector b) { return a & b; }
+  static Vector bitOr(Vector a, Vector b) { return a | b; }
+  static Vector bitXor(Vector a, Vector b) { return a ^ b; }
+  static Vector andNot(Vector a, Vector b) { return ~a & b; }
+  static void carrySaveAdd(Vector a, Vector b, Vector c,
+                           Vector* high, Vector* low) {
+    const Vector u = a ^ b;
+    *high = (a & b) | (u & c);
+    *low = u ^ c;
+  }
+};
+
+}  // namespace
+}  // namespace sdm
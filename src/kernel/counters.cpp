@@ -0,0 +1,255 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernel/counters.h"
+#include "./counters_kernels.h"
+
+namespace sdm {
+namespace {
+
+/**
+ * @return The counter kernels of the instruction set of the hamming
+ *         kernels in use. The counter kernels only need vector adds, so the
+ *         POPCNT instruction set has none of its own.
+ */
+const CounterKernels* activeCounterKernels() {
+  switch (getKernelISA()) {
+#ifdef SDM_KERNEL_AVX2
+    case KernelISA::AVX2:
+      return &avx2CounterKernels;
+#endif
+#ifdef SDM_KERNEL_AVX512
+    case KernelISA::AVX512_VPOPCNTDQ:
+      return &avx512CounterKernels;
+#endif
+    default:
+      return &genericCounterKernels;
+  }
+}
+
+}  // namespace
+
+void writeCounterRows(
+  int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write8(
+    counters, rowStride, rows, nullptr, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int8_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write8(
+    counters, rowStride, rows, weights, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write16(
+    counters, rowStride, rows, nullptr, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int16_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write16(
+    counters, rowStride, rows, weights, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write32(
+    counters, rowStride, rows, nullptr, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int32_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write32(
+    counters, rowStride, rows, weights, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write64(
+    counters, rowStride, rows, nullptr, rowCount, bits, bitCount);
+}
+
+void writeCounterRows(
+  int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int64_t* weights,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->write64(
+    counters, rowStride, rows, weights, rowCount, bits, bitCount);
+}
+
+void readCounterRows(
+  const int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read8(
+    counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int8_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int8_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read8(
+    counters, rowStride, rows, weights, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read16(
+    counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int16_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int16_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read16(
+    counters, rowStride, rows, weights, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read32(
+    counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int32_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int32_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read32(
+    counters, rowStride, rows, weights, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read64(
+    counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+}
+
+void readCounterRows(
+  const int64_t* counters,
+  size_t rowStride,
+  const LOCATION_INDEX_TYPE* rows,
+  const int64_t* weights,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->read64(
+    counters, rowStride, rows, weights, rowCount, bitCount, bits);
+}
+
+void writeBitSlicedCounterRows(
+  WORD_TYPE* counters,
+  size_t rowStride,
+  size_t planeCount,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  const WORD_TYPE* bits,
+  size_t bitCount) {
+  activeCounterKernels()->writeBitSliced(
+    counters, rowStride, planeCount, rows, rowCount, bits, bitCount);
+}
+
+void readBitSlicedCounterRows(
+  const WORD_TYPE* counters,
+  size_t rowStride,
+  size_t planeCount,
+  const LOCATION_INDEX_TYPE* rows,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* bits) {
+  activeCounterKernels()->readBitSliced(
+    counters, rowStride, planeCount, rows, rowCount, bitCount, bits);
+}
+
+}  // namespace sdm
@@ -0,0 +1,302 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <immintrin.h>
+
+#include <cstring>
+#include <limits>
+
+#include "./counters_kernels.h"
+#include "./bitslice_avx2.h"
+
+namespace sdm {
+namespace {
+
+/**
+ * Adds one vector of deltas to one of counters. The 8 and 16-bit adds
+ * saturate by themselves, the wider ones skip the counters at their bound.
+ */
+template<typename COUNTER>
+__m256i addLanes(__m256i counters, __m256i deltas, __m256i bounds);
+
+template<>
+inline __m256i addLanes<int8_t>(__m256i counters, __m256i deltas, __m256i) {
+  return _mm256_adds_epi8(counters, deltas);
+}
+
+template<>
+inline __m256i addLanes<int16_t>(__m256i counters, __m256i deltas, __m256i) {
+  return _mm256_adds_epi16(counters, deltas);
+}
+
+template<>
+inline __m256i addLanes<int32_t>(
+  __m256i counters, __m256i deltas, __m256i bounds) {
+  const __m256i saturated = _mm256_cmpeq_epi32(counters, bounds);
+  return _mm256_add_epi32(counters, _mm256_andnot_si256(saturated, deltas));
+}
+
+template<>
+inline __m256i addLanes<int64_t>(
+  __m256i counters, __m256i deltas, __m256i bounds) {
+  const __m256i saturated = _mm256_cmpeq_epi64(counters, bounds);
+  return _mm256_add_epi64(counters, _mm256_andnot_si256(saturated, deltas));
+}
+
+/**
+ * Multiplies each delta, +1, 0 or -1, by the weight.
+ */
+template<typename COUNTER>
+__m256i weighLanes(__m256i weight, __m256i deltas);
+
+template<>
+inline __m256i weighLanes<int8_t>(__m256i weight, __m256i deltas) {
+  return _mm256_sign_epi8(weight, deltas);
+}
+
+template<>
+inline __m256i weighLanes<int16_t>(__m256i weight, __m256i deltas) {
+  return _mm256_sign_epi16(weight, deltas);
+}
+
+template<>
+inline __m256i weighLanes<int32_t>(__m256i weight, __m256i deltas) {
+  return _mm256_sign_epi32(weight, deltas);
+}
+
+template<>
+inline __m256i weighLanes<int64_t>(__m256i weight, __m256i deltas) {
+  // There is no 64-bit sign: zero the weight where the delta is 0, then
+  // negate it where the delta is -1.
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i negative = _mm256_cmpgt_epi64(zero, deltas);
+  const __m256i weighed =
+    _mm256_andnot_si256(_mm256_cmpeq_epi64(deltas, zero), weight);
+  return _mm256_sub_epi64(_mm256_xor_si256(weighed, negative), negative);
+}
+
+/**
+ * Adds one vector of any deltas to one of counters, saturating. A wide add
+ * overflows where the sum's sign differs from both operands'.
+ */
+template<typename COUNTER>
+__m256i addSaturating(__m256i counters, __m256i deltas);
+
+template<>
+inline __m256i addSaturating<int8_t>(__m256i counters, __m256i deltas) {
+  return _mm256_adds_epi8(counters, deltas);
+}
+
+template<>
+inline __m256i addSaturating<int16_t>(__m256i counters, __m256i deltas) {
+  return _mm256_adds_epi16(counters, deltas);
+}
+
+template<>
+inline __m256i addSaturating<int32_t>(__m256i counters, __m256i deltas) {
+  const __m256i sum = _mm256_add_epi32(counters, deltas);
+  const __m256i overflow = _mm256_and_si256(_mm256_xor_si256(counters, sum),
+                                            _mm256_xor_si256(deltas, sum));
+  const __m256i bound = _mm256_xor_si256(
+    _mm256_srai_epi32(counters, 31),
+    _mm256_set1_epi32(std::numeric_limits<int32_t>::max()));
+  return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(sum),
+                                              _mm256_castsi256_ps(bound),
+                                              _mm256_castsi256_ps(overflow)));
+}
+
+template<>
+inline __m256i addSaturating<int64_t>(__m256i counters, __m256i deltas) {
+  const __m256i sum = _mm256_add_epi64(counters, deltas);
+  const __m256i overflow = _mm256_and_si256(_mm256_xor_si256(counters, sum),
+                                            _mm256_xor_si256(deltas, sum));
+  const __m256i bound = _mm256_xor_si256(
+    _mm256_cmpgt_epi64(_mm256_setzero_si256(), counters),
+    _mm256_set1_epi64x(std::numeric_limits<int64_t>::max()));
+  return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(sum),
+                                              _mm256_castsi256_pd(bound),
+                                              _mm256_castsi256_pd(overflow)));
+}
+
+/**
+ * Broadcasts a weight to every lane.
+ */
+inline __m256i broadcast(int8_t weight) { return _mm256_set1_epi8(weight); }
+inline __m256i broadcast(int16_t weight) { return _mm256_set1_epi16(weight); }
+inline __m256i broadcast(int32_t weight) { return _mm256_set1_epi32(weight); }
+inline __m256i broadcast(int64_t weight) {
+  return _mm256_set1_epi64x(weight);
+}
+
+template<typename COUNTER>
+struct Avx2CounterOps {
+  static constexpr size_t LANE_COUNT = sizeof(__m256i) / sizeof(COUNTER);
+
+  static void expand(const WORD_TYPE* bits,
+                     size_t bitCount,
+                     size_t first,
+                     size_t laneCount,
+                     COUNTER* deltas,
+                     COUNTER* bounds) {
+    expandBits(bits, bitCount, first, laneCount, deltas, bounds);
+  }
+
+  static void addRow(COUNTER* row,
+                     const COUNTER* deltas,
+                     const COUNTER* bounds,
+                     size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      __m256i* counters = reinterpret_cast<__m256i*>(row + i);
+      _mm256_storeu_si256(counters, addLanes<COUNTER>(
+        _mm256_loadu_si256(counters),
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(deltas + i)),
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(bounds + i))));
+    }
+  }
+
+  static void addWeightedRow(COUNTER* row,
+                             const COUNTER* deltas,
+                             COUNTER weight,
+                             size_t laneCount) {
+    const __m256i weights = broadcast(weight);
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      __m256i* counters = reinterpret_cast<__m256i*>(row + i);
+      _mm256_storeu_si256(counters, addSaturating<COUNTER>(
+        _mm256_loadu_si256(counters),
+        weighLanes<COUNTER>(weights, _mm256_load_si256(
+          reinterpret_cast<const __m256i*>(deltas + i)))));
+    }
+  }
+};
+
+/**
+ * Loads one vector of SUM lanes worth of counters, sign extended to SUM.
+ */
+template<typename COUNTER, typename SUM>
+__m256i loadWidened(const COUNTER* row);
+
+template<>
+inline __m256i loadWidened<int8_t, int16_t>(const int8_t* row) {
+  return _mm256_cvtepi8_epi16(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m256i loadWidened<int8_t, int32_t>(const int8_t* row) {
+  return _mm256_cvtepi8_epi32(
+    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m256i loadWidened<int8_t, int64_t>(const int8_t* row) {
+  int32_t four;
+  std::memcpy(&four, row, sizeof(four));
+  return _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(four));
+}
+
+template<>
+inline __m256i loadWidened<int16_t, int32_t>(const int16_t* row) {
+  return _mm256_cvtepi16_epi32(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m256i loadWidened<int16_t, int64_t>(const int16_t* row) {
+  return _mm256_cvtepi16_epi64(
+    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m256i loadWidened<int32_t, int64_t>(const int32_t* row) {
+  return _mm256_cvtepi32_epi64(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m256i loadWidened<int64_t, int64_t>(const int64_t* row) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+}
+
+template<typename SUM>
+__m256i addSums(__m256i a, __m256i b);
+
+template<>
+inline __m256i addSums<int16_t>(__m256i a, __m256i b) {
+  return _mm256_add_epi16(a, b);
+}
+
+template<>
+inline __m256i addSums<int32_t>(__m256i a, __m256i b) {
+  return _mm256_add_epi32(a, b);
+}
+
+template<>
+inline __m256i addSums<int64_t>(__m256i a, __m256i b) {
+  return _mm256_add_epi64(a, b);
+}
+
+template<typename COUNTER, typename SUM>
+struct Avx2SumOps {
+  static constexpr size_t LANE_COUNT = sizeof(__m256i) / sizeof(SUM);
+
+  static void accumulateRow(SUM* sums, const COUNTER* row, size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      __m256i* sum = reinterpret_cast<__m256i*>(sums + i);
+      _mm256_store_si256(sum, addSums<SUM>(
+        _mm256_load_si256(sum), loadWidened<COUNTER, SUM>(row + i)));
+    }
+  }
+
+  static void accumulateWeightedRow(SUM* sums,
+                                    const COUNTER* row,
+                                    COUNTER weight,
+                                    size_t laneCount) {
+    if (sizeof(COUNTER) == sizeof(int64_t)) {
+      // No 64-bit multiply.
+      for (size_t i = 0; i < laneCount; i++) {
+        sums[i] += SUM(weight) * row[i];
+      }
+      return;
+    }
+
+    // Both factors fit in the low 32 bits of their 64-bit lanes.
+    const __m256i weights = _mm256_set1_epi64x(weight);
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      __m256i* sum = reinterpret_cast<__m256i*>(sums + i);
+      _mm256_store_si256(sum, _mm256_add_epi64(
+        _mm256_load_si256(sum),
+        _mm256_mul_epi32(loadWidened<COUNTER, int64_t>(row + i), weights)));
+    }
+  }
+
+  static void threshold(const SUM* sums,
+                        size_t first,
+                        size_t laneCount,
+                        WORD_TYPE* bits) {
+    thresholdSums(sums, first, laneCount, bits);
+  }
+};
+
+}  // namespace
+
+const CounterKernels avx2CounterKernels =
+  counterKernels<Avx2CounterOps, Avx2SumOps, Avx2BitSliceOps,
+                 ScalarBitSliceOps>(
+    KernelISA::AVX2);
+
+}  // namespace sdm
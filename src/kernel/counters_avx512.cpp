@@ -0,0 +1,342 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <immintrin.h>
+
+#include <limits>
+
+#include "./counters_kernels.h"
+#include "./bitslice_avx2.h"
+#include "./bitslice_avx512.h"
+
+namespace sdm {
+namespace {
+
+/**
+ * The 512-bit operations on lanes of one counter width, with a lane mask of
+ * one bit per lane. weigh multiplies each delta, +1, 0 or -1, by the weight.
+ * addSaturating adds any deltas, saturating: a wide add overflows where the
+ * sum's sign differs from both operands'.
+ */
+template<typename COUNTER>
+struct Lanes;
+
+template<>
+struct Lanes<int8_t> {
+  typedef __mmask64 Mask;
+  static __m512i set1(int8_t v) { return _mm512_set1_epi8(v); }
+  static __m512i blend(Mask k, __m512i a, __m512i b) {
+    return _mm512_mask_blend_epi8(k, a, b);
+  }
+  static __m512i zeroOutside(Mask k, __m512i a) {
+    return _mm512_maskz_mov_epi8(k, a);
+  }
+  static __m512i weigh(__m512i weight, __m512i deltas) {
+    const __m512i zero = _mm512_setzero_si512();
+    return _mm512_mask_sub_epi8(
+      _mm512_maskz_mov_epi8(_mm512_cmpgt_epi8_mask(deltas, zero), weight),
+      _mm512_cmplt_epi8_mask(deltas, zero), zero, weight);
+  }
+  static __m512i addSaturating(__m512i counters, __m512i deltas) {
+    return _mm512_adds_epi8(counters, deltas);
+  }
+  static __m512i add(__m512i counters, __m512i deltas, __m512i) {
+    return _mm512_adds_epi8(counters, deltas);
+  }
+};
+
+template<>
+struct Lanes<int16_t> {
+  typedef __mmask32 Mask;
+  static __m512i set1(int16_t v) { return _mm512_set1_epi16(v); }
+  static __m512i blend(Mask k, __m512i a, __m512i b) {
+    return _mm512_mask_blend_epi16(k, a, b);
+  }
+  static __m512i zeroOutside(Mask k, __m512i a) {
+    return _mm512_maskz_mov_epi16(k, a);
+  }
+  static __m512i weigh(__m512i weight, __m512i deltas) {
+    const __m512i zero = _mm512_setzero_si512();
+    return _mm512_mask_sub_epi16(
+      _mm512_maskz_mov_epi16(_mm512_cmpgt_epi16_mask(deltas, zero), weight),
+      _mm512_cmplt_epi16_mask(deltas, zero), zero, weight);
+  }
+  static __m512i addSaturating(__m512i counters, __m512i deltas) {
+    return _mm512_adds_epi16(counters, deltas);
+  }
+  static __m512i add(__m512i counters, __m512i deltas, __m512i) {
+    return _mm512_adds_epi16(counters, deltas);
+  }
+};
+
+template<>
+struct Lanes<int32_t> {
+  typedef __mmask16 Mask;
+  static __m512i set1(int32_t v) { return _mm512_set1_epi32(v); }
+  static __m512i blend(Mask k, __m512i a, __m512i b) {
+    return _mm512_mask_blend_epi32(k, a, b);
+  }
+  static __m512i zeroOutside(Mask k, __m512i a) {
+    return _mm512_maskz_mov_epi32(k, a);
+  }
+  static __m512i weigh(__m512i weight, __m512i deltas) {
+    const __m512i zero = _mm512_setzero_si512();
+    return _mm512_mask_sub_epi32(
+      _mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(deltas, zero), weight),
+      _mm512_cmplt_epi32_mask(deltas, zero), zero, weight);
+  }
+  static __m512i addSaturating(__m512i counters, __m512i deltas) {
+    const __m512i sum = _mm512_add_epi32(counters, deltas);
+    const __m512i overflow = _mm512_and_si512(
+      _mm512_xor_si512(counters, sum), _mm512_xor_si512(deltas, sum));
+    const __m512i bound = _mm512_xor_si512(
+      _mm512_srai_epi32(counters, 31),
+      set1(std::numeric_limits<int32_t>::max()));
+    return _mm512_mask_blend_epi32(
+      _mm512_cmplt_epi32_mask(overflow, _mm512_setzero_si512()), sum, bound);
+  }
+  static __m512i add(__m512i counters, __m512i deltas, __m512i bounds) {
+    return _mm512_mask_add_epi32(
+      counters, _mm512_cmpneq_epi32_mask(counters, bounds), counters, deltas);
+  }
+};
+
+template<>
+struct Lanes<int64_t> {
+  typedef __mmask8 Mask;
+  static __m512i set1(int64_t v) { return _mm512_set1_epi64(v); }
+  static __m512i blend(Mask k, __m512i a, __m512i b) {
+    return _mm512_mask_blend_epi64(k, a, b);
+  }
+  static __m512i zeroOutside(Mask k, __m512i a) {
+    return _mm512_maskz_mov_epi64(k, a);
+  }
+  static __m512i weigh(__m512i weight, __m512i deltas) {
+    const __m512i zero = _mm512_setzero_si512();
+    return _mm512_mask_sub_epi64(
+      _mm512_maskz_mov_epi64(_mm512_cmpgt_epi64_mask(deltas, zero), weight),
+      _mm512_cmplt_epi64_mask(deltas, zero), zero, weight);
+  }
+  static __m512i addSaturating(__m512i counters, __m512i deltas) {
+    const __m512i sum = _mm512_add_epi64(counters, deltas);
+    const __m512i overflow = _mm512_and_si512(
+      _mm512_xor_si512(counters, sum), _mm512_xor_si512(deltas, sum));
+    const __m512i bound = _mm512_xor_si512(
+      _mm512_srai_epi64(counters, 63),
+      set1(std::numeric_limits<int64_t>::max()));
+    return _mm512_mask_blend_epi64(
+      _mm512_cmplt_epi64_mask(overflow, _mm512_setzero_si512()), sum, bound);
+  }
+  static __m512i add(__m512i counters, __m512i deltas, __m512i bounds) {
+    return _mm512_mask_add_epi64(
+      counters, _mm512_cmpneq_epi64_mask(counters, bounds), counters, deltas);
+  }
+};
+
+template<typename COUNTER>
+struct Avx512CounterOps {
+  typedef Lanes<COUNTER> L;
+  typedef typename L::Mask Mask;
+  static constexpr size_t LANE_COUNT = sizeof(__m512i) / sizeof(COUNTER);
+
+  /**
+   * @return Mask of the first n lanes.
+   */
+  static Mask firstLanes(size_t n) {
+    return n >= LANE_COUNT ? Mask(~Mask(0)) : Mask((Mask(1) << n) - 1);
+  }
+
+  /**
+   * Expands the data bits of each vector straight from the bit mask: a
+   * vector holds at most one word of bits, and starts on a multiple of its
+   * lane count, so never straddles two words.
+   */
+  static void expand(const WORD_TYPE* bits,
+                     size_t bitCount,
+                     size_t first,
+                     size_t laneCount,
+                     COUNTER* deltas,
+                     COUNTER* bounds) {
+    const __m512i plusOne = L::set1(1);
+    const __m512i minusOne = L::set1(-1);
+    const __m512i max = L::set1(std::numeric_limits<COUNTER>::max());
+    const __m512i min = L::set1(std::numeric_limits<COUNTER>::min());
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      const size_t bit = first + i;
+      const Mask inData = bit < bitCount ? firstLanes(bitCount - bit) : 0;
+      const Mask set = bit < bitCount ?
+        Mask(bits[bit / WORD_BIT_SIZE] >> (bit % WORD_BIT_SIZE)) & inData : 0;
+      _mm512_store_si512(deltas + i,
+                         L::zeroOutside(inData,
+                                        L::blend(set, minusOne, plusOne)));
+      _mm512_store_si512(bounds + i, L::blend(set, min, max));
+    }
+  }
+
+  static void addRow(COUNTER* row,
+                     const COUNTER* deltas,
+                     const COUNTER* bounds,
+                     size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      _mm512_storeu_si512(row + i, L::add(_mm512_loadu_si512(row + i),
+                                          _mm512_load_si512(deltas + i),
+                                          _mm512_load_si512(bounds + i)));
+    }
+  }
+
+  static void addWeightedRow(COUNTER* row,
+                             const COUNTER* deltas,
+                             COUNTER weight,
+                             size_t laneCount) {
+    const __m512i weights = L::set1(weight);
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      _mm512_storeu_si512(row + i, L::addSaturating(
+        _mm512_loadu_si512(row + i),
+        L::weigh(weights, _mm512_load_si512(deltas + i))));
+    }
+  }
+};
+
+/**
+ * Loads one vector of SUM lanes worth of counters, sign extended to SUM.
+ */
+template<typename COUNTER, typename SUM>
+__m512i loadWidened(const COUNTER* row);
+
+template<>
+inline __m512i loadWidened<int8_t, int16_t>(const int8_t* row) {
+  return _mm512_cvtepi8_epi16(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int8_t, int32_t>(const int8_t* row) {
+  return _mm512_cvtepi8_epi32(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int8_t, int64_t>(const int8_t* row) {
+  return _mm512_cvtepi8_epi64(
+    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int16_t, int32_t>(const int16_t* row) {
+  return _mm512_cvtepi16_epi32(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int16_t, int64_t>(const int16_t* row) {
+  return _mm512_cvtepi16_epi64(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int32_t, int64_t>(const int32_t* row) {
+  return _mm512_cvtepi32_epi64(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)));
+}
+
+template<>
+inline __m512i loadWidened<int64_t, int64_t>(const int64_t* row) {
+  return _mm512_loadu_si512(row);
+}
+
+/**
+ * The 512-bit operations on sums of one width.
+ */
+template<typename SUM>
+struct Sums;
+
+template<>
+struct Sums<int16_t> {
+  static __m512i add(__m512i a, __m512i b) { return _mm512_add_epi16(a, b); }
+  static WORD_TYPE positive(__m512i sums) {
+    return _mm512_cmpgt_epi16_mask(sums, _mm512_setzero_si512());
+  }
+};
+
+template<>
+struct Sums<int32_t> {
+  static __m512i add(__m512i a, __m512i b) { return _mm512_add_epi32(a, b); }
+  static WORD_TYPE positive(__m512i sums) {
+    return _mm512_cmpgt_epi32_mask(sums, _mm512_setzero_si512());
+  }
+};
+
+template<>
+struct Sums<int64_t> {
+  static __m512i add(__m512i a, __m512i b) { return _mm512_add_epi64(a, b); }
+  static WORD_TYPE positive(__m512i sums) {
+    return _mm512_cmpgt_epi64_mask(sums, _mm512_setzero_si512());
+  }
+};
+
+template<typename COUNTER, typename SUM>
+struct Avx512SumOps {
+  static constexpr size_t LANE_COUNT = sizeof(__m512i) / sizeof(SUM);
+
+  static void accumulateRow(SUM* sums, const COUNTER* row, size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      _mm512_store_si512(sums + i, Sums<SUM>::add(
+        _mm512_load_si512(sums + i), loadWidened<COUNTER, SUM>(row + i)));
+    }
+  }
+
+  static void accumulateWeightedRow(SUM* sums,
+                                    const COUNTER* row,
+                                    COUNTER weight,
+                                    size_t laneCount) {
+    const __m512i weights = _mm512_set1_epi64(weight);
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      _mm512_store_si512(sums + i, _mm512_add_epi64(
+        _mm512_load_si512(sums + i),
+        _mm512_mullo_epi64(loadWidened<COUNTER, int64_t>(row + i), weights)));
+    }
+  }
+
+  /**
+   * Compares a vector of sums to zero into a mask, which is a vector's worth
+   * of output bits. As in expand, it never straddles two words.
+   */
+  static void threshold(const SUM* sums,
+                        size_t first,
+                        size_t laneCount,
+                        WORD_TYPE* bits) {
+    for (size_t i = 0; i < laneCount; i += LANE_COUNT) {
+      const size_t bit = first + i;
+      const size_t remaining = laneCount - i;
+      const WORD_TYPE inData = remaining >= WORD_BIT_SIZE ? ~WORD_TYPE(0) :
+                               (WORD_TYPE(1) << remaining) - 1;
+      bits[bit / WORD_BIT_SIZE] |=
+        (Sums<SUM>::positive(_mm512_load_si512(sums + i)) & inData) <<
+        (bit % WORD_BIT_SIZE);
+    }
+  }
+};
+
+}  // namespace
+
+const CounterKernels avx512CounterKernels =
+  counterKernels<Avx512CounterOps, Avx512SumOps, Avx512BitSliceOps,
+                 Avx2BitSliceOps>(
+    KernelISA::AVX512_VPOPCNTDQ);
+
+}  // namespace sdm
@@ -0,0 +1,95 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>
+
+#include "./counters_kernels.h"
+
+namespace sdm {
+namespace {
+
+template<typename COUNTER>
+struct ScalarCounterOps {
+  static void expand(const WORD_TYPE* bits,
+                     size_t bitCount,
+                     size_t first,
+                     size_t laneCount,
+                     COUNTER* deltas,
+                     COUNTER* bounds) {
+    expandBits(bits, bitCount, first, laneCount, deltas, bounds);
+  }
+
+  static void addRow(COUNTER* row,
+                     const COUNTER* deltas,
+                     const COUNTER* bounds,
+                     size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i++) {
+      // A mask rather than a product, which vectorizes for every width.
+      row[i] += deltas[i] & -COUNTER(row[i] != bounds[i]);
+    }
+  }
+
+  static void addWeightedRow(COUNTER* row,
+                             const COUNTER* deltas,
+                             COUNTER weight,
+                             size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i++) {
+      const COUNTER delta = static_cast<COUNTER>(deltas[i] * weight);
+      COUNTER sum;
+      if (__builtin_add_overflow(row[i], delta, &sum)) {
+        sum = row[i] < 0 ? std::numeric_limits<COUNTER>::min() :
+              std::numeric_limits<COUNTER>::max();
+      }
+      row[i] = sum;
+    }
+  }
+};
+
+template<typename COUNTER, typename SUM>
+struct ScalarSumOps {
+  static void accumulateRow(SUM* sums, const COUNTER* row, size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i++) {
+      sums[i] += row[i];
+    }
+  }
+
+  static void accumulateWeightedRow(SUM* sums,
+                                    const COUNTER* row,
+                                    COUNTER weight,
+                                    size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i++) {
+      sums[i] += SUM(weight) * row[i];
+    }
+  }
+
+  static void threshold(const SUM* sums,
+                        size_t first,
+                        size_t laneCount,
+                        WORD_TYPE* bits) {
+    thresholdSums(sums, first, laneCount, bits);
+  }
+};
+
+}  // namespace
+
+const CounterKernels genericCounterKernels =
+  counterKernels<ScalarCounterOps, ScalarSumOps, ScalarBitSliceOps,
+                 ScalarBitSliceOps>(
+    KernelISA::GENERIC);
+
+}  // namespace sdm
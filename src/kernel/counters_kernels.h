@@ -0,0 +1,740 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Counter grid kernels, written once against a vector of counters and
+// instantiated by each counters_<isa>.cpp with its own target flags, hence
+// the anonymous namespace. Ops<COUNTER> provides:
+//   expand(bits, bitCount, first, laneCount, deltas, bounds)
+//       sets deltas[i] to +1 if bit first + i is set, -1 if it is clear and
+//       0 past bitCount, and bounds[i] to the bound a counter moving by
+//       deltas[i] saturates at.
+//   addRow(row, deltas, bounds, laneCount)
+//       adds deltas to the laneCount counters of row, except those at their
+//       bound. laneCount fills whole cache lines.
+//   addWeightedRow(row, deltas, weight, laneCount)
+//       adds weight times deltas to the counters of row, saturating.
+// and SumOps<COUNTER, SUM>, for a SUM at least as wide as COUNTER:
+//   accumulateRow(sums, row, laneCount)
+//       adds the laneCount counters of row, widened to SUM, to sums.
+//   accumulateWeightedRow(sums, row, weight, laneCount)
+//       adds weight times the counters of row to sums, for a 64-bit SUM.
+//   threshold(sums, first, laneCount, bits)
+//       sets bit first + i of bits if sums[i] is positive, for i below
+//       laneCount. The bits are clear to begin with.
+// The bit-sliced counters take the BitSliceOps of hamming_bitsliced.h.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "kernel/counters.h"
+#include "kernel/hamming.h"
+#include "./hamming_bitsliced.h"
+#include "./bitslice_scalar.h"
+
+namespace sdm {
+
+/*!\struct CounterKernels
+ * \brief Table of the counter kernels compiled for one instruction set, one
+ *        entry per counter width. See HammingKernels. The weights are
+ *        nullptr for an unweighted write or read.
+ */
+struct CounterKernels {
+  KernelISA isa;
+
+  void (*write8)(int8_t* counters,
+                 size_t rowStride,
+                 const LOCATION_INDEX_TYPE* rows,
+                 const int8_t* weights,
+                 size_t rowCount,
+                 const WORD_TYPE* bits,
+                 size_t bitCount);
+  void (*write16)(int16_t* counters,
+                  size_t rowStride,
+                  const LOCATION_INDEX_TYPE* rows,
+                  const int16_t* weights,
+                  size_t rowCount,
+                  const WORD_TYPE* bits,
+                  size_t bitCount);
+  void (*write32)(int32_t* counters,
+                  size_t rowStride,
+                  const LOCATION_INDEX_TYPE* rows,
+                  const int32_t* weights,
+                  size_t rowCount,
+                  const WORD_TYPE* bits,
+                  size_t bitCount);
+  void (*write64)(int64_t* counters,
+                  size_t rowStride,
+                  const LOCATION_INDEX_TYPE* rows,
+                  const int64_t* weights,
+                  size_t rowCount,
+                  const WORD_TYPE* bits,
+                  size_t bitCount);
+
+  void (*read8)(const int8_t* counters,
+                size_t rowStride,
+                const LOCATION_INDEX_TYPE* rows,
+                const int8_t* weights,
+                size_t rowCount,
+                size_t bitCount,
+                WORD_TYPE* bits);
+  void (*read16)(const int16_t* counters,
+                 size_t rowStride,
+                 const LOCATION_INDEX_TYPE* rows,
+                 const int16_t* weights,
+                 size_t rowCount,
+                 size_t bitCount,
+                 WORD_TYPE* bits);
+  void (*read32)(const int32_t* counters,
+                 size_t rowStride,
+                 const LOCATION_INDEX_TYPE* rows,
+                 const int32_t* weights,
+                 size_t rowCount,
+                 size_t bitCount,
+                 WORD_TYPE* bits);
+  void (*read64)(const int64_t* counters,
+                 size_t rowStride,
+                 const LOCATION_INDEX_TYPE* rows,
+                 const int64_t* weights,
+                 size_t rowCount,
+                 size_t bitCount,
+                 WORD_TYPE* bits);
+
+  void (*writeBitSliced)(WORD_TYPE* counters,
+                         size_t rowStride,
+                         size_t planeCount,
+                         const LOCATION_INDEX_TYPE* rows,
+                         size_t rowCount,
+                         const WORD_TYPE* bits,
+                         size_t bitCount);
+  void (*readBitSliced)(const WORD_TYPE* counters,
+                        size_t rowStride,
+                        size_t planeCount,
+                        const LOCATION_INDEX_TYPE* rows,
+                        size_t rowCount,
+                        size_t bitCount,
+                        WORD_TYPE* bits);
+};
+
+namespace {  // NOLINT(build/namespaces)
+
+/**
+ * Bytes of a row writeCounterRows expands the data of at once. The deltas
+ * and bounds of a block stay in the L1 cache while every row is updated.
+ */
+constexpr size_t COUNTER_BLOCK_BYTE_SIZE = 4096;
+
+/**
+ * Number of rows ahead of the one being added whose block is prefetched.
+ * The activated rows are scattered over the grid, so the hardware prefetcher
+ * cannot predict them.
+ */
+constexpr size_t COUNTER_PREFETCH_ROW_DISTANCE = 8;
+
+/**
+ * Bytes prefetched at the start of a row. The hardware prefetcher follows
+ * the rest of a longer row once it is streamed; prefetching all of it only
+ * crowds out the other rows' requests.
+ */
+constexpr size_t COUNTER_PREFETCH_BYTE_COUNT = 512;
+
+/**
+ * Prefetches the cache lines of the first byteCount bytes of a row.
+ * \tparam FOR_WRITE 1 if the row is about to be written, 0 if only read.
+ */
+template<int FOR_WRITE>
+inline void prefetchRow(const void* row, size_t byteCount) {
+  const char* bytes = static_cast<const char*>(row);
+  for (size_t b = 0; b < byteCount; b += CACHE_LINE_SIZE) {
+    __builtin_prefetch(bytes + b, FOR_WRITE, 3);
+  }
+}
+
+/**
+ * Ops::expand one counter at a time.
+ */
+template<typename COUNTER>
+void expandBits(const WORD_TYPE* bits,
+                size_t bitCount,
+                size_t first,
+                size_t laneCount,
+                COUNTER* deltas,
+                COUNTER* bounds) {
+  for (size_t i = 0; i < laneCount; i++) {
+    const size_t bit = first + i;
+    const bool inData = bit < bitCount;
+    const bool set =
+      inData && ((bits[bit / WORD_BIT_SIZE] >> (bit % WORD_BIT_SIZE)) & 1);
+    deltas[i] = inData ? (set ? 1 : -1) : 0;
+    bounds[i] = set ? std::numeric_limits<COUNTER>::max() :
+                std::numeric_limits<COUNTER>::min();
+  }
+}
+
+template<template<typename> class Ops, typename COUNTER>
+void writeRows(COUNTER* counters,
+               size_t rowStride,
+               const LOCATION_INDEX_TYPE* rows,
+               const COUNTER* weights,
+               size_t rowCount,
+               const WORD_TYPE* bits,
+               size_t bitCount) {
+  constexpr size_t BLOCK_LANE_COUNT = COUNTER_BLOCK_BYTE_SIZE / sizeof(COUNTER);
+  alignas(CACHE_LINE_SIZE) COUNTER deltas[BLOCK_LANE_COUNT];
+  alignas(CACHE_LINE_SIZE) COUNTER bounds[BLOCK_LANE_COUNT];
+
+  for (size_t first = 0; first < bitCount; first += BLOCK_LANE_COUNT) {
+    // The padding of the last block is expanded to 0 and added as is.
+    const size_t laneCount = std::min(BLOCK_LANE_COUNT, rowStride - first);
+    Ops<COUNTER>::expand(bits, bitCount, first, laneCount, deltas, bounds);
+    for (size_t r = 0; r < rowCount; r++) {
+      if (r + COUNTER_PREFETCH_ROW_DISTANCE < rowCount) {
+        prefetchRow<1>(
+          counters + rows[r + COUNTER_PREFETCH_ROW_DISTANCE] * rowStride +
+          first, std::min(laneCount * sizeof(COUNTER),
+                          COUNTER_PREFETCH_BYTE_COUNT));
+      }
+      COUNTER* row = counters + rows[r] * rowStride + first;
+      if (weights) {
+        Ops<COUNTER>::addWeightedRow(row, deltas, weights[r], laneCount);
+      } else {
+        Ops<COUNTER>::addRow(row, deltas, bounds, laneCount);
+      }
+    }
+  }
+}
+
+/**
+ * SumOps::threshold one sum at a time.
+ */
+template<typename SUM>
+void thresholdSums(const SUM* sums,
+                   size_t first,
+                   size_t laneCount,
+                   WORD_TYPE* bits) {
+  for (size_t i = 0; i < laneCount; i++) {
+    const size_t bit = first + i;
+    bits[bit / WORD_BIT_SIZE] |=
+      WORD_TYPE(sums[i] > 0) << (bit % WORD_BIT_SIZE);
+  }
+}
+
+/**
+ * @return Most rows whose counters always add up in SUM, 0 if SUM is
+ *         narrower than COUNTER.
+ */
+template<typename COUNTER, typename SUM>
+constexpr size_t maxSummedRows() {
+  return sizeof(SUM) < sizeof(COUNTER) ? 0 :
+         sizeof(SUM) == sizeof(COUNTER) ? std::numeric_limits<size_t>::max() :
+         static_cast<size_t>(std::numeric_limits<SUM>::max() /
+                             -static_cast<SUM>(
+                               std::numeric_limits<COUNTER>::min()));
+}
+
+/**
+ * @return Largest sum of the weight magnitudes of a weighted read for which
+ *         its 64-bit sums cannot overflow, 0 for 64-bit counters.
+ */
+template<typename COUNTER>
+constexpr uint64_t maxWeightMagnitudeSum() {
+  return sizeof(COUNTER) >= sizeof(int64_t) ? 0 :
+         static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) >>
+         (8 * sizeof(COUNTER) - 1);
+}
+
+/**
+ * @return Whether the weights are within maxWeightMagnitudeSum.
+ */
+template<typename COUNTER>
+bool weightsFitSums(const COUNTER* weights, size_t rowCount) {
+  uint64_t magnitudeSum = 0;
+  for (size_t r = 0; r < rowCount; r++) {
+    const int64_t weight = weights[r];
+    // Stops before it can wrap, a magnitude is at most 2^63.
+    magnitudeSum += weight < 0 ? uint64_t(0) - static_cast<uint64_t>(weight) :
+                    static_cast<uint64_t>(weight);
+    if (magnitudeSum > maxWeightMagnitudeSum<COUNTER>()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!\struct SaturatingSumOps
+ * \brief SumOps of a weighted read whose 64-bit sums could overflow. Each
+ *        product and partial sum saturates instead of wrapping, so a sum
+ *        only loses its sign if it crossed the range of int64_t and came
+ *        back. Scalar, for weights past maxWeightMagnitudeSum only.
+ */
+template<typename COUNTER, typename SUM>
+struct SaturatingSumOps {
+  static void accumulateWeightedRow(SUM* sums,
+                                    const COUNTER* row,
+                                    COUNTER weight,
+                                    size_t laneCount) {
+    for (size_t i = 0; i < laneCount; i++) {
+      SUM product;
+      if (__builtin_mul_overflow(SUM(weight), SUM(row[i]), &product)) {
+        product = (weight < 0) != (row[i] < 0) ?
+                  std::numeric_limits<SUM>::min() :
+                  std::numeric_limits<SUM>::max();
+      }
+      SUM sum;
+      if (__builtin_add_overflow(sums[i], product, &sum)) {
+        sum = product < 0 ? std::numeric_limits<SUM>::min() :
+              std::numeric_limits<SUM>::max();
+      }
+      sums[i] = sum;
+    }
+  }
+
+  static void threshold(const SUM* sums,
+                        size_t first,
+                        size_t laneCount,
+                        WORD_TYPE* bits) {
+    thresholdSums(sums, first, laneCount, bits);
+  }
+};
+
+/**
+ * Adds one row, weighted or not, to the sums. Only instantiates
+ * accumulateWeightedRow for a weighted read.
+ */
+template<typename SumOps, typename COUNTER, typename SUM>
+inline void accumulate(SUM* sums, const COUNTER* row, const COUNTER*,
+                       size_t laneCount, std::false_type) {
+  SumOps::accumulateRow(sums, row, laneCount);
+}
+
+template<typename SumOps, typename COUNTER, typename SUM>
+inline void accumulate(SUM* sums, const COUNTER* row, const COUNTER* weight,
+                       size_t laneCount, std::true_type) {
+  SumOps::accumulateWeightedRow(sums, row, *weight, laneCount);
+}
+
+template<template<typename, typename> class SumOps,
+         typename COUNTER,
+         typename SUM,
+         bool WEIGHTED>
+void readRowsAs(const COUNTER* counters,
+                size_t rowStride,
+                const LOCATION_INDEX_TYPE* rows,
+                const COUNTER* weights,
+                size_t rowCount,
+                size_t bitCount,
+                WORD_TYPE* bits) {
+  constexpr size_t BLOCK_LANE_COUNT = COUNTER_BLOCK_BYTE_SIZE / sizeof(SUM);
+  alignas(CACHE_LINE_SIZE) SUM sums[BLOCK_LANE_COUNT];
+
+  std::fill(bits, bits + wordCount(bitCount), WORD_TYPE(0));
+  for (size_t first = 0; first < bitCount; first += BLOCK_LANE_COUNT) {
+    const size_t laneCount = std::min(BLOCK_LANE_COUNT, rowStride - first);
+    std::fill(sums, sums + laneCount, SUM(0));
+    for (size_t r = 0; r < rowCount; r++) {
+      if (r + COUNTER_PREFETCH_ROW_DISTANCE < rowCount) {
+        prefetchRow<0>(
+          counters + rows[r + COUNTER_PREFETCH_ROW_DISTANCE] * rowStride +
+          first, std::min(laneCount * sizeof(COUNTER),
+                          COUNTER_PREFETCH_BYTE_COUNT));
+      }
+      accumulate<SumOps<COUNTER, SUM>>(
+        sums, counters + rows[r] * rowStride + first,
+        WEIGHTED ? weights + r : nullptr,
+        laneCount, std::integral_constant<bool, WEIGHTED>());
+    }
+    SumOps<COUNTER, SUM>::threshold(
+      sums, first, std::min(laneCount, bitCount - first), bits);
+  }
+}
+
+/**
+ * Sums the rows in the narrowest of SUM, WIDER... that cannot overflow for
+ * rowCount rows: the narrower the sums, the more lanes per vector.
+ */
+template<template<typename, typename> class SumOps,
+         typename COUNTER,
+         typename SUM>
+void readRowsNarrowest(const COUNTER* counters,
+                       size_t rowStride,
+                       const LOCATION_INDEX_TYPE* rows,
+                       size_t rowCount,
+                       size_t bitCount,
+                       WORD_TYPE* bits) {
+  readRowsAs<SumOps, COUNTER, SUM, false>(
+    counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+}
+
+template<template<typename, typename> class SumOps,
+         typename COUNTER,
+         typename SUM,
+         typename WIDER,
+         typename... WIDEST>
+void readRowsNarrowest(const COUNTER* counters,
+                       size_t rowStride,
+                       const LOCATION_INDEX_TYPE* rows,
+                       size_t rowCount,
+                       size_t bitCount,
+                       WORD_TYPE* bits) {
+  if (rowCount <= maxSummedRows<COUNTER, SUM>()) {
+    readRowsAs<SumOps, COUNTER, SUM, false>(
+      counters, rowStride, rows, nullptr, rowCount, bitCount, bits);
+  } else {
+    readRowsNarrowest<SumOps, COUNTER, WIDER, WIDEST...>(
+      counters, rowStride, rows, rowCount, bitCount, bits);
+  }
+}
+
+/**
+ * Weighted rows are summed in 64 bits, with SaturatingSumOps if the weights
+ * are too large for the sums to be exact, unweighted ones in the narrowest
+ * of SUMS... that holds them.
+ */
+template<template<typename, typename> class SumOps,
+         typename COUNTER,
+         typename... SUMS>
+void readRows(const COUNTER* counters,
+              size_t rowStride,
+              const LOCATION_INDEX_TYPE* rows,
+              const COUNTER* weights,
+              size_t rowCount,
+              size_t bitCount,
+              WORD_TYPE* bits) {
+  if (weights && weightsFitSums(weights, rowCount)) {
+    readRowsAs<SumOps, COUNTER, int64_t, true>(
+      counters, rowStride, rows, weights, rowCount, bitCount, bits);
+  } else if (weights) {
+    readRowsAs<SaturatingSumOps, COUNTER, int64_t, true>(
+      counters, rowStride, rows, weights, rowCount, bitCount, bits);
+  } else {
+    readRowsNarrowest<SumOps, COUNTER, SUMS...>(
+      counters, rowStride, rows, rowCount, bitCount, bits);
+  }
+}
+
+/**
+ * Number of words of each bit-plane the bit-sliced kernels update or sum
+ * across all rows at once, four cache lines. The sums of a pass stay in the
+ * L1 cache.
+ */
+constexpr size_t BIT_SLICED_PASS_WORD_COUNT = 32;
+
+/**
+ * Most bit-planes of a sum of bit-sliced counters, those of a counter plus
+ * one per bit of the row count.
+ */
+constexpr size_t MAX_BIT_SLICED_SUM_PLANE_COUNT =
+  MAX_BIT_SLICED_COUNTER_PLANE_COUNT + 8 * sizeof(size_t);
+
+/**
+ * @return Number of bits of n, which is not 0.
+ */
+inline size_t bitWidth(size_t n) {
+  return 8 * sizeof(size_t) - __builtin_clzll(n);
+}
+
+/**
+ * Adds -1 to the counters whose bit of down is set and +1 to the others,
+ * for the counters of valid only, except those at their bound.
+ * @param planes Lowest bit-plane of the counters, the next planeWordCount
+ *               words further.
+ */
+template<typename Ops>
+inline void addBitSliced(WORD_TYPE* planes,
+                         size_t planeWordCount,
+                         size_t planeCount,
+                         const WORD_TYPE* down,
+                         const WORD_TYPE* valid) {
+  typedef typename Ops::Vector Vector;
+
+  // An increment carries through the set bits of a counter and a decrement
+  // borrows through the clear ones: toward[k] is set where bit k passes the
+  // carry or borrow on. A counter at its bound would carry or borrow into
+  // its sign bit alone, low is set where every bit below it passes it on.
+  const Vector downLanes = Ops::load(down);
+  const size_t top = planeCount - 1;
+  Vector plane[MAX_BIT_SLICED_COUNTER_PLANE_COUNT];
+  Vector toward[MAX_BIT_SLICED_COUNTER_PLANE_COUNT];
+  Vector low = Ops::broadcast(~WORD_TYPE(0));
+  for (size_t k = 0; k < top; k++) {
+    plane[k] = Ops::load(planes + k * planeWordCount);
+    toward[k] = Ops::bitXor(plane[k], downLanes);
+    low = Ops::bitAnd(low, toward[k]);
+  }
+  plane[top] = Ops::load(planes + top * planeWordCount);
+  toward[top] = Ops::bitXor(plane[top], downLanes);
+  Vector carry = Ops::andNot(Ops::andNot(toward[top], low), Ops::load(valid));
+
+  for (size_t k = 0; k < planeCount; k++) {
+    Ops::store(planes + k * planeWordCount, Ops::bitXor(plane[k], carry));
+    carry = Ops::bitAnd(carry, toward[k]);
+  }
+}
+
+/**
+ * Adds the counters of a row, offset to unsigned values by flipping their
+ * sign bit, to the sums: a full adder per bit-plane of the counters, then
+ * the carry ripples through the sumPlaneCount - planeCount planes above.
+ * @param sums Lowest bit-plane of the sums, the next
+ *             BIT_SLICED_PASS_WORD_COUNT words further.
+ */
+template<typename Ops>
+inline void accumulateBitSliced(const WORD_TYPE* planes,
+                                size_t planeWordCount,
+                                size_t planeCount,
+                                size_t sumPlaneCount,
+                                WORD_TYPE* sums) {
+  typedef typename Ops::Vector Vector;
+  const size_t top = planeCount - 1;
+  Vector carry = Ops::zero();
+  for (size_t k = 0; k < planeCount; k++) {
+    Vector plane = Ops::load(planes + k * planeWordCount);
+    if (k == top) {
+      plane = Ops::andNot(plane, Ops::broadcast(~WORD_TYPE(0)));
+    }
+    Vector sum;
+    WORD_TYPE* sumPlane = sums + k * BIT_SLICED_PASS_WORD_COUNT;
+    Ops::carrySaveAdd(Ops::load(sumPlane), plane, carry, &carry, &sum);
+    Ops::store(sumPlane, sum);
+  }
+  for (size_t k = planeCount; k < sumPlaneCount; k++) {
+    WORD_TYPE* sumPlane = sums + k * BIT_SLICED_PASS_WORD_COUNT;
+    const Vector sum = Ops::load(sumPlane);
+    Ops::store(sumPlane, Ops::bitXor(sum, carry));
+    carry = Ops::bitAnd(sum, carry);
+  }
+}
+
+/**
+ * Sets the bits whose sum of rowCount offset counters is above the sum of
+ * their offsets, rowCount << (planeCount - 1), comparing from the most
+ * significant bit-plane down.
+ */
+template<typename Ops>
+inline void aboveOffset(const WORD_TYPE* sums,
+                        size_t sumPlaneCount,
+                        size_t planeCount,
+                        size_t rowCount,
+                        WORD_TYPE* bits) {
+  typename Ops::Vector above = Ops::zero();
+  typename Ops::Vector equal = Ops::broadcast(~WORD_TYPE(0));
+  for (size_t k = sumPlaneCount; k-- > 0;) {
+    const typename Ops::Vector sum =
+      Ops::load(sums + k * BIT_SLICED_PASS_WORD_COUNT);
+    if (k + 1 >= planeCount && ((rowCount >> (k + 1 - planeCount)) & 1)) {
+      equal = Ops::bitAnd(equal, sum);
+    } else {
+      above = Ops::bitOr(above, Ops::bitAnd(equal, sum));
+      equal = Ops::andNot(sum, equal);
+    }
+  }
+  Ops::store(bits, above);
+}
+
+/**
+ * @return Bytes of each bit-plane of a pass over wordCount words to
+ *         prefetch, a share of COUNTER_PREFETCH_BYTE_COUNT.
+ */
+inline size_t planePrefetchByteCount(size_t planeCount, size_t wordCount) {
+  const size_t share = COUNTER_PREFETCH_BYTE_COUNT / planeCount;
+  return std::min(wordCount * sizeof(WORD_TYPE),
+                  share < CACHE_LINE_SIZE ? CACHE_LINE_SIZE : share);
+}
+
+/**
+ * Prefetches the first byteCount bytes of each bit-plane of a row. Kept
+ * small so that it is inlined before GCC, which sees no side effect in a
+ * prefetch, drops a call to it.
+ * \tparam FOR_WRITE 1 if the row is about to be written, 0 if only read.
+ */
+template<int FOR_WRITE>
+inline void prefetchPlanes(const WORD_TYPE* planes,
+                           size_t planeWordCount,
+                           size_t planeCount,
+                           size_t byteCount) {
+  for (size_t k = 0; k < planeCount; k++) {
+    prefetchRow<FOR_WRITE>(planes + k * planeWordCount, byteCount);
+  }
+}
+
+/**
+ * Calls Step::template apply<O>(w, args...) for the words w of [0, count)
+ * of a pass, O being Ops for as many whole vectors as fit, then HalfOps,
+ * then ScalarBitSliceOps for the words left over.
+ */
+template<typename Ops, typename HalfOps, typename Step, typename... Args>
+inline void forEachVector(size_t count, Args... args) {
+  size_t w = 0;
+  for (; w + Ops::WORD_COUNT <= count; w += Ops::WORD_COUNT) {
+    Step::template apply<Ops>(w, args...);
+  }
+  for (; w + HalfOps::WORD_COUNT <= count; w += HalfOps::WORD_COUNT) {
+    Step::template apply<HalfOps>(w, args...);
+  }
+  for (; w < count; w++) {
+    Step::template apply<ScalarBitSliceOps>(w, args...);
+  }
+}
+
+struct AddBitSlicedStep {
+  template<typename Ops>
+  static void apply(size_t w, WORD_TYPE* planes, size_t planeWordCount,
+                    size_t planeCount, const WORD_TYPE* down,
+                    const WORD_TYPE* valid) {
+    addBitSliced<Ops>(planes + w, planeWordCount, planeCount, down + w,
+                      valid + w);
+  }
+};
+
+struct AccumulateBitSlicedStep {
+  template<typename Ops>
+  static void apply(size_t w, const WORD_TYPE* planes, size_t planeWordCount,
+                    size_t planeCount, size_t sumPlaneCount,
+                    WORD_TYPE* sums) {
+    accumulateBitSliced<Ops>(planes + w, planeWordCount, planeCount,
+                             sumPlaneCount, sums + w);
+  }
+};
+
+struct AboveOffsetStep {
+  template<typename Ops>
+  static void apply(size_t w, const WORD_TYPE* sums, size_t sumPlaneCount,
+                    size_t planeCount, size_t rowCount, WORD_TYPE* bits) {
+    aboveOffset<Ops>(sums + w, sumPlaneCount, planeCount, rowCount,
+                     bits + w);
+  }
+};
+
+template<typename Ops, typename HalfOps>
+void writeBitSlicedRows(WORD_TYPE* counters,
+                        size_t rowStride,
+                        size_t planeCount,
+                        const LOCATION_INDEX_TYPE* rows,
+                        size_t rowCount,
+                        const WORD_TYPE* bits,
+                        size_t bitCount) {
+  const size_t planeWordCount = wordCount(bitCount);
+  alignas(CACHE_LINE_SIZE) WORD_TYPE down[BIT_SLICED_PASS_WORD_COUNT];
+  alignas(CACHE_LINE_SIZE) WORD_TYPE valid[BIT_SLICED_PASS_WORD_COUNT];
+
+  for (size_t first = 0; first < planeWordCount;
+       first += BIT_SLICED_PASS_WORD_COUNT) {
+    const size_t count =
+      std::min(BIT_SLICED_PASS_WORD_COUNT, planeWordCount - first);
+    for (size_t w = 0; w < count; w++) {
+      const size_t bitsLeft = bitCount - (first + w) * WORD_BIT_SIZE;
+      valid[w] = bitsLeft >= WORD_BIT_SIZE ? ~WORD_TYPE(0) :
+                 (WORD_TYPE(1) << bitsLeft) - 1;
+      down[w] = ~bits[first + w];
+    }
+    const size_t prefetchByteCount = planePrefetchByteCount(planeCount, count);
+
+    for (size_t r = 0; r < rowCount; r++) {
+      if (r + COUNTER_PREFETCH_ROW_DISTANCE < rowCount) {
+        prefetchPlanes<1>(
+          counters + rows[r + COUNTER_PREFETCH_ROW_DISTANCE] * rowStride +
+          first, planeWordCount, planeCount, prefetchByteCount);
+      }
+      forEachVector<Ops, HalfOps, AddBitSlicedStep>(
+        count, counters + rows[r] * rowStride + first, planeWordCount,
+        planeCount, static_cast<const WORD_TYPE*>(down),
+        static_cast<const WORD_TYPE*>(valid));
+    }
+  }
+}
+
+template<typename Ops, typename HalfOps>
+void readBitSlicedRows(const WORD_TYPE* counters,
+                       size_t rowStride,
+                       size_t planeCount,
+                       const LOCATION_INDEX_TYPE* rows,
+                       size_t rowCount,
+                       size_t bitCount,
+                       WORD_TYPE* bits) {
+  const size_t planeWordCount = wordCount(bitCount);
+  if (rowCount == 0) {
+    std::fill(bits, bits + planeWordCount, WORD_TYPE(0));
+    return;
+  }
+  const size_t sumPlaneCount = planeCount + bitWidth(rowCount);
+  alignas(CACHE_LINE_SIZE) WORD_TYPE
+    sums[MAX_BIT_SLICED_SUM_PLANE_COUNT * BIT_SLICED_PASS_WORD_COUNT];
+
+  for (size_t first = 0; first < planeWordCount;
+       first += BIT_SLICED_PASS_WORD_COUNT) {
+    const size_t count =
+      std::min(BIT_SLICED_PASS_WORD_COUNT, planeWordCount - first);
+    std::fill(sums, sums + sumPlaneCount * BIT_SLICED_PASS_WORD_COUNT,
+              WORD_TYPE(0));
+    const size_t prefetchByteCount = planePrefetchByteCount(planeCount, count);
+
+    for (size_t r = 0; r < rowCount; r++) {
+      if (r + COUNTER_PREFETCH_ROW_DISTANCE < rowCount) {
+        prefetchPlanes<0>(
+          counters + rows[r + COUNTER_PREFETCH_ROW_DISTANCE] * rowStride +
+          first, planeWordCount, planeCount, prefetchByteCount);
+      }
+      // The first r + 1 rows add up to less than (r + 1) << planeCount.
+      forEachVector<Ops, HalfOps, AccumulateBitSlicedStep>(
+        count, counters + rows[r] * rowStride + first, planeWordCount,
+        planeCount, planeCount + bitWidth(r + 1),
+        static_cast<WORD_TYPE*>(sums));
+    }
+
+    forEachVector<Ops, HalfOps, AboveOffsetStep>(
+      count, static_cast<const WORD_TYPE*>(sums), sumPlaneCount, planeCount,
+      rowCount, bits + first);
+  }
+}
+
+/**
+ * @return The table of writeRows and readRows instantiated for each counter
+ *         width, and of the bit-sliced kernels instantiated for BitSliceOps
+ *         and, for the words left over, HalfBitSliceOps.
+ */
+template<template<typename> class Ops,
+         template<typename, typename> class SumOps,
+         typename BitSliceOps,
+         typename HalfBitSliceOps>
+constexpr CounterKernels counterKernels(KernelISA isa) {
+  return CounterKernels{
+    isa,
+    writeRows<Ops, int8_t>,
+    writeRows<Ops, int16_t>,
+    writeRows<Ops, int32_t>,
+    writeRows<Ops, int64_t>,
+    readRows<SumOps, int8_t, int16_t, int32_t, int64_t>,
+    readRows<SumOps, int16_t, int32_t, int64_t>,
+    readRows<SumOps, int32_t, int64_t>,
+    readRows<SumOps, int64_t, int64_t>,
+    writeBitSlicedRows<BitSliceOps, HalfBitSliceOps>,
+    readBitSlicedRows<BitSliceOps, HalfBitSliceOps>
+  };
+}
+
+}  // namespace
+
+extern const CounterKernels genericCounterKernels;
+extern const CounterKernels avx2CounterKernels;
+extern const CounterKernels avx512CounterKernels;
+
+}  // namespace sdm
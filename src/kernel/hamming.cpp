@@ -0,0 +1,653 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "kernel/hamming.h"
+#include "./hamming_kernels.h"
+
+namespace sdm {
+namespace {
+
+/**
+ * Number of locations activateLocations hands to a kernel at once. The
+ * kernel compacts into a buffer of this size on the stack.
+ */
+constexpr size_t ACTIVATION_CHUNK_SIZE = 2048;
+
+/**
+ * Number of slices activateBitSliced hands to the kernel at once.
+ */
+constexpr size_t BIT_SLICE_CHUNK_SIZE =
+  ACTIVATION_CHUNK_SIZE / BIT_SLICE_LOCATION_COUNT;
+
+/**
+ * Entries of the per-address mismatch table of activateSelectedCoordinates,
+ * two per address bit. Wider addresses test the bits in place.
+ */
+constexpr size_t SELECTED_COORDINATE_TABLE_SIZE = 8192;
+
+/**
+ * Transposes a 64 x 64 bit matrix in place: bit j of words[i] ends up as bit
+ * i of words[j] (Hacker's Delight, 7-3).
+ */
+void transpose64(WORD_TYPE* words) {
+  WORD_TYPE mask = 0x00000000ffffffffULL;
+  for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      const WORD_TYPE t = ((words[k] >> j) ^ words[k | j]) & mask;
+      words[k] ^= t << j;
+      words[k | j] ^= t;
+    }
+  }
+}
+
+/**
+ * @return The kernel table compiled for isa, nullptr if it is not compiled.
+ */
+const HammingKernels* compiledKernels(KernelISA isa) {
+  switch (isa) {
+    case KernelISA::GENERIC:
+      return &genericHammingKernels;
+#ifdef SDM_KERNEL_POPCNT
+    case KernelISA::POPCNT:
+      return &popcntHammingKernels;
+#endif
+#ifdef SDM_KERNEL_AVX2
+    case KernelISA::AVX2:
+      return &avx2HammingKernels;
+#endif
+#ifdef SDM_KERNEL_AVX512
+    case KernelISA::AVX512_VPOPCNTDQ:
+      return &avx512HammingKernels;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+bool cpuSupports(KernelISA isa) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  switch (isa) {
+    case KernelISA::GENERIC:
+      return true;
+    case KernelISA::POPCNT:
+      return __builtin_cpu_supports("popcnt");
+    case KernelISA::AVX2:
+      return __builtin_cpu_supports("avx2") &&
+             __builtin_cpu_supports("popcnt");
+    case KernelISA::AVX512_VPOPCNTDQ:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512vl") &&
+             __builtin_cpu_supports("avx512dq") &&
+             __builtin_cpu_supports("avx512bw") &&
+             __builtin_cpu_supports("avx512vpopcntdq") &&
+             __builtin_cpu_supports("popcnt");
+  }
+  return false;
+#else
+  return isa == KernelISA::GENERIC;
+#endif
+}
+
+const HammingKernels* bestKernels() {
+  const KernelISA preference[] = {
+    KernelISA::AVX512_VPOPCNTDQ,
+    KernelISA::AVX2,
+    KernelISA::POPCNT
+  };
+  for (KernelISA isa : preference) {
+    if (isKernelISASupported(isa)) {
+      return compiledKernels(isa);
+    }
+  }
+  return &genericHammingKernels;
+}
+
+std::atomic<const HammingKernels*>& activeKernels() {
+  static std::atomic<const HammingKernels*> kernels(bestKernels());
+  return kernels;
+}
+
+/**
+ * Appends the indices of the locations whose bit is set in masks.
+ * @param masks BIT_SLICE_WORD_COUNT words per slice, see
+ *              bitSlicedActivationMasks.
+ * @param sliceCount Number of slices of masks, at most BIT_SLICE_CHUNK_SIZE.
+ * @param firstLocation Index of the first location of masks.
+ * @param locationCount Number of locations of the whole matrix. The bits of
+ *                      the locations past it in the last slice are padding.
+ * @param activated Output, the indices are appended to it.
+ */
+void appendMaskedLocations(const WORD_TYPE* masks,
+                           size_t sliceCount,
+                           size_t firstLocation,
+                           size_t locationCount,
+                           activationList* activated) {
+  LOCATION_INDEX_TYPE chunk[ACTIVATION_CHUNK_SIZE];
+  const size_t remaining = locationCount - firstLocation;
+  size_t activatedCount = 0;
+  for (size_t w = 0;
+       w < sliceCount * BIT_SLICE_WORD_COUNT && w * WORD_BIT_SIZE < remaining;
+       w++) {
+    WORD_TYPE mask = masks[w];
+    if (remaining - w * WORD_BIT_SIZE < WORD_BIT_SIZE) {
+      mask &= lastWordMask(remaining);
+    }
+    for (; mask != 0; mask &= mask - 1) {
+      chunk[activatedCount++] = static_cast<LOCATION_INDEX_TYPE>(
+        firstLocation + w * WORD_BIT_SIZE + __builtin_ctzll(mask));
+    }
+  }
+  activated->insert(activated->end(), chunk, chunk + activatedCount);
+}
+
+/**
+ * Compacts the indices of the locations of a chunk whose selected-coordinate
+ * distance is within threshold, reading the mismatches from a table indexed
+ * by coordinate.
+ * \tparam SELECTED_BIT_COUNT Number of selected bits per location, or 0 to
+ *         take it from selectedBitCount. A constant count unrolls the sum.
+ * @param coordinates Coordinates of all the locations.
+ * @param first Index of the first location of the chunk.
+ * @param count Number of locations of the chunk.
+ * @param selectedBitCount Number of selected bits per location.
+ * @param mismatches Entry c is 1 if the address mismatches coordinate c.
+ * @param threshold Maximum distance of an activated location.
+ * @param activated Output, the indices of the activated locations.
+ * @return Number of activated locations.
+ */
+template<size_t SELECTED_BIT_COUNT>
+size_t selectCoordinates(const uint16_t* coordinates,
+                         size_t first,
+                         size_t count,
+                         size_t selectedBitCount,
+                         const uint8_t* mismatches,
+                         size_t threshold,
+                         LOCATION_INDEX_TYPE* activated) {
+  const size_t k = SELECTED_BIT_COUNT ? SELECTED_BIT_COUNT : selectedBitCount;
+  const uint16_t* location = coordinates + first * k;
+  size_t activatedCount = 0;
+  for (size_t i = 0; i < count; i++, location += k) {
+    size_t distance = 0;
+    for (size_t j = 0; j < k; j++) {
+      distance += mismatches[location[j]];
+    }
+    activated[activatedCount] = static_cast<LOCATION_INDEX_TYPE>(first + i);
+    activatedCount += distance <= threshold;
+  }
+  return activatedCount;
+}
+
+typedef size_t (*SelectCoordinates)(const uint16_t*, size_t, size_t, size_t,
+                                    const uint8_t*, size_t,
+                                    LOCATION_INDEX_TYPE*);
+
+/**
+ * Largest selected bit count with an unrolled selectCoordinates.
+ */
+constexpr size_t SELECTED_COORDINATE_UNROLLED_COUNT = 16;
+
+/**
+ * selectCoordinates unrolled for each count up to
+ * SELECTED_COORDINATE_UNROLLED_COUNT, indexed by count.
+ */
+const SelectCoordinates selectCoordinatesUnrolled[] = {
+  selectCoordinates<0>, selectCoordinates<1>, selectCoordinates<2>,
+  selectCoordinates<3>, selectCoordinates<4>, selectCoordinates<5>,
+  selectCoordinates<6>, selectCoordinates<7>, selectCoordinates<8>,
+  selectCoordinates<9>, selectCoordinates<10>, selectCoordinates<11>,
+  selectCoordinates<12>, selectCoordinates<13>, selectCoordinates<14>,
+  selectCoordinates<15>, selectCoordinates<16>
+};
+
+/**
+ * selectCoordinates for addresses too wide for the mismatch table: tests
+ * each selected bit in the address words.
+ */
+size_t selectCoordinatesInPlace(const uint16_t* coordinates,
+                                size_t first,
+                                size_t count,
+                                size_t selectedBitCount,
+                                const WORD_TYPE* address,
+                                size_t threshold,
+                                LOCATION_INDEX_TYPE* activated) {
+  const uint16_t* location = coordinates + first * selectedBitCount;
+  size_t activatedCount = 0;
+  for (size_t i = 0; i < count; i++, location += selectedBitCount) {
+    size_t distance = 0;
+    for (size_t j = 0; j < selectedBitCount; j++) {
+      const size_t bit = location[j] >> 1;
+      distance += ((address[bit / WORD_BIT_SIZE] >> (bit % WORD_BIT_SIZE)) ^
+                   location[j]) & 1;
+    }
+    activated[activatedCount] = static_cast<LOCATION_INDEX_TYPE>(first + i);
+    activatedCount += distance <= threshold;
+  }
+  return activatedCount;
+}
+
+}  // namespace
+
+bool isKernelISASupported(KernelISA isa) {
+  return compiledKernels(isa) != nullptr && cpuSupports(isa);
+}
+
+KernelISA getKernelISA() {
+  return activeKernels().load(std::memory_order_relaxed)->isa;
+}
+
+void setKernelISA(KernelISA isa) {
+  if (!isKernelISASupported(isa)) {
+    throw std::invalid_argument("Kernel instruction set not supported.");
+  }
+  activeKernels().store(compiledKernels(isa), std::memory_order_relaxed);
+}
+
+void hammingDistances(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  activeKernels().load(std::memory_order_relaxed)->distances(
+    locations, locationCount, wordCount, address, distances);
+}
+
+void activateLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) {
+  activateLocations(locations, locationCount, wordCount, address, threshold,
+                    nullptr, activated);
+}
+
+void activateLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  const size_t* blockOrder,
+  activationList* activated) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  threshold = std::min(threshold, wordCount * WORD_BIT_SIZE);
+
+  activated->clear();
+  LOCATION_INDEX_TYPE chunk[ACTIVATION_CHUNK_SIZE];
+  for (size_t first = 0; first < locationCount;
+       first += ACTIVATION_CHUNK_SIZE) {
+    const size_t count = std::min(ACTIVATION_CHUNK_SIZE, locationCount - first);
+    const WORD_TYPE* chunkLocations = locations + first * wordCount;
+    const LOCATION_INDEX_TYPE firstIndex =
+      static_cast<LOCATION_INDEX_TYPE>(first);
+    const size_t activatedCount = blockOrder == nullptr ?
+      kernels->activate(chunkLocations, count, wordCount, address, threshold,
+                        firstIndex, chunk) :
+      kernels->activateEarlyExit(chunkLocations, count, wordCount, address,
+                                 threshold, blockOrder, firstIndex, chunk);
+    activated->insert(activated->end(), chunk, chunk + activatedCount);
+  }
+}
+
+void activateNearestLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated) {
+  std::vector<uint16_t> distances;
+  std::vector<size_t> histogram;
+  activateNearestLocations(locations, locationCount, wordCount, address,
+                           count, activated, &distances, &histogram);
+}
+
+void activateNearestLocations(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t count,
+  activationList* activated,
+  std::vector<uint16_t>* distances,
+  std::vector<size_t>* histogram) {
+  const size_t maxDistance = wordCount * WORD_BIT_SIZE;
+  if (maxDistance > std::numeric_limits<uint16_t>::max()) {
+    throw std::invalid_argument("Distances must fit in 16 bits.");
+  }
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  count = std::min(count, locationCount);
+
+  activated->clear();
+  if (count == 0) {
+    return;
+  }
+
+  // Distances and their histogram, in one pass over the locations.
+  distances->resize(locationCount);
+  histogram->assign(maxDistance + 1, 0);
+  uint16_t* distanceData = distances->data();
+  size_t* counts = histogram->data();
+  size_t chunk[ACTIVATION_CHUNK_SIZE];
+  for (size_t first = 0; first < locationCount;
+       first += ACTIVATION_CHUNK_SIZE) {
+    const size_t chunkCount =
+      std::min(ACTIVATION_CHUNK_SIZE, locationCount - first);
+    kernels->distances(locations + first * wordCount, chunkCount, wordCount,
+                       address, chunk);
+    for (size_t i = 0; i < chunkCount; i++) {
+      distanceData[first + i] = static_cast<uint16_t>(chunk[i]);
+      counts[chunk[i]]++;
+    }
+  }
+
+  // The radius is the smallest distance with at least count locations
+  // within it. Only part of the locations at the radius may fit.
+  size_t radius = 0;
+  size_t within = counts[0];
+  while (within < count) {
+    within += counts[++radius];
+  }
+  size_t ties = count - (within - counts[radius]);
+
+  activated->resize(count);
+  LOCATION_INDEX_TYPE* indices = activated->data();
+  size_t activatedCount = 0;
+  for (size_t i = 0; activatedCount < count; i++) {
+    const size_t tie = (distanceData[i] == radius) & (ties > 0);
+    indices[activatedCount] = static_cast<LOCATION_INDEX_TYPE>(i);
+    activatedCount += (distanceData[i] < radius) | tie;
+    ties -= tie;
+  }
+}
+
+void activateLocationsBatch(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  activationList* activated) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  threshold = std::min(threshold, wordCount * WORD_BIT_SIZE);
+
+  for (size_t q = 0; q < addressCount; q++) {
+    activated[q].clear();
+  }
+
+  const size_t tileSize = std::max<size_t>(1, std::min(
+    BATCH_TILE_LOCATION_COUNT,
+    BATCH_TILE_BYTE_SIZE / (wordCount * sizeof(WORD_TYPE))));
+  LOCATION_INDEX_TYPE
+    chunks[BATCH_QUERY_BLOCK_SIZE][BATCH_TILE_LOCATION_COUNT];
+  LOCATION_INDEX_TYPE* chunkPointers[BATCH_QUERY_BLOCK_SIZE];
+  for (size_t q = 0; q < BATCH_QUERY_BLOCK_SIZE; q++) {
+    chunkPointers[q] = chunks[q];
+  }
+  size_t counts[BATCH_QUERY_BLOCK_SIZE];
+
+  for (size_t first = 0; first < locationCount; first += tileSize) {
+    const size_t count = std::min(tileSize, locationCount - first);
+    for (size_t q = 0; q < addressCount; q += BATCH_QUERY_BLOCK_SIZE) {
+      const size_t blockSize =
+        std::min(BATCH_QUERY_BLOCK_SIZE, addressCount - q);
+      kernels->activateBatch(
+        locations + first * wordCount, count, wordCount,
+        addresses + q * wordCount, blockSize, threshold,
+        static_cast<LOCATION_INDEX_TYPE>(first), chunkPointers, counts);
+      for (size_t b = 0; b < blockSize; b++) {
+        activated[q + b].insert(
+          activated[q + b].end(), chunks[b], chunks[b] + counts[b]);
+      }
+    }
+  }
+}
+
+void hammingDistanceHistogram(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t* histogram) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  std::fill(histogram, histogram + wordCount * WORD_BIT_SIZE + 1, 0);
+
+  const size_t tileSize = std::max<size_t>(1, std::min(
+    BATCH_TILE_LOCATION_COUNT,
+    BATCH_TILE_BYTE_SIZE / (wordCount * sizeof(WORD_TYPE))));
+  size_t chunk[BATCH_TILE_LOCATION_COUNT];
+  for (size_t first = 0; first < locationCount; first += tileSize) {
+    const size_t count = std::min(tileSize, locationCount - first);
+    for (size_t q = 0; q < addressCount; q++) {
+      kernels->distances(locations + first * wordCount, count, wordCount,
+                         addresses + q * wordCount, chunk);
+      for (size_t i = 0; i < count; i++) {
+        histogram[chunk[i]]++;
+      }
+    }
+  }
+}
+
+void transposeToBitSlices(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t bitCount,
+  WORD_TYPE* planes) {
+  const size_t locationWordCount = wordCount(bitCount);
+  const size_t sliceCount = bitSliceCount(locationCount);
+
+  // One 64 x 64 block at a time: 64 locations by one word of their address.
+  WORD_TYPE block[WORD_BIT_SIZE];
+  for (size_t s = 0; s < sliceCount; s++) {
+    WORD_TYPE* slice = planes + s * bitCount * BIT_SLICE_WORD_COUNT;
+    for (size_t part = 0; part < BIT_SLICE_WORD_COUNT; part++) {
+      const size_t first =
+        s * BIT_SLICE_LOCATION_COUNT + part * WORD_BIT_SIZE;
+      for (size_t w = 0; w < locationWordCount; w++) {
+        for (size_t j = 0; j < WORD_BIT_SIZE; j++) {
+          block[j] = first + j < locationCount ?
+                     locations[(first + j) * locationWordCount + w] : 0;
+        }
+        transpose64(block);
+
+        const size_t bits =
+          std::min(WORD_BIT_SIZE, bitCount - w * WORD_BIT_SIZE);
+        for (size_t k = 0; k < bits; k++) {
+          slice[(w * WORD_BIT_SIZE + k) * BIT_SLICE_WORD_COUNT + part] =
+            block[k];
+        }
+      }
+    }
+  }
+}
+
+void bitSlicedActivationMasks(
+  const WORD_TYPE* planes,
+  size_t sliceCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  WORD_TYPE* masks) {
+  activeKernels().load(std::memory_order_relaxed)->bitSlicedMasks(
+    planes, sliceCount, bitCount, address, std::min(threshold, bitCount),
+    masks);
+}
+
+void activateBitSliced(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  threshold = std::min(threshold, bitCount);
+
+  activated->clear();
+  const size_t sliceCount = bitSliceCount(locationCount);
+  WORD_TYPE masks[BIT_SLICE_CHUNK_SIZE * BIT_SLICE_WORD_COUNT];
+  for (size_t first = 0; first < sliceCount; first += BIT_SLICE_CHUNK_SIZE) {
+    const size_t count = std::min(BIT_SLICE_CHUNK_SIZE, sliceCount - first);
+    kernels->bitSlicedMasks(
+      planes + first * bitCount * BIT_SLICE_WORD_COUNT, count, bitCount,
+      address, threshold, masks);
+    appendMaskedLocations(masks, count, first * BIT_SLICE_LOCATION_COUNT,
+                          locationCount, activated);
+  }
+}
+
+void bitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  WORD_TYPE* distances) {
+  activeKernels().load(std::memory_order_relaxed)->bitSlicedDistances(
+    planes, bitSliceCount(locationCount), bitCount, address, distances);
+}
+
+size_t bitSlicedDistance(
+  const WORD_TYPE* distances,
+  size_t bitCount,
+  size_t location) {
+  const size_t planeCount = bitSlicedDistancePlaneCount(bitCount);
+  const WORD_TYPE* slice = distances +
+    location / BIT_SLICE_LOCATION_COUNT * planeCount * BIT_SLICE_WORD_COUNT +
+    location % BIT_SLICE_LOCATION_COUNT / WORD_BIT_SIZE;
+  size_t distance = 0;
+  for (size_t k = 0; k < planeCount; k++) {
+    distance |= ((slice[k * BIT_SLICE_WORD_COUNT] >>
+                  (location % WORD_BIT_SIZE)) & 1) << k;
+  }
+  return distance;
+}
+
+void updateBitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  const size_t* flippedBits,
+  size_t flipCount,
+  size_t threshold,
+  WORD_TYPE* distances,
+  activationList* activated) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  const size_t planeCount = bitSlicedDistancePlaneCount(bitCount);
+  threshold = std::min(threshold, bitCount);
+
+  activated->clear();
+  const size_t sliceCount = bitSliceCount(locationCount);
+  WORD_TYPE masks[BIT_SLICE_CHUNK_SIZE * BIT_SLICE_WORD_COUNT];
+  for (size_t first = 0; first < sliceCount; first += BIT_SLICE_CHUNK_SIZE) {
+    const size_t count = std::min(BIT_SLICE_CHUNK_SIZE, sliceCount - first);
+    kernels->updateBitSlicedDistances(
+      planes + first * bitCount * BIT_SLICE_WORD_COUNT, count, bitCount,
+      address, flippedBits, flipCount, threshold,
+      distances + first * planeCount * BIT_SLICE_WORD_COUNT, masks);
+    appendMaskedLocations(masks, count, first * BIT_SLICE_LOCATION_COUNT,
+                          locationCount, activated);
+  }
+}
+
+void activateProceduralLocations(
+  uint64_t seed,
+  size_t locationCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) {
+  const HammingKernels* kernels = activeKernels().load(
+    std::memory_order_relaxed);
+  const size_t locationWordCount = wordCount(bitCount);
+  const uint64_t key = counterRandomKey(seed);
+  threshold = std::min(threshold, bitCount);
+
+  activated->clear();
+  LOCATION_INDEX_TYPE chunk[ACTIVATION_CHUNK_SIZE];
+  for (size_t first = 0; first < locationCount;
+       first += ACTIVATION_CHUNK_SIZE) {
+    const size_t count = std::min(ACTIVATION_CHUNK_SIZE, locationCount - first);
+    const size_t activatedCount = kernels->activateProcedural(
+      key, count, locationWordCount, lastWordMask(bitCount), address,
+      threshold, static_cast<LOCATION_INDEX_TYPE>(first), chunk);
+    activated->insert(activated->end(), chunk, chunk + activatedCount);
+  }
+}
+
+void activateSelectedCoordinates(
+  const uint16_t* coordinates,
+  size_t locationCount,
+  size_t selectedBitCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  activationList* activated) {
+  activated->clear();
+  LOCATION_INDEX_TYPE chunk[ACTIVATION_CHUNK_SIZE];
+  if (2 * bitCount > SELECTED_COORDINATE_TABLE_SIZE) {
+    for (size_t first = 0; first < locationCount;
+         first += ACTIVATION_CHUNK_SIZE) {
+      const size_t count =
+        std::min(ACTIVATION_CHUNK_SIZE, locationCount - first);
+      const size_t activatedCount = selectCoordinatesInPlace(
+        coordinates, first, count, selectedBitCount, address, threshold,
+        chunk);
+      activated->insert(activated->end(), chunk, chunk + activatedCount);
+    }
+    return;
+  }
+
+  uint8_t mismatches[SELECTED_COORDINATE_TABLE_SIZE];
+  for (size_t b = 0; b < bitCount; b++) {
+    const uint8_t bit =
+      (address[b / WORD_BIT_SIZE] >> (b % WORD_BIT_SIZE)) & 1;
+    mismatches[2 * b] = bit;
+    mismatches[2 * b + 1] = bit ^ 1;
+  }
+  SelectCoordinates select =
+    selectedBitCount <= SELECTED_COORDINATE_UNROLLED_COUNT ?
+    selectCoordinatesUnrolled[selectedBitCount] : selectCoordinates<0>;
+  for (size_t first = 0; first < locationCount;
+       first += ACTIVATION_CHUNK_SIZE) {
+    const size_t count = std::min(ACTIVATION_CHUNK_SIZE, locationCount - first);
+    const size_t activatedCount = select(
+      coordinates, first, count, selectedBitCount, mismatches, threshold,
+      chunk);
+    activated->insert(activated->end(), chunk, chunk + activatedCount);
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,386 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <immintrin.h>
+
+#include "./hamming_kernels.h"
+#include "./hamming_bitsliced.h"
+#include "./bitslice_avx2.h"
+
+namespace sdm {
+namespace {
+
+static_assert(sizeof(size_t) == sizeof(WORD_TYPE),
+              "Distances are stored straight from 64-bit lanes.");
+
+/**
+ * Popcount of each 64-bit lane using the nibble lookup table method.
+ */
+inline __m256i popcount64(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, lowMask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+  const __m256i counts = _mm256_add_epi8(
+    _mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+inline size_t horizontalSum(__m256i v) {
+  const __m128i sum = _mm_add_epi64(
+    _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+}
+
+/**
+ * Hamming distance of one location to the address.
+ */
+inline size_t distance(
+  const WORD_TYPE* location, const WORD_TYPE* address, size_t wordCount) {
+  const size_t vectorWordCount = wordCount - wordCount % 4;
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t w = 0; w < vectorWordCount; w += 4) {
+    const __m256i v = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(location + w));
+    const __m256i a = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(address + w));
+    sum = _mm256_add_epi64(sum, popcount64(_mm256_xor_si256(v, a)));
+  }
+
+  size_t total = horizontalSum(sum);
+  for (size_t w = vectorWordCount; w < wordCount; w++) {
+    total += _mm_popcnt_u64(location[w] ^ address[w]);
+  }
+  return total;
+}
+
+template<size_t FIXED_WORD_COUNT>
+void avx2Distances(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  if (wordCount == 1) {
+    // Four locations per vector.
+    const __m256i word = _mm256_set1_epi64x(address[0]);
+    size_t i = 0;
+    for (; i + 4 <= locationCount; i += 4) {
+      const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(locations + i));
+      _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(distances + i),
+        popcount64(_mm256_xor_si256(v, word)));
+    }
+    for (; i < locationCount; i++) {
+      distances[i] = _mm_popcnt_u64(locations[i] ^ address[0]);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    distances[i] = distance(locations, address, wordCount);
+  }
+}
+
+template<size_t FIXED_WORD_COUNT>
+size_t avx2Activate(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  size_t count = 0;
+  size_t i = 0;
+  if (wordCount == 1) {
+    // Four locations per vector, compared at once. Distances and threshold
+    // are at most 64 so the signed compare is safe.
+    const __m256i word = _mm256_set1_epi64x(address[0]);
+    const __m256i limit = _mm256_set1_epi64x(threshold);
+    for (; i + 4 <= locationCount; i += 4) {
+      const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(locations + i));
+      const __m256i tooFar = _mm256_cmpgt_epi64(
+        popcount64(_mm256_xor_si256(v, word)), limit);
+      const int activated =
+        ~_mm256_movemask_pd(_mm256_castsi256_pd(tooFar));
+      for (size_t lane = 0; lane < 4; lane++) {
+        indices[count] = firstIndex + i + lane;
+        count += (activated >> lane) & 1;
+      }
+    }
+  }
+
+  for (locations += i * wordCount; i < locationCount;
+       i++, locations += wordCount) {
+    indices[count] = firstIndex + i;
+    count += distance(locations, address, wordCount) <= threshold;
+  }
+
+  return count;
+}
+
+size_t avx2ActivateEarlyExit(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  const size_t* blockOrder,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  const size_t blockCount = hammingBlockCount(wordCount);
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    size_t distance = 0;
+    for (size_t b = 0; b < blockCount && distance <= threshold; b++) {
+      const size_t first = blockOrder[b] * HAMMING_BLOCK_WORD_COUNT;
+      if (first + HAMMING_BLOCK_WORD_COUNT <= wordCount) {
+        const __m256i v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(locations + first));
+        const __m256i a = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(address + first));
+        distance += horizontalSum(popcount64(_mm256_xor_si256(v, a)));
+      } else {
+        for (size_t w = first; w < wordCount; w++) {
+          distance += _mm_popcnt_u64(locations[w] ^ address[w]);
+        }
+      }
+    }
+
+    indices[count] = firstIndex + i;
+    count += distance <= threshold;
+  }
+
+  return count;
+}
+
+template<size_t FIXED_WORD_COUNT>
+void avx2ActivateBatch(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  for (size_t q = 0; q < addressCount; q++) {
+    counts[q] = 0;
+  }
+
+  size_t i = 0;
+  if (wordCount == 1) {
+    const __m256i limit = _mm256_set1_epi64x(threshold);
+    __m256i words[BATCH_QUERY_BLOCK_SIZE];
+    for (size_t q = 0; q < addressCount; q++) {
+      words[q] = _mm256_set1_epi64x(addresses[q]);
+    }
+
+    for (; i + 4 <= locationCount; i += 4) {
+      const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(locations + i));
+      for (size_t q = 0; q < addressCount; q++) {
+        const __m256i tooFar = _mm256_cmpgt_epi64(
+          popcount64(_mm256_xor_si256(v, words[q])), limit);
+        const int activated =
+          ~_mm256_movemask_pd(_mm256_castsi256_pd(tooFar));
+        for (size_t lane = 0; lane < 4; lane++) {
+          indices[q][counts[q]] = firstIndex + i + lane;
+          counts[q] += (activated >> lane) & 1;
+        }
+      }
+    }
+  }
+
+  const size_t vectorWordCount = wordCount - wordCount % 4;
+  for (locations += i * wordCount; i < locationCount;
+       i++, locations += wordCount) {
+    __m256i sums[BATCH_QUERY_BLOCK_SIZE];
+    for (size_t q = 0; q < addressCount; q++) {
+      sums[q] = _mm256_setzero_si256();
+    }
+    for (size_t w = 0; w < vectorWordCount; w += 4) {
+      const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(locations + w));
+      for (size_t q = 0; q < addressCount; q++) {
+        const __m256i a = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(addresses + q * wordCount + w));
+        sums[q] = _mm256_add_epi64(
+          sums[q], popcount64(_mm256_xor_si256(v, a)));
+      }
+    }
+
+    for (size_t q = 0; q < addressCount; q++) {
+      const WORD_TYPE* address = addresses + q * wordCount;
+      size_t total = horizontalSum(sums[q]);
+      for (size_t w = vectorWordCount; w < wordCount; w++) {
+        total += _mm_popcnt_u64(locations[w] ^ address[w]);
+      }
+      indices[q][counts[q]] = firstIndex + i;
+      counts[q] += total <= threshold;
+    }
+  }
+}
+
+void avx2DistancesAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  selectWordCount(
+    wordCount,
+    avx2Distances<0>, avx2Distances<1>, avx2Distances<2>,
+    avx2Distances<4>, avx2Distances<8>)(
+      locations, locationCount, wordCount, address, distances);
+}
+
+size_t avx2ActivateAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  return selectWordCount(
+    wordCount,
+    avx2Activate<0>, avx2Activate<1>, avx2Activate<2>,
+    avx2Activate<4>, avx2Activate<8>)(
+      locations, locationCount, wordCount, address, threshold, firstIndex,
+      indices);
+}
+
+void avx2ActivateBatchAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  selectWordCount(
+    wordCount,
+    avx2ActivateBatch<0>, avx2ActivateBatch<1>, avx2ActivateBatch<2>,
+    avx2ActivateBatch<4>, avx2ActivateBatch<8>)(
+      locations, locationCount, wordCount, addresses, addressCount,
+      threshold, firstIndex, indices, counts);
+}
+
+/**
+ * Low 64 bits of the product of each lane by a constant, from 32-bit
+ * multiplies since AVX2 has no 64-bit one.
+ */
+inline __m256i multiply64(__m256i a, uint64_t b) {
+  const __m256i bLow = _mm256_set1_epi64x(b & 0xffffffff);
+  const __m256i bHigh = _mm256_set1_epi64x(b >> 32);
+  const __m256i cross = _mm256_add_epi64(
+    _mm256_mul_epu32(_mm256_srli_epi64(a, 32), bLow),
+    _mm256_mul_epu32(a, bHigh));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, bLow),
+                          _mm256_slli_epi64(cross, 32));
+}
+
+/**
+ * SplitMix64 output function of each lane, see splitMix64.
+ */
+inline __m256i splitMix64(__m256i z) {
+  z = multiply64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)),
+                 SPLITMIX_MULTIPLIER_1);
+  z = multiply64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)),
+                 SPLITMIX_MULTIPLIER_2);
+  return _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+}
+
+size_t avx2ActivateProcedural(
+  uint64_t key,
+  size_t locationCount,
+  size_t wordCount,
+  WORD_TYPE lastMask,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  // Four locations per iteration, one per lane. Each lane walks the stream
+  // of its location, wordCount states apart from the next lane's.
+  const uint64_t locationStride = wordCount * SPLITMIX_GAMMA;
+  const __m256i gamma = _mm256_set1_epi64x(SPLITMIX_GAMMA);
+  const __m256i step = _mm256_set1_epi64x(4 * locationStride);
+  const __m256i limit = _mm256_set1_epi64x(threshold);
+  const __m256i mask = _mm256_set1_epi64x(lastMask);
+  const size_t lastWord = wordCount - 1;
+
+  const uint64_t first = key + (firstIndex * wordCount + 1) * SPLITMIX_GAMMA;
+  __m256i state = _mm256_setr_epi64x(
+    first, first + locationStride, first + 2 * locationStride,
+    first + 3 * locationStride);
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i += 4) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i z = state;
+    for (size_t w = 0; w < lastWord; w++, z = _mm256_add_epi64(z, gamma)) {
+      sum = _mm256_add_epi64(sum, popcount64(_mm256_xor_si256(
+        splitMix64(z), _mm256_set1_epi64x(address[w]))));
+    }
+    sum = _mm256_add_epi64(sum, popcount64(_mm256_xor_si256(
+      _mm256_and_si256(splitMix64(z), mask),
+      _mm256_set1_epi64x(address[lastWord]))));
+
+    // Distances and threshold fit in 63 bits, the signed compare is safe.
+    const int activated = ~_mm256_movemask_pd(_mm256_castsi256_pd(
+      _mm256_cmpgt_epi64(sum, limit)));
+    const size_t laneCount = locationCount - i < 4 ? locationCount - i : 4;
+    for (size_t lane = 0; lane < laneCount; lane++) {
+      indices[count] = firstIndex + i + lane;
+      count += (activated >> lane) & 1;
+    }
+    state = _mm256_add_epi64(state, step);
+  }
+
+  return count;
+}
+
+}  // namespace
+
+const HammingKernels avx2HammingKernels = {
+  KernelISA::AVX2,
+  avx2DistancesAnyWidth,
+  avx2ActivateAnyWidth,
+  avx2ActivateEarlyExit,
+  avx2ActivateBatchAnyWidth,
+  bitSlicedMasks<Avx2BitSliceOps>,
+  bitSlicedDistances<Avx2BitSliceOps>,
+  updateBitSlicedDistances<Avx2BitSliceOps>,
+  avx2ActivateProcedural
+};
+
+}  // namespace sdm
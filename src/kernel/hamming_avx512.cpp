@@ -0,0 +1,366 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <immintrin.h>
+
+#include "./hamming_kernels.h"
+#include "./hamming_bitsliced.h"
+#include "./bitslice_avx512.h"
+
+namespace sdm {
+namespace {
+
+static_assert(sizeof(size_t) == sizeof(WORD_TYPE),
+              "Distances are stored straight from 64-bit lanes.");
+
+/**
+ * Mask of the 64-bit lanes in use when n words remain.
+ */
+inline __mmask8 tailMask(size_t n) {
+  return n >= 8 ? 0xff : static_cast<__mmask8>((1u << n) - 1);
+}
+
+/**
+ * Hamming distance of one location to the address.
+ */
+inline size_t distance(
+  const WORD_TYPE* location, const WORD_TYPE* address, size_t wordCount) {
+  __m512i sum = _mm512_setzero_si512();
+  for (size_t w = 0; w < wordCount; w += 8) {
+    const __mmask8 mask = tailMask(wordCount - w);
+    const __m512i v = _mm512_maskz_loadu_epi64(mask, location + w);
+    const __m512i a = _mm512_maskz_loadu_epi64(mask, address + w);
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(v, a)));
+  }
+  return _mm512_reduce_add_epi64(sum);
+}
+
+template<size_t FIXED_WORD_COUNT>
+void avx512Distances(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  if (wordCount == 1) {
+    // Eight locations per vector.
+    const __m512i word = _mm512_set1_epi64(address[0]);
+    size_t i = 0;
+    for (; i + 8 <= locationCount; i += 8) {
+      const __m512i v = _mm512_loadu_si512(locations + i);
+      _mm512_storeu_si512(
+        distances + i, _mm512_popcnt_epi64(_mm512_xor_si512(v, word)));
+    }
+    const __mmask8 mask = tailMask(locationCount - i);
+    const __m512i v = _mm512_maskz_loadu_epi64(mask, locations + i);
+    _mm512_mask_storeu_epi64(
+      distances + i, mask, _mm512_popcnt_epi64(_mm512_xor_si512(v, word)));
+    return;
+  }
+
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    distances[i] = distance(locations, address, wordCount);
+  }
+}
+
+template<size_t FIXED_WORD_COUNT>
+size_t avx512Activate(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  size_t count = 0;
+  size_t i = 0;
+  if (wordCount == 1) {
+    // Sixteen locations per iteration: two vectors of distances compared
+    // into one mask, then the activated indices are compress-stored.
+    const __m512i word = _mm512_set1_epi64(address[0]);
+    const __m512i limit = _mm512_set1_epi64(threshold);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i index = _mm512_add_epi32(
+      _mm512_set1_epi32(firstIndex),
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                        8, 9, 10, 11, 12, 13, 14, 15));
+    for (; i + 16 <= locationCount; i += 16) {
+      const __m512i lo = _mm512_popcnt_epi64(_mm512_xor_si512(
+        _mm512_loadu_si512(locations + i), word));
+      const __m512i hi = _mm512_popcnt_epi64(_mm512_xor_si512(
+        _mm512_loadu_si512(locations + i + 8), word));
+      const __mmask16 activated = _mm512_kunpackb(
+        _mm512_cmple_epu64_mask(hi, limit),
+        _mm512_cmple_epu64_mask(lo, limit));
+      _mm512_mask_compressstoreu_epi32(indices + count, activated, index);
+      count += _mm_popcnt_u32(activated);
+      index = _mm512_add_epi32(index, step);
+    }
+  }
+
+  for (locations += i * wordCount; i < locationCount;
+       i++, locations += wordCount) {
+    indices[count] = firstIndex + i;
+    count += distance(locations, address, wordCount) <= threshold;
+  }
+
+  return count;
+}
+
+size_t avx512ActivateEarlyExit(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  const size_t* blockOrder,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  static_assert(HAMMING_BLOCK_WORD_COUNT == 4,
+                "A block is half of a 512-bit vector.");
+  const size_t blockCount = hammingBlockCount(wordCount);
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    // Two blocks per vector and per check, a horizontal sum for each block
+    // costs more than the work it saves.
+    size_t distance = 0;
+    for (size_t b = 0; b < blockCount && distance <= threshold; b += 2) {
+      const size_t first = blockOrder[b] * HAMMING_BLOCK_WORD_COUNT;
+      const __mmask8 firstMask = tailMask(wordCount - first) & 0x0f;
+      __m512i v = _mm512_castsi256_si512(
+        _mm256_maskz_loadu_epi64(firstMask, locations + first));
+      __m512i a = _mm512_castsi256_si512(
+        _mm256_maskz_loadu_epi64(firstMask, address + first));
+      if (b + 1 < blockCount) {
+        const size_t second = blockOrder[b + 1] * HAMMING_BLOCK_WORD_COUNT;
+        const __mmask8 secondMask = tailMask(wordCount - second) & 0x0f;
+        v = _mm512_inserti64x4(
+          v, _mm256_maskz_loadu_epi64(secondMask, locations + second), 1);
+        a = _mm512_inserti64x4(
+          a, _mm256_maskz_loadu_epi64(secondMask, address + second), 1);
+      } else {
+        v = _mm512_inserti64x4(
+          _mm512_setzero_si512(), _mm512_castsi512_si256(v), 0);
+        a = _mm512_inserti64x4(
+          _mm512_setzero_si512(), _mm512_castsi512_si256(a), 0);
+      }
+      distance += _mm512_reduce_add_epi64(
+        _mm512_popcnt_epi64(_mm512_xor_si512(v, a)));
+    }
+
+    indices[count] = firstIndex + i;
+    count += distance <= threshold;
+  }
+
+  return count;
+}
+
+template<size_t FIXED_WORD_COUNT>
+void avx512ActivateBatch(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  for (size_t q = 0; q < addressCount; q++) {
+    counts[q] = 0;
+  }
+
+  const __m512i limit = _mm512_set1_epi64(threshold);
+  size_t i = 0;
+  if (wordCount == 1) {
+    // Eight locations per vector, their indices compress-stored per address.
+    __m512i words[BATCH_QUERY_BLOCK_SIZE];
+    for (size_t q = 0; q < addressCount; q++) {
+      words[q] = _mm512_set1_epi64(addresses[q]);
+    }
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_add_epi32(
+      _mm256_set1_epi32(firstIndex),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    for (; i + 8 <= locationCount; i += 8) {
+      const __m512i v = _mm512_loadu_si512(locations + i);
+      for (size_t q = 0; q < addressCount; q++) {
+        const __mmask8 activated = _mm512_cmple_epu64_mask(
+          _mm512_popcnt_epi64(_mm512_xor_si512(v, words[q])), limit);
+        _mm256_mask_compressstoreu_epi32(
+          indices[q] + counts[q], activated, index);
+        counts[q] += _mm_popcnt_u32(activated);
+      }
+      index = _mm256_add_epi32(index, step);
+    }
+  }
+
+  for (locations += i * wordCount; i < locationCount;
+       i++, locations += wordCount) {
+    __m512i sums[BATCH_QUERY_BLOCK_SIZE];
+    for (size_t q = 0; q < addressCount; q++) {
+      sums[q] = _mm512_setzero_si512();
+    }
+    for (size_t w = 0; w < wordCount; w += 8) {
+      const __mmask8 mask = tailMask(wordCount - w);
+      const __m512i v = _mm512_maskz_loadu_epi64(mask, locations + w);
+      for (size_t q = 0; q < addressCount; q++) {
+        const __m512i a = _mm512_maskz_loadu_epi64(
+          mask, addresses + q * wordCount + w);
+        sums[q] = _mm512_add_epi64(
+          sums[q], _mm512_popcnt_epi64(_mm512_xor_si512(v, a)));
+      }
+    }
+
+    for (size_t q = 0; q < addressCount; q++) {
+      indices[q][counts[q]] = firstIndex + i;
+      counts[q] += size_t(_mm512_reduce_add_epi64(sums[q])) <= threshold;
+    }
+  }
+}
+
+void avx512DistancesAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  selectWordCount(
+    wordCount,
+    avx512Distances<0>, avx512Distances<1>, avx512Distances<2>,
+    avx512Distances<4>, avx512Distances<8>)(
+      locations, locationCount, wordCount, address, distances);
+}
+
+size_t avx512ActivateAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  return selectWordCount(
+    wordCount,
+    avx512Activate<0>, avx512Activate<1>, avx512Activate<2>,
+    avx512Activate<4>, avx512Activate<8>)(
+      locations, locationCount, wordCount, address, threshold, firstIndex,
+      indices);
+}
+
+void avx512ActivateBatchAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  selectWordCount(
+    wordCount,
+    avx512ActivateBatch<0>, avx512ActivateBatch<1>, avx512ActivateBatch<2>,
+    avx512ActivateBatch<4>, avx512ActivateBatch<8>)(
+      locations, locationCount, wordCount, addresses, addressCount,
+      threshold, firstIndex, indices, counts);
+}
+
+/**
+ * SplitMix64 output function of each lane, see splitMix64.
+ */
+inline __m512i splitMix64(__m512i z) {
+  const __m512i multiplier1 = _mm512_set1_epi64(SPLITMIX_MULTIPLIER_1);
+  const __m512i multiplier2 = _mm512_set1_epi64(SPLITMIX_MULTIPLIER_2);
+  z = _mm512_mullo_epi64(
+    _mm512_xor_si512(z, _mm512_srli_epi64(z, 30)), multiplier1);
+  z = _mm512_mullo_epi64(
+    _mm512_xor_si512(z, _mm512_srli_epi64(z, 27)), multiplier2);
+  return _mm512_xor_si512(z, _mm512_srli_epi64(z, 31));
+}
+
+size_t avx512ActivateProcedural(
+  uint64_t key,
+  size_t locationCount,
+  size_t wordCount,
+  WORD_TYPE lastMask,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  // Eight locations per iteration, one per lane. Each lane walks the stream
+  // of its location, wordCount states apart from the next lane's.
+  const __m512i gamma = _mm512_set1_epi64(SPLITMIX_GAMMA);
+  const __m512i laneStates = _mm512_mullo_epi64(
+    _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7),
+    _mm512_set1_epi64(wordCount * SPLITMIX_GAMMA));
+  const __m512i step = _mm512_set1_epi64(8 * wordCount * SPLITMIX_GAMMA);
+  const __m512i limit = _mm512_set1_epi64(threshold);
+  const __m512i mask = _mm512_set1_epi64(lastMask);
+  const size_t lastWord = wordCount - 1;
+
+  __m512i state = _mm512_add_epi64(
+    _mm512_set1_epi64(key + (firstIndex * wordCount + 1) * SPLITMIX_GAMMA),
+    laneStates);
+  __m256i index = _mm256_add_epi32(
+    _mm256_set1_epi32(firstIndex), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i += 8) {
+    __m512i sum = _mm512_setzero_si512();
+    __m512i z = state;
+    for (size_t w = 0; w < lastWord; w++, z = _mm512_add_epi64(z, gamma)) {
+      sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(
+        splitMix64(z), _mm512_set1_epi64(address[w]))));
+    }
+    sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(
+      _mm512_and_si512(splitMix64(z), mask),
+      _mm512_set1_epi64(address[lastWord]))));
+
+    const __mmask8 activated =
+      _mm512_mask_cmple_epu64_mask(tailMask(locationCount - i), sum, limit);
+    _mm256_mask_compressstoreu_epi32(indices + count, activated, index);
+    count += _mm_popcnt_u32(activated);
+    state = _mm512_add_epi64(state, step);
+    index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+  }
+
+  return count;
+}
+
+}  // namespace
+
+const HammingKernels avx512HammingKernels = {
+  KernelISA::AVX512_VPOPCNTDQ,
+  avx512DistancesAnyWidth,
+  avx512ActivateAnyWidth,
+  avx512ActivateEarlyExit,
+  avx512ActivateBatchAnyWidth,
+  bitSlicedMasks<Avx512BitSliceOps>,
+  bitSlicedDistances<Avx512BitSliceOps>,
+  updateBitSlicedDistances<Avx512BitSliceOps>,
+  avx512ActivateProcedural
+};
+
+}  // namespace sdm
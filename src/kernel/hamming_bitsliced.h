@@ -0,0 +1,261 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Bit-sliced activation, written once against a vector of bits and
+// instantiated by each hamming_<isa>.cpp with its own, hence the anonymous
+// namespace. Ops provides:
+//   Vector, WORD_COUNT  the vector type and the number of words it holds.
+//   load, store, broadcast, zero
+//   bitAnd, bitOr, bitXor, andNot (~a & b)
+//   carrySaveAdd(a, b, c, &high, &low)  the full adder, low = a ^ b ^ c and
+//                                       high = majority(a, b, c).
+
+#include "./hamming_kernels.h"
+
+namespace sdm {
+namespace {  // NOLINT(build/namespaces)
+
+/*!
+ * Most bit-planes a per location counter needs, one per bit of the largest
+ * possible distance, see bitSlicedDistancePlaneCount.
+ */
+constexpr size_t MAX_COUNTER_PLANE_COUNT = 8 * sizeof(size_t);
+
+/**
+ * Adds a one bit value to each location's counter, rippling the carry
+ * through the counter's bit-planes.
+ */
+template<typename Ops>
+inline void rippleAdd(typename Ops::Vector carry,
+                      typename Ops::Vector* counter,
+                      size_t planeCount) {
+  for (size_t k = 0; k < planeCount; k++) {
+    const typename Ops::Vector sum = Ops::bitXor(counter[k], carry);
+    carry = Ops::bitAnd(counter[k], carry);
+    counter[k] = sum;
+  }
+}
+
+/**
+ * Adds 1 to each location's counter where up is set and -1 elsewhere,
+ * rippling the carry, or the borrow, through the counter's bit-planes. A
+ * counter keeps going one way while its digits are those of the direction,
+ * 1s up and 0s down.
+ */
+template<typename Ops>
+inline void rippleStep(typename Ops::Vector up,
+                       typename Ops::Vector* counter,
+                       size_t planeCount) {
+  typename Ops::Vector carry = Ops::broadcast(~WORD_TYPE(0));
+  for (size_t k = 0; k < planeCount; k++) {
+    const typename Ops::Vector digit = counter[k];
+    counter[k] = Ops::bitXor(digit, carry);
+    carry = Ops::andNot(Ops::bitXor(digit, up), carry);
+  }
+}
+
+/**
+ * @param plane Bit-plane 0 of a slice, offset to the part of the slice.
+ * @return Bit-plane of the locations that differ from address in bit i.
+ */
+template<typename Ops>
+inline typename Ops::Vector mismatchPlane(const WORD_TYPE* plane,
+                                          const WORD_TYPE* address,
+                                          size_t i) {
+  const WORD_TYPE bit = (address[i / WORD_BIT_SIZE] >> (i % WORD_BIT_SIZE)) &
+                        1;
+  return Ops::bitXor(Ops::load(plane + i * BIT_SLICE_WORD_COUNT),
+                     Ops::broadcast(WORD_TYPE(0) - bit));
+}
+
+/**
+ * Sums the mismatches of every bit-plane into per location counters,
+ * themselves stored as planeCount bit-planes.
+ * @param plane Bit-plane 0 of a slice, offset to the part of the slice.
+ */
+template<typename Ops>
+inline void sumMismatches(const WORD_TYPE* plane,
+                          size_t bitCount,
+                          const WORD_TYPE* address,
+                          size_t planeCount,
+                          typename Ops::Vector* counter) {
+  typedef typename Ops::Vector Vector;
+  auto mismatch = [plane, address](size_t i) {
+    return mismatchPlane<Ops>(plane, address, i);
+  };
+
+  // The four low counter bit-planes are accumulated sixteen mismatch
+  // bit-planes at a time with a carry-save adder tree (Harley-Seal), only
+  // the carry out of the sixteens ripples through the others.
+  for (size_t k = 0; k < planeCount; k++) {
+    counter[k] = Ops::zero();
+  }
+  Vector ones = Ops::zero();
+  Vector twos = Ops::zero();
+  Vector fours = Ops::zero();
+  Vector eights = Ops::zero();
+  Vector twosA, twosB, foursA, foursB, eightsA, eightsB, sixteens;
+  size_t i = 0;
+  for (; i + 16 <= bitCount; i += 16) {
+    Ops::carrySaveAdd(ones, mismatch(i), mismatch(i + 1), &twosA, &ones);
+    Ops::carrySaveAdd(ones, mismatch(i + 2), mismatch(i + 3), &twosB, &ones);
+    Ops::carrySaveAdd(twos, twosA, twosB, &foursA, &twos);
+    Ops::carrySaveAdd(ones, mismatch(i + 4), mismatch(i + 5), &twosA, &ones);
+    Ops::carrySaveAdd(ones, mismatch(i + 6), mismatch(i + 7), &twosB, &ones);
+    Ops::carrySaveAdd(twos, twosA, twosB, &foursB, &twos);
+    Ops::carrySaveAdd(fours, foursA, foursB, &eightsA, &fours);
+    Ops::carrySaveAdd(ones, mismatch(i + 8), mismatch(i + 9), &twosA, &ones);
+    Ops::carrySaveAdd(ones, mismatch(i + 10), mismatch(i + 11),
+                      &twosB, &ones);
+    Ops::carrySaveAdd(twos, twosA, twosB, &foursA, &twos);
+    Ops::carrySaveAdd(ones, mismatch(i + 12), mismatch(i + 13),
+                      &twosA, &ones);
+    Ops::carrySaveAdd(ones, mismatch(i + 14), mismatch(i + 15),
+                      &twosB, &ones);
+    Ops::carrySaveAdd(twos, twosA, twosB, &foursB, &twos);
+    Ops::carrySaveAdd(fours, foursA, foursB, &eightsB, &fours);
+    Ops::carrySaveAdd(eights, eightsA, eightsB, &sixteens, &eights);
+    rippleAdd<Ops>(sixteens, counter + 4, planeCount - 4);
+  }
+  if (i != 0) {
+    counter[0] = ones;
+    counter[1] = twos;
+    counter[2] = fours;
+    counter[3] = eights;
+  }
+  for (; i < bitCount; i++) {
+    rippleAdd<Ops>(mismatch(i), counter, planeCount);
+  }
+}
+
+/**
+ * @return Bit-plane of the locations whose counter is <= threshold,
+ *         compared from the most significant bit-plane down.
+ */
+template<typename Ops>
+inline typename Ops::Vector withinThreshold(
+  const typename Ops::Vector* counter,
+  size_t planeCount,
+  size_t threshold) {
+  typename Ops::Vector less = Ops::zero();
+  typename Ops::Vector equal = Ops::broadcast(~WORD_TYPE(0));
+  for (size_t k = planeCount; k-- > 0;) {
+    if ((threshold >> k) & 1) {
+      less = Ops::bitOr(less, Ops::andNot(counter[k], equal));
+      equal = Ops::bitAnd(equal, counter[k]);
+    } else {
+      equal = Ops::andNot(counter[k], equal);
+    }
+  }
+  return Ops::bitOr(less, equal);
+}
+
+template<typename Ops>
+void bitSlicedMasks(
+  const WORD_TYPE* planes,
+  size_t sliceCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  WORD_TYPE* masks) {
+  const size_t planeCount = bitSlicedDistancePlaneCount(bitCount);
+  const size_t sliceWordCount = bitCount * BIT_SLICE_WORD_COUNT;
+
+  for (size_t s = 0; s < sliceCount; s++, planes += sliceWordCount) {
+    for (size_t part = 0; part < BIT_SLICE_WORD_COUNT;
+         part += Ops::WORD_COUNT) {
+      typename Ops::Vector counter[MAX_COUNTER_PLANE_COUNT];
+      sumMismatches<Ops>(planes + part, bitCount, address, planeCount,
+                         counter);
+      Ops::store(masks + s * BIT_SLICE_WORD_COUNT + part,
+                 withinThreshold<Ops>(counter, planeCount, threshold));
+    }
+  }
+}
+
+template<typename Ops>
+void bitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t sliceCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  WORD_TYPE* distances) {
+  const size_t planeCount = bitSlicedDistancePlaneCount(bitCount);
+  const size_t sliceWordCount = bitCount * BIT_SLICE_WORD_COUNT;
+
+  for (size_t s = 0; s < sliceCount; s++, planes += sliceWordCount) {
+    WORD_TYPE* sliceDistances = distances +
+                                s * planeCount * BIT_SLICE_WORD_COUNT;
+    for (size_t part = 0; part < BIT_SLICE_WORD_COUNT;
+         part += Ops::WORD_COUNT) {
+      typename Ops::Vector counter[MAX_COUNTER_PLANE_COUNT];
+      sumMismatches<Ops>(planes + part, bitCount, address, planeCount,
+                         counter);
+      for (size_t k = 0; k < planeCount; k++) {
+        Ops::store(sliceDistances + k * BIT_SLICE_WORD_COUNT + part,
+                   counter[k]);
+      }
+    }
+  }
+}
+
+template<typename Ops>
+void updateBitSlicedDistances(
+  const WORD_TYPE* planes,
+  size_t sliceCount,
+  size_t bitCount,
+  const WORD_TYPE* address,
+  const size_t* flippedBits,
+  size_t flipCount,
+  size_t threshold,
+  WORD_TYPE* distances,
+  WORD_TYPE* masks) {
+  const size_t planeCount = bitSlicedDistancePlaneCount(bitCount);
+  const size_t sliceWordCount = bitCount * BIT_SLICE_WORD_COUNT;
+
+  for (size_t s = 0; s < sliceCount; s++, planes += sliceWordCount) {
+    WORD_TYPE* sliceDistances = distances +
+                                s * planeCount * BIT_SLICE_WORD_COUNT;
+    for (size_t part = 0; part < BIT_SLICE_WORD_COUNT;
+         part += Ops::WORD_COUNT) {
+      typename Ops::Vector counter[MAX_COUNTER_PLANE_COUNT];
+      for (size_t k = 0; k < planeCount; k++) {
+        counter[k] = Ops::load(sliceDistances + k * BIT_SLICE_WORD_COUNT +
+                               part);
+      }
+      // A location that now differs from address in a flipped bit used to
+      // match it there.
+      for (size_t f = 0; f < flipCount; f++) {
+        rippleStep<Ops>(
+          mismatchPlane<Ops>(planes + part, address, flippedBits[f]),
+          counter, planeCount);
+      }
+      for (size_t k = 0; k < planeCount; k++) {
+        Ops::store(sliceDistances + k * BIT_SLICE_WORD_COUNT + part,
+                   counter[k]);
+      }
+      Ops::store(masks + s * BIT_SLICE_WORD_COUNT + part,
+                 withinThreshold<Ops>(counter, planeCount, threshold));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace sdm
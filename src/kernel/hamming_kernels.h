@@ -0,0 +1,190 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "kernel/hamming.h"
+#include "utility/random.h"
+
+namespace sdm {
+
+/*!\struct HammingKernels
+ * \brief Table of the kernels compiled for one instruction set. Each
+ *        hamming_<isa>.cpp is compiled with its own target flags and defines
+ *        exactly one table. Implementations must have internal linkage so the
+ *        linker never mixes code compiled for different instruction sets.
+ */
+struct HammingKernels {
+  KernelISA isa;
+
+  void (*distances)(
+    const WORD_TYPE* locations,
+    size_t locationCount,
+    size_t wordCount,
+    const WORD_TYPE* address,
+    size_t* distances);
+
+  /**
+   * Writes the index (offset by firstIndex) of each location within
+   * threshold to indices, which has room for locationCount entries.
+   * threshold is at most wordCount * WORD_BIT_SIZE.
+   * @return Number of indices written.
+   */
+  size_t (*activate)(
+    const WORD_TYPE* locations,
+    size_t locationCount,
+    size_t wordCount,
+    const WORD_TYPE* address,
+    size_t threshold,
+    LOCATION_INDEX_TYPE firstIndex,
+    LOCATION_INDEX_TYPE* indices);
+
+  /**
+   * Like activate, but accumulates HAMMING_BLOCK_WORD_COUNT words at a time
+   * in blockOrder and stops on a location once past threshold.
+   */
+  size_t (*activateEarlyExit)(
+    const WORD_TYPE* locations,
+    size_t locationCount,
+    size_t wordCount,
+    const WORD_TYPE* address,
+    size_t threshold,
+    const size_t* blockOrder,
+    LOCATION_INDEX_TYPE firstIndex,
+    LOCATION_INDEX_TYPE* indices);
+
+  /**
+   * Like activate, for addressCount <= BATCH_QUERY_BLOCK_SIZE addresses at
+   * once. Each location is loaded once and compared to every address.
+   * indices[q] has room for locationCount entries and counts[q] is set to
+   * the number of indices written for address q.
+   */
+  void (*activateBatch)(
+    const WORD_TYPE* locations,
+    size_t locationCount,
+    size_t wordCount,
+    const WORD_TYPE* addresses,
+    size_t addressCount,
+    size_t threshold,
+    LOCATION_INDEX_TYPE firstIndex,
+    LOCATION_INDEX_TYPE* const* indices,
+    size_t* counts);
+
+  /**
+   * See bitSlicedActivationMasks. threshold is at most bitCount.
+   */
+  void (*bitSlicedMasks)(
+    const WORD_TYPE* planes,
+    size_t sliceCount,
+    size_t bitCount,
+    const WORD_TYPE* address,
+    size_t threshold,
+    WORD_TYPE* masks);
+
+  /**
+   * See bitSlicedDistances, for sliceCount slices.
+   */
+  void (*bitSlicedDistances)(
+    const WORD_TYPE* planes,
+    size_t sliceCount,
+    size_t bitCount,
+    const WORD_TYPE* address,
+    WORD_TYPE* distances);
+
+  /**
+   * See updateBitSlicedDistances, for sliceCount slices. Also writes the
+   * masks of the locations within threshold of address, as bitSlicedMasks.
+   */
+  void (*updateBitSlicedDistances)(
+    const WORD_TYPE* planes,
+    size_t sliceCount,
+    size_t bitCount,
+    const WORD_TYPE* address,
+    const size_t* flippedBits,
+    size_t flipCount,
+    size_t threshold,
+    WORD_TYPE* distances,
+    WORD_TYPE* masks);
+
+  /**
+   * Like activate, on locations regenerated from key instead of loaded:
+   * word w of location firstIndex + i is
+   * splitMix64(key + (((firstIndex + i) * wordCount + w) + 1) *
+   * SPLITMIX_GAMMA), the last word ANDed with lastMask.
+   */
+  size_t (*activateProcedural)(
+    uint64_t key,
+    size_t locationCount,
+    size_t wordCount,
+    WORD_TYPE lastMask,
+    const WORD_TYPE* address,
+    size_t threshold,
+    LOCATION_INDEX_TYPE firstIndex,
+    LOCATION_INDEX_TYPE* indices);
+};
+
+namespace {  // NOLINT(build/namespaces)
+
+/**
+ * The kernels are templates on FIXED_WORD_COUNT, the number of words of the
+ * addresses when it is known at compile time, 0 when it is only known at run
+ * time. They are instantiated for 64, 128, 256 and 512-bit addresses: with
+ * the word count a constant, the loops over the words of a location are
+ * fully unrolled, a 64-bit address is a single XOR and POPCNT per location.
+ * @return FIXED_WORD_COUNT if it is not 0, wordCount otherwise.
+ */
+template<size_t FIXED_WORD_COUNT>
+constexpr size_t fixedWordCount(size_t wordCount) {
+  return FIXED_WORD_COUNT != 0 ? FIXED_WORD_COUNT : wordCount;
+}
+
+/**
+ * @return The instantiation of a kernel for wordCount, generic if there is
+ *         none.
+ */
+template<typename Kernel>
+Kernel selectWordCount(size_t wordCount,
+                       Kernel generic,
+                       Kernel oneWord,
+                       Kernel twoWords,
+                       Kernel fourWords,
+                       Kernel eightWords) {
+  switch (wordCount) {
+    case 1:
+      return oneWord;
+    case 2:
+      return twoWords;
+    case 4:
+      return fourWords;
+    case 8:
+      return eightWords;
+    default:
+      return generic;
+  }
+}
+
+}  // namespace
+
+extern const HammingKernels genericHammingKernels;
+extern const HammingKernels popcntHammingKernels;
+extern const HammingKernels avx2HammingKernels;
+extern const HammingKernels avx512HammingKernels;
+
+}  // namespace sdm
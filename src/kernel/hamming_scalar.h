@@ -0,0 +1,235 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Scalar kernels. Included by the scalar hamming_<isa>.cpp files, which are
+// compiled with different target flags, hence the anonymous namespace.
+
+#include "./hamming_kernels.h"
+#include "./hamming_bitsliced.h"
+#include "./bitslice_scalar.h"
+
+namespace sdm {
+namespace {  // NOLINT(build/namespaces)
+
+template<size_t FIXED_WORD_COUNT>
+void scalarDistances(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  if (wordCount == 1) {
+    const WORD_TYPE word = address[0];
+    for (size_t i = 0; i < locationCount; i++) {
+      distances[i] = __builtin_popcountll(locations[i] ^ word);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    size_t distance = 0;
+    for (size_t w = 0; w < wordCount; w++) {
+      distance += __builtin_popcountll(locations[w] ^ address[w]);
+    }
+    distances[i] = distance;
+  }
+}
+
+template<size_t FIXED_WORD_COUNT>
+size_t scalarActivate(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    size_t distance = 0;
+    for (size_t w = 0; w < wordCount; w++) {
+      distance += __builtin_popcountll(locations[w] ^ address[w]);
+    }
+
+    // Branchless compaction: always write, only advance when activated.
+    indices[count] = firstIndex + i;
+    count += distance <= threshold;
+  }
+
+  return count;
+}
+
+size_t scalarActivateEarlyExit(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  const size_t* blockOrder,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  const size_t blockCount = hammingBlockCount(wordCount);
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    size_t distance = 0;
+    for (size_t b = 0; b < blockCount && distance <= threshold; b++) {
+      const size_t first = blockOrder[b] * HAMMING_BLOCK_WORD_COUNT;
+      const size_t last = first + HAMMING_BLOCK_WORD_COUNT < wordCount ?
+                          first + HAMMING_BLOCK_WORD_COUNT : wordCount;
+      for (size_t w = first; w < last; w++) {
+        distance += __builtin_popcountll(locations[w] ^ address[w]);
+      }
+    }
+
+    indices[count] = firstIndex + i;
+    count += distance <= threshold;
+  }
+
+  return count;
+}
+
+template<size_t FIXED_WORD_COUNT>
+void scalarActivateBatch(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  wordCount = fixedWordCount<FIXED_WORD_COUNT>(wordCount);
+
+  size_t distances[BATCH_QUERY_BLOCK_SIZE];
+  for (size_t q = 0; q < addressCount; q++) {
+    counts[q] = 0;
+  }
+
+  for (size_t i = 0; i < locationCount; i++, locations += wordCount) {
+    for (size_t q = 0; q < addressCount; q++) {
+      distances[q] = 0;
+    }
+    for (size_t w = 0; w < wordCount; w++) {
+      const WORD_TYPE word = locations[w];
+      for (size_t q = 0; q < addressCount; q++) {
+        distances[q] += __builtin_popcountll(
+          word ^ addresses[q * wordCount + w]);
+      }
+    }
+
+    for (size_t q = 0; q < addressCount; q++) {
+      indices[q][counts[q]] = firstIndex + i;
+      counts[q] += distances[q] <= threshold;
+    }
+  }
+}
+
+void scalarDistancesAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t* distances) {
+  selectWordCount(
+    wordCount,
+    scalarDistances<0>, scalarDistances<1>, scalarDistances<2>,
+    scalarDistances<4>, scalarDistances<8>)(
+      locations, locationCount, wordCount, address, distances);
+}
+
+size_t scalarActivateAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  return selectWordCount(
+    wordCount,
+    scalarActivate<0>, scalarActivate<1>, scalarActivate<2>,
+    scalarActivate<4>, scalarActivate<8>)(
+      locations, locationCount, wordCount, address, threshold, firstIndex,
+      indices);
+}
+
+void scalarActivateBatchAnyWidth(
+  const WORD_TYPE* locations,
+  size_t locationCount,
+  size_t wordCount,
+  const WORD_TYPE* addresses,
+  size_t addressCount,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* const* indices,
+  size_t* counts) {
+  selectWordCount(
+    wordCount,
+    scalarActivateBatch<0>, scalarActivateBatch<1>, scalarActivateBatch<2>,
+    scalarActivateBatch<4>, scalarActivateBatch<8>)(
+      locations, locationCount, wordCount, addresses, addressCount,
+      threshold, firstIndex, indices, counts);
+}
+
+/**
+ * SplitMix64 output function, see splitMix64.
+ */
+inline WORD_TYPE scalarSplitMix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * SPLITMIX_MULTIPLIER_1;
+  z = (z ^ (z >> 27)) * SPLITMIX_MULTIPLIER_2;
+  return z ^ (z >> 31);
+}
+
+size_t scalarActivateProcedural(
+  uint64_t key,
+  size_t locationCount,
+  size_t wordCount,
+  WORD_TYPE lastMask,
+  const WORD_TYPE* address,
+  size_t threshold,
+  LOCATION_INDEX_TYPE firstIndex,
+  LOCATION_INDEX_TYPE* indices) {
+  const size_t lastWord = wordCount - 1;
+  uint64_t state = key + (firstIndex * wordCount + 1) * SPLITMIX_GAMMA;
+  size_t count = 0;
+  for (size_t i = 0; i < locationCount; i++) {
+    size_t distance = 0;
+    for (size_t w = 0; w < lastWord; w++, state += SPLITMIX_GAMMA) {
+      distance += __builtin_popcountll(
+        scalarSplitMix64(state) ^ address[w]);
+    }
+    distance += __builtin_popcountll(
+      (scalarSplitMix64(state) & lastMask) ^ address[lastWord]);
+    state += SPLITMIX_GAMMA;
+
+    indices[count] = firstIndex + i;
+    count += distance <= threshold;
+  }
+
+  return count;
+}
+
+}  // namespace
+}  // namespace sdm
@@ -0,0 +1,81 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "utility/random.h"
+
+namespace sdm {
+namespace {
+
+/**
+ * Fewest rows worth starting a thread for.
+ */
+constexpr size_t MIN_ROWS_PER_THREAD = 1 << 16;
+
+void generateRandomRowRange(
+  uint64_t seed,
+  size_t firstRow,
+  size_t lastRow,
+  size_t bitCount,
+  WORD_TYPE* rows) {
+  const size_t rowWordCount = wordCount(bitCount);
+  const WORD_TYPE mask = lastWordMask(bitCount);
+  const uint64_t key = counterRandomKey(seed);
+  for (size_t r = firstRow; r < lastRow; r++) {
+    WORD_TYPE* row = rows + r * rowWordCount;
+    for (size_t w = 0; w < rowWordCount; w++) {
+      row[w] = splitMix64(key + (r * rowWordCount + w + 1) * SPLITMIX_GAMMA);
+    }
+    row[rowWordCount - 1] &= mask;
+  }
+}
+
+}  // namespace
+
+void generateRandomRows(
+  uint64_t seed,
+  size_t rowCount,
+  size_t bitCount,
+  WORD_TYPE* rows,
+  size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  threadCount = std::max<size_t>(1, std::min(
+    threadCount, rowCount / MIN_ROWS_PER_THREAD));
+
+  const size_t rowsPerThread = (rowCount + threadCount - 1) / threadCount;
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < threadCount; t++) {
+    const size_t firstRow = std::min(rowCount, t * rowsPerThread);
+    const size_t lastRow = std::min(rowCount, firstRow + rowsPerThread);
+    threads.emplace_back(generateRandomRowRange, seed, firstRow, lastRow,
+                         bitCount, rows);
+  }
+  generateRandomRowRange(seed, 0, std::min(rowCount, rowsPerThread), bitCount,
+                         rows);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace sdm
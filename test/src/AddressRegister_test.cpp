@@ -17,7 +17,13 @@
  */
 
 #include <gmpxx.h>
+#include <algorithm>
+#include <bitset>
 #include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "sdm"
 
@@ -33,45 +39,348 @@ SCENARIO("Address register converts location addresses to hard location",
     sdm::AddressRegister<256, hardLocationBitCount> addressRegister;
 
     WHEN("I accessed the location addresses.") {
-      array<mpz_class, hardLocationCount> locationAddress;
-      mpz_class* lastAddress = &locationAddress.at(0);
+      auto locationAddresses = addressRegister.getLocationAddresses();
 
-      mpz_class offsetAdder;
-      mpz_ui_pow_ui(offsetAdder.get_mpz_t(), 2, 256 - hardLocationBitCount);
+      THEN("Then it contains the appropriate addresses.") {
+        REQUIRE(locationAddresses.size() == hardLocationCount);
+        REQUIRE(locationAddresses.columns() == 4);
+        REQUIRE(locationAddresses[0].size() == 4);
+        REQUIRE(reinterpret_cast<uintptr_t>(locationAddresses.data()) %
+                sdm::CACHE_LINE_SIZE == 0);
+
+        // Rows are contiguous.
+        REQUIRE(addressRegister.getLocationAddress(1).data() ==
+                locationAddresses.data() + 4);
 
-      for (size_t addrIndex = 1;
-           addrIndex < locationAddress.size();
-           addrIndex++) {
-        locationAddress.at(addrIndex) = *lastAddress + offsetAdder;
-        lastAddress = &locationAddress.at(addrIndex);
+        // Random addresses are distinct.
+        REQUIRE(locationAddresses[0][0] != locationAddresses[1][0]);
       }
-      THEN("Then it contains the appropriate addresses.") {
-        REQUIRE(
-          locationAddress.size() ==
-          addressRegister.getLocationAddresses().size());
+    }
+
+    WHEN("I get the hamming distance of an address.") {
+      mpz_class address;
+      mpz_ui_pow_ui(address.get_mpz_t(), 2, 255);
+      address -= 12345;
+      auto hda = addressRegister.getHammingDistanceArray(address);
 
+      THEN("It is the same as the mpz hamming distance.") {
         for (size_t addrIndex = 0;
-             addrIndex < locationAddress.size();
+             addrIndex < hardLocationCount;
              addrIndex++) {
-          /*REQUIRE(
-            cmp(locationAddress[addrIndex],
-                addressRegister.getLocationAddresses()[addrIndex]) == 0);*/
+          auto location = addressRegister.getLocationAddress(addrIndex);
+          mpz_class locationMpz;
+          mpz_import(locationMpz.get_mpz_t(), location.size(), -1,
+                     sizeof(sdm::WORD_TYPE), 0, 0, location.data());
+          REQUIRE(hda[addrIndex] ==
+                  mpz_hamdist(address.get_mpz_t(), locationMpz.get_mpz_t()));
         }
       }
     }
   }
 
-  GIVEN("Instantiate 8 bit to 4 location addresses.") {
+  GIVEN("Instantiate 4 bit to 4 location addresses.") {
     constexpr size_t hardLocationBitCount = 2;
     sdm::AddressRegister<4, hardLocationBitCount> addressRegister;
-    constexpr size_t hardLocationCount = std::exp2(hardLocationBitCount);
 
-    WHEN("I accessed the hamming for 0110, middle case for 8 bit.") {
-      THEN("hammingDistanceArray is (2, 2, 3, 2, 3") {
-        //sdm::hammingDistanceArray<hardLocationCount> hda({2, 1, 3, 2});
-        /*REQUIRE(addressRegister.getHammingDistanceArray(
-          std::bitset<hardLocationCount>(std::string("0110"))) ==
-          hda);*/
+    WHEN("I accessed the location addresses.") {
+      THEN("The bits above the address bits are 0.") {
+        for (size_t addrIndex = 0; addrIndex < 4; addrIndex++) {
+          REQUIRE(addressRegister.getLocationAddress(addrIndex)[0] < 16);
+        }
+      }
+    }
+
+    WHEN("I get the hamming distance for 0110.") {
+      auto hda = addressRegister.getHammingDistanceArray(
+        std::bitset<4>(std::string("0110")));
+
+      THEN("It counts the differing bits of each location.") {
+        for (size_t addrIndex = 0; addrIndex < 4; addrIndex++) {
+          std::bitset<4> location(
+            addressRegister.getLocationAddress(addrIndex)[0]);
+          REQUIRE(hda[addrIndex] ==
+                  (location ^ std::bitset<4>("0110")).count());
+        }
+      }
+    }
+  }
+
+  GIVEN("Instantiate 130 bit to 16 location addresses.") {
+    sdm::AddressRegister<130, 4> addressRegister;
+    std::bitset<130> address;
+    address[0] = 1;
+    address[64] = 1;
+    address[129] = 1;
+
+    WHEN("I pack the address.") {
+      std::array<sdm::WORD_TYPE, 3> words;
+      sdm::bitsetToWords(address, words.data());
+
+      THEN("Each bit lands in its word.") {
+        REQUIRE(words[0] == 1);
+        REQUIRE(words[1] == 1);
+        REQUIRE(words[2] == 2);
+      }
+
+      THEN("The packed and bitset distances are the same.") {
+        REQUIRE(addressRegister.getHammingDistanceArray(
+                  sdm::Span<const sdm::WORD_TYPE>(words.data(), 3)) ==
+                addressRegister.getHammingDistanceArray(address));
+      }
+    }
+
+    WHEN("I unpack words whose unused high bits are set.") {
+      std::array<sdm::WORD_TYPE, 3> words = {{1, 1, ~sdm::WORD_TYPE(1)}};
+      std::bitset<130> unpacked = sdm::wordsToBitset<130>(words.data());
+
+      THEN("Only the bits of the address are kept.") {
+        REQUIRE(unpacked == address);
+      }
+    }
+  }
+
+  GIVEN("Instantiate 1024 bit to 4096 location addresses.") {
+    sdm::AddressRegister<1024, 12> addressRegister;
+    std::bitset<1024> address;
+    // Close to location 0, so a small threshold still activates it.
+    auto location = addressRegister.getLocationAddress(0);
+    for (size_t i = 0; i < 1024; i++) {
+      address[i] = ((location[i / 64] >> (i % 64)) & 1) ^ (i % 10 == 0);
+    }
+
+    WHEN("I activate with a threshold far below half the address width.") {
+      const size_t threshold = 120;
+      sdm::activationList activated;
+      addressRegister.activate(address, threshold, &activated);
+
+      THEN("The early exit scan activates the same locations as the "
+           "distance array.") {
+        auto hda = addressRegister.getHammingDistanceArray(address);
+        sdm::activationList expected;
+        for (size_t addrIndex = 0; addrIndex < hda.size(); addrIndex++) {
+          if (hda[addrIndex] <= threshold) {
+            expected.push_back(addrIndex);
+          }
+        }
+        REQUIRE(!expected.empty());
+        REQUIRE(activated == expected);
+      }
+    }
+  }
+
+  GIVEN("Seeded 100 bit to 2^18 location addresses.") {
+    using AddressRegister = sdm::AddressRegister<100, 18>;
+    AddressRegister oneThread(42, 1);
+    AddressRegister fourThreads(42, 4);
+    AddressRegister otherSeed(43);
+
+    THEN("The addresses only depend on the seed.") {
+      auto lhs = oneThread.getLocationAddresses();
+      auto rhs = fourThreads.getLocationAddresses();
+      REQUIRE(std::equal(lhs.data(), lhs.data() + lhs.size() * 2,
+                         rhs.data()));
+      REQUIRE(otherSeed.getLocationAddress(0)[0] != lhs[0][0]);
+    }
+
+    THEN("The bits are random and the unused high bits are cleared.") {
+      size_t setBitCount = 0;
+      for (size_t i = 0; i < AddressRegister::HARD_LOCATION_COUNT; i++) {
+        auto location = oneThread.getLocationAddress(i);
+        REQUIRE((location[1] >> 36) == 0);
+        setBitCount += __builtin_popcountll(location[0]) +
+                       __builtin_popcountll(location[1]);
+      }
+      const double mean = static_cast<double>(setBitCount) /
+                          AddressRegister::HARD_LOCATION_COUNT;
+      REQUIRE(mean > 49.9);
+      REQUIRE(mean < 50.1);
+    }
+  }
+
+  GIVEN("Seeded 256 bit to 3000 location addresses.") {
+    sdm::AddressRegister<256, 12> addressRegister(7, 0, 3000);
+    sdm::AddressRegister<256, 12> powerOfTwo(7);
+
+    THEN("There are exactly 3000 hard locations.") {
+      REQUIRE(addressRegister.getHardLocationCount() == 3000);
+      REQUIRE(addressRegister.getLocationAddresses().size() == 3000);
+      REQUIRE(powerOfTwo.getHardLocationCount() == 4096);
+    }
+
+    THEN("They are the first addresses of the same seed.") {
+      auto lhs = addressRegister.getLocationAddresses();
+      REQUIRE(std::equal(lhs.data(), lhs.data() + 3000 * 4,
+                         powerOfTwo.getLocationAddresses().data()));
+    }
+
+    WHEN("I activate an address.") {
+      std::bitset<256> address;
+      for (size_t i = 0; i < 256; i += 3) {
+        address[i] = 1;
+      }
+      const size_t threshold = 118;
+      sdm::activationList activated;
+      addressRegister.activate(address, threshold, &activated);
+
+      THEN("Only the 3000 locations are candidates.") {
+        auto hda = addressRegister.getHammingDistanceArray(address);
+        REQUIRE(hda.size() == 3000);
+        sdm::activationList expected;
+        for (size_t addrIndex = 0; addrIndex < hda.size(); addrIndex++) {
+          if (hda[addrIndex] <= threshold) {
+            expected.push_back(addrIndex);
+          }
+        }
+        REQUIRE(!expected.empty());
+        REQUIRE(activated == expected);
+      }
+    }
+
+    WHEN("I ask for no hard location.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS((sdm::AddressRegister<256, 12>(7, 0, 0)),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Seeded 256 bit to 2^16 location addresses.") {
+    sdm::AddressRegister<256, 16> addressRegister(3);
+
+    WHEN("I calibrate the threshold to activate 0.1% of the locations.") {
+      const size_t threshold = addressRegister.calibrateThreshold(0.001);
+
+      THEN("Random addresses activate about 0.1% of the locations.") {
+        std::mt19937_64 rng(99);
+        std::vector<std::bitset<256>> addresses(32);
+        for (auto& address : addresses) {
+          for (size_t i = 0; i < 256; i++) {
+            address[i] = rng() & 1;
+          }
+        }
+
+        size_t activatedCount = 0;
+        sdm::activationList activated;
+        for (auto& address : addresses) {
+          addressRegister.activate(address, threshold, &activated);
+          activatedCount += activated.size();
+        }
+        const double fraction =
+          static_cast<double>(activatedCount) / addresses.size() / 65536;
+        REQUIRE(fraction > 0.0007);
+        REQUIRE(fraction < 0.003);
+
+        // The histogram of the same addresses agrees.
+        auto histogram = addressRegister.getDistanceHistogram(addresses);
+        REQUIRE(histogram.size() == 257);
+        size_t within = 0;
+        for (size_t d = 0; d <= threshold; d++) {
+          within += histogram[d];
+        }
+        REQUIRE(within == activatedCount);
+      }
+    }
+
+    WHEN("I sort the locations along the Gray code.") {
+      sdm::AddressRegister<256, 16> unsorted(3);
+      std::vector<size_t> permutation = addressRegister.sortLocations();
+
+      THEN("Each location moves to its place in the permutation.") {
+        REQUIRE(permutation.size() == 65536);
+        for (size_t i : {size_t(0), size_t(12345), size_t(65535)}) {
+          auto sorted = addressRegister.getLocationAddress(i);
+          auto original = unsorted.getLocationAddress(permutation[i]);
+          REQUIRE(std::equal(sorted.begin(), sorted.end(), original.begin()));
+        }
+
+        // Neighbours share their leading bits: along the reflected Gray
+        // code, the first bit only changes once, halfway.
+        size_t firstBitChanges = 0;
+        for (size_t i = 1; i < 65536; i++) {
+          firstBitChanges +=
+            (addressRegister.getLocationAddress(i)[0] & 1) !=
+            (addressRegister.getLocationAddress(i - 1)[0] & 1);
+        }
+        REQUIRE(firstBitChanges == 1);
+      }
+
+      THEN("The same locations are activated, under the new indices.") {
+        std::bitset<256> address(0x0123456789abcdefULL);
+        sdm::activationList activated;
+        addressRegister.activate(address, 110, &activated);
+        sdm::activationList expected;
+        unsorted.activate(address, 110, &expected);
+        REQUIRE(!expected.empty());
+        REQUIRE(activated.size() == expected.size());
+        for (auto& location : activated) {
+          location = permutation[location];
+        }
+        std::sort(activated.begin(), activated.end());
+        REQUIRE(activated == expected);
+      }
+    }
+
+    WHEN("I calibrate to the extremes.") {
+      THEN("The threshold stops at the farthest sampled location.") {
+        REQUIRE(addressRegister.calibrateThreshold(0) == 0);
+        const size_t all = addressRegister.calibrateThreshold(1);
+        REQUIRE(all > 150);
+        REQUIRE(all < 256);
+        REQUIRE(addressRegister.calibrateThreshold(0.9999) <= all);
+        REQUIRE_THROWS_AS(addressRegister.calibrateThreshold(1.5),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Seeded 256 bit addresses scattered around 128 cluster centers.") {
+    constexpr size_t clusterCount = 128;
+    constexpr size_t locationCount = clusterCount * 128;
+    sdm::AddressRegister<256, 0> addressRegister(1, 0, locationCount);
+    std::mt19937_64 rng(4);
+    std::vector<std::array<sdm::WORD_TYPE, 4>> centers(clusterCount);
+    for (auto& center : centers) {
+      for (auto& word : center) {
+        word = rng();
+      }
+    }
+    auto locations = addressRegister.getLocationAddresses();
+    for (size_t i = 0; i < locationCount; i++) {
+      const auto& center = centers[rng() % clusterCount];
+      std::copy(center.begin(), center.end(), locations[i].begin());
+      for (size_t flip = 0; flip < 16; flip++) {
+        const size_t bit = rng() % 256;
+        locations[i][bit / 64] ^= sdm::WORD_TYPE(1) << (bit % 64);
+      }
+    }
+
+    // Number of blocks of 64 consecutive locations, a 4 KiB page of 64 bit
+    // counters, that the addresses next to each center activate.
+    auto blocksTouched = [&]() {
+      size_t blockCount = 0;
+      for (const auto& center : centers) {
+        std::bitset<256> address;
+        for (size_t bit = 0; bit < 256; bit++) {
+          address[bit] = (center[bit / 64] >> (bit % 64)) & 1;
+        }
+        sdm::activationList activated;
+        addressRegister.activate(address, 40, &activated);
+        std::vector<size_t> blocks;
+        for (auto location : activated) {
+          blocks.push_back(location / 64);
+        }
+        blockCount += std::unique(blocks.begin(), blocks.end()) -
+                      blocks.begin();
+      }
+      return blockCount;
+    };
+
+    WHEN("I sort the locations along the Gray code.") {
+      const size_t unsortedBlocks = blocksTouched();
+      addressRegister.sortLocations();
+
+      THEN("An activation touches far fewer blocks of the counter grid.") {
+        REQUIRE(2 * blocksTouched() < unsortedBlocks);
       }
     }
   }
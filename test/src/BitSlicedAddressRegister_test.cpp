@@ -0,0 +1,166 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <bitset>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Bit-sliced address register activates the same locations as the "
+         "row-major one.",
+         "[sdm::BitSlicedAddressRegister]") {
+  GIVEN("256 bit addresses to 4096 hard locations.") {
+    constexpr size_t addressBitCount = 256;
+    constexpr size_t hardLocationBitCount = 12;
+    auto addressRegister = sdm::AddressRegisterFactory<
+      addressBitCount, hardLocationBitCount>().get();
+    sdm::BitSlicedAddressRegister<addressBitCount, hardLocationBitCount>
+      bitSliced;
+
+    std::mt19937_64 rng(5);
+    for (size_t threshold : {0, 100, 112, 128}) {
+      WHEN("I activate within " + std::to_string(threshold)) {
+        THEN("The activated locations are the same.") {
+          for (size_t query = 0; query < 8; query++) {
+            std::bitset<addressBitCount> address;
+            for (size_t i = 0; i < addressBitCount; i++) {
+              address[i] = rng() & 1;
+            }
+
+            sdm::activationList expected;
+            addressRegister->activate(address, threshold, &expected);
+            sdm::activationList activated;
+            bitSliced.activate(address, threshold, &activated);
+            REQUIRE(activated == expected);
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("An SDM over a bit-sliced register of 8 hard locations.") {
+    auto sliced = std::make_shared<sdm::SDM<4, 3>>(
+      std::make_shared<sdm::BitSlicedAddressRegister<4, 3>>(),
+      sdm::UpDownCountersFactory<4, 3>(0.01F).get(), 1);
+    auto scanned = sdm::SDMFactory<4, 3>(1).get();
+
+    WHEN("I write and read the same data in both.") {
+      sliced->write(0b1010, 0b0110);
+      scanned->write(0b1010, 0b0110);
+
+      THEN("They read the same.") {
+        REQUIRE(sliced->getAddressRegister() == nullptr);
+        for (size_t address = 0; address < 16; address++) {
+          REQUIRE(sliced->read(address) == scanned->read(address));
+        }
+      }
+    }
+  }
+
+  GIVEN("A query drifting a few bits at a time.") {
+    constexpr size_t addressBitCount = 256;
+    sdm::AddressRegister<addressBitCount, 0> addressRegister(11, 0, 3000);
+    sdm::BitSlicedAddressRegister<addressBitCount, 0> bitSliced(
+      addressRegister);
+
+    std::mt19937_64 rng(13);
+    std::bitset<addressBitCount> address;
+    for (size_t i = 0; i < addressBitCount; i++) {
+      address[i] = rng() & 1;
+    }
+    std::vector<sdm::WORD_TYPE> distances;
+    bitSliced.getDistances(address, &distances);
+
+    THEN("The distances are those of the address register.") {
+      auto expected = addressRegister.getHammingDistanceArray(address);
+      for (size_t i = 0; i < 3000; i++) {
+        REQUIRE(bitSliced.getDistance(distances, i) == expected[i]);
+      }
+    }
+
+    WHEN("I update the activation after each drift.") {
+      THEN("It matches a full activation of the new address.") {
+        for (size_t step = 0; step < 10; step++) {
+          std::vector<size_t> flippedBits;
+          for (size_t f = 0; f < 3; f++) {
+            const size_t bit = (step * 37 + f * 91) % addressBitCount;
+            flippedBits.push_back(bit);
+            address.flip(bit);
+          }
+
+          sdm::activationList activated;
+          bitSliced.updateActivation(address, flippedBits, 112, &distances,
+                                     &activated);
+          sdm::activationList expected;
+          addressRegister.activate(address, 112, &expected);
+          REQUIRE(activated == expected);
+        }
+      }
+    }
+
+    WHEN("The distances or flipped bits do not fit the register.") {
+      THEN("The update throws.") {
+        sdm::activationList activated;
+        std::vector<sdm::WORD_TYPE> shortDistances(10);
+        std::vector<size_t> noFlip;
+        REQUIRE_THROWS_AS(
+          bitSliced.updateActivation(address, noFlip, 112, &shortDistances,
+                                     &activated),
+          const std::invalid_argument&);
+        std::vector<size_t> outOfRange = {addressBitCount};
+        REQUIRE_THROWS_AS(
+          bitSliced.updateActivation(address, outOfRange, 112, &distances,
+                                     &activated),
+          const std::invalid_argument&);
+        std::vector<size_t> repeated = {3, 3};
+        REQUIRE_THROWS_AS(
+          bitSliced.updateActivation(address, repeated, 112, &distances,
+                                     &activated),
+          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("128 bit addresses to 1000 hard locations, half a slice short.") {
+    sdm::AddressRegister<128, 0> addressRegister(3, 0, 1000);
+    sdm::BitSlicedAddressRegister<128, 0> bitSliced(addressRegister);
+
+    THEN("The last slice is padded.") {
+      REQUIRE(bitSliced.getHardLocationCount() == 1000);
+      REQUIRE(bitSliced.getSliceCount() == 2);
+    }
+
+    WHEN("I activate within half the address width.") {
+      THEN("The activated locations are the same.") {
+        std::bitset<128> address(0x0f0f0f0f0f0f0f0f);
+        sdm::activationList expected;
+        addressRegister.activate(address, 64, &expected);
+        sdm::activationList activated;
+        bitSliced.activate(address, 64, &activated);
+        REQUIRE(expected.back() < 1000);
+        REQUIRE(activated == expected);
+      }
+    }
+  }
+}
@@ -0,0 +1,131 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitset>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+using std::vector;
+
+SCENARIO("Bit-sliced counters read and write like narrow counters.",
+         "[sdm::UpDownCounters][sdm::BitSlicedCounter]") {
+  GIVEN("8 bit counters, bit-sliced and not, over 40 hard locations.") {
+    constexpr size_t bitCount = 300;
+    constexpr size_t hardLocationCount = 40;
+    sdm::UpDownCounters<bitCount, 6, sdm::BitSlicedCounter<8>> bitSliced(
+      1.0F, hardLocationCount);
+    sdm::UpDownCounters<bitCount, 6, int8_t> narrow(1.0F, hardLocationCount);
+
+    WHEN("I write random data to random hard locations, often enough to "
+         "saturate some.") {
+      std::mt19937_64 rng(42);
+      for (int i = 0; i < 2000; i++) {
+        vector<sdm::LOCATION_INDEX_TYPE> activated(rng() % 8);
+        for (auto& location : activated) {
+          location = rng() % (i % 2 ? 4 : hardLocationCount);
+        }
+        std::bitset<bitCount> data;
+        for (size_t bit = 0; bit < bitCount; bit++) {
+          data[bit] = rng() % 4 != 0;
+        }
+        bitSliced.write(activated, data);
+        narrow.write(activated, data);
+      }
+
+      THEN("Every counter is the same.") {
+        auto counters = narrow.getCounters();
+        bool saturated = false;
+        for (size_t location = 0; location < hardLocationCount; location++) {
+          for (size_t bit = 0; bit < bitCount; bit++) {
+            REQUIRE(bitSliced.getCounter(location, bit) ==
+                    counters[location][bit]);
+            saturated |= counters[location][bit] == 127;
+          }
+        }
+        REQUIRE(saturated);
+      }
+
+      THEN("Every read is the same.") {
+        for (int i = 0; i < 50; i++) {
+          vector<sdm::LOCATION_INDEX_TYPE> activated(rng() % 300);
+          for (auto& location : activated) {
+            location = rng() % hardLocationCount;
+          }
+          REQUIRE(bitSliced.read(activated) == narrow.read(activated));
+        }
+      }
+
+      THEN("Permuted hard locations keep their counters.") {
+        vector<size_t> permutation(hardLocationCount);
+        std::iota(permutation.rbegin(), permutation.rend(), 0);
+        bitSliced.permuteLocations(permutation);
+        narrow.permuteLocations(permutation);
+        vector<sdm::LOCATION_INDEX_TYPE> activated = {0, 3, 17, 39};
+        REQUIRE(bitSliced.read(activated) == narrow.read(activated));
+        REQUIRE(bitSliced.getCounter(0, 5) == narrow.getCounters()[0][5]);
+      }
+    }
+  }
+
+  GIVEN("4 bit bit-sliced counters.") {
+    sdm::UpDownCounters<64, 1, sdm::BitSlicedCounter<4>> upDownCounters(
+      1.0F, 2);
+
+    THEN("A row of 64 counters fills half a cache line, padded to one.") {
+      REQUIRE(sizeof(decltype(upDownCounters)::CounterRow) == 64);
+    }
+
+    WHEN("I write the same data more times than a counter holds.") {
+      for (int i = 0; i < 20; i++) {
+        upDownCounters.write({1, 0}, 0b01);
+      }
+
+      THEN("The counters stop at their bounds instead of wrapping.") {
+        REQUIRE(upDownCounters.getCounter(0, 0) == 7);
+        REQUIRE(upDownCounters.getCounter(0, 1) == -8);
+        REQUIRE(upDownCounters.getCounter(1, 0) == 0);
+        REQUIRE(upDownCounters.read({1, 0}) == 0b01);
+        REQUIRE(upDownCounters.read({1, 1}) == 0b01);
+      }
+
+      THEN("They still move back from their bounds.") {
+        upDownCounters.write({1, 0}, 0b10);
+        REQUIRE(upDownCounters.getCounter(0, 0) == 6);
+        REQUIRE(upDownCounters.getCounter(0, 1) == -7);
+      }
+    }
+
+    WHEN("I pass an index past the last hard location.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          upDownCounters.write(sdm::activationList{0, 2}, 0b1),
+          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(upDownCounters.read(sdm::activationList{2}),
+                          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(upDownCounters.read({1, 0, 1}),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+}
@@ -0,0 +1,95 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <bitset>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Multi-bank SDM activates once for every bank.",
+         "[sdm::MultiBankSDM]") {
+  GIVEN("Three banks of 2000 hard locations over one register.") {
+    auto addressRegister =
+      sdm::SharedAddressRegisterFactory<64, 0>(2, 2000).get();
+    std::vector<sdm::spUpDownCounters<16, 0>> banks;
+    for (size_t bank = 0; bank < 3; bank++) {
+      banks.push_back(sdm::UpDownCountersFactory<16, 0>(0.01F, 2000).get());
+    }
+    sdm::MultiBankSDM<64, 0, 16> memory(addressRegister, banks, 25);
+    auto singleCounters = sdm::UpDownCountersFactory<16, 0>(0.01F, 2000).get();
+    sdm::SDM<64, 0, 16> single(addressRegister, singleCounters, 25);
+
+    THEN("It has the banks.") {
+      REQUIRE(memory.getBankCount() == 3);
+      REQUIRE(memory.getBank(2) == banks[2]);
+    }
+
+    WHEN("I write a data per bank at an address.") {
+      std::bitset<64> address(0xfeedfacecafebeefULL);
+      std::vector<std::bitset<16>> data = {0x1111, 0x2222, 0x4444};
+      sdm::Workspace workspace;
+      memory.writeBanks(address, data, &workspace);
+      single.write(address, data[1]);
+
+      THEN("Each bank reads back its own data.") {
+        std::vector<std::bitset<16>> read(3);
+        memory.readBanks(address, read, &workspace);
+        REQUIRE(read == data);
+        REQUIRE(memory.read(address) == data[0]);
+      }
+
+      THEN("Each bank holds what a single SDM would.") {
+        for (size_t location = 0; location < 2000; location++) {
+          REQUIRE(banks[1]->getCounters()[location][1] ==
+                  singleCounters->getCounters()[location][1]);
+        }
+      }
+    }
+
+    WHEN("I pass a data count other than the bank count.") {
+      THEN("It is refused.") {
+        std::vector<std::bitset<16>> data(2);
+        REQUIRE_THROWS_AS(memory.writeBanks(0, data),
+                          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(memory.readBanks(0, data),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Banks that do not fit the register.") {
+    auto addressRegister =
+      sdm::SharedAddressRegisterFactory<64, 0>(2, 2000).get();
+
+    THEN("The constructor throws.") {
+      std::vector<sdm::spUpDownCounters<16, 0>> none;
+      REQUIRE_THROWS_AS((sdm::MultiBankSDM<64, 0, 16>(
+        addressRegister, none, 25)), const std::invalid_argument&);
+      std::vector<sdm::spUpDownCounters<16, 0>> small = {
+        sdm::UpDownCountersFactory<16, 0>(0.01F, 1000).get()};
+      REQUIRE_THROWS_AS((sdm::MultiBankSDM<64, 0, 16>(
+        addressRegister, small, 25)), const std::invalid_argument&);
+    }
+  }
+}
@@ -0,0 +1,130 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Multi-index hashing activates the same locations as the scan.",
+         "[sdm::MultiIndexHashing]") {
+  GIVEN("An index over 64 bit to 4096 location addresses.") {
+    constexpr size_t addressBitCount = 64;
+    constexpr size_t hardLocationBitCount = 12;
+    auto addressRegister = sdm::AddressRegisterFactory<
+      addressBitCount, hardLocationBitCount>().get();
+    sdm::MultiIndexHashing<addressBitCount, hardLocationBitCount> index(
+      addressRegister);
+
+    THEN("Substrings are at most log2(hard location count) bits.") {
+      REQUIRE(index.getSubstringCount() == 6);
+    }
+
+    std::mt19937_64 rng(3);
+    for (size_t threshold : {0, 4, 9, 14, 30}) {
+      WHEN("I activate within " + std::to_string(threshold)) {
+        THEN("The activated locations are the scan's.") {
+          for (size_t query = 0; query < 32; query++) {
+            // Half the queries are near a hard location.
+            std::bitset<addressBitCount> address(
+              query % 2 == 0 ?
+              addressRegister->getLocationAddress(rng() % 4096)[0] ^
+                (rng() & rng() & rng()) :
+              rng());
+
+            sdm::activationList expected;
+            addressRegister->activate(address, threshold, &expected);
+            sdm::activationList activated;
+            index.activate(address, threshold, &activated);
+            REQUIRE(activated == expected);
+          }
+        }
+      }
+    }
+
+    WHEN("The threshold is small.") {
+      THEN("The index is expected to be cheaper than a scan.") {
+        REQUIRE(index.getExpectedCost(9) < 4096 / 8);
+      }
+    }
+  }
+
+  GIVEN("An index over 100 bit addresses with 5 substrings.") {
+    auto addressRegister = sdm::AddressRegisterFactory<100, 10>().get();
+    sdm::MultiIndexHashing<100, 10> index(addressRegister, 5);
+    std::bitset<100> address;
+    for (size_t i = 0; i < 100; i++) {
+      address[i] =
+        (addressRegister->getLocationAddress(7)[i / 64] >> (i % 64)) & 1;
+    }
+    address.flip(3).flip(63).flip(64).flip(99);
+
+    WHEN("I activate around a hard location.") {
+      sdm::activationList activated;
+      index.activate(address, 12, &activated);
+
+      THEN("It is found, across the word boundary.") {
+        sdm::activationList expected;
+        addressRegister->activate(address, 12, &expected);
+        REQUIRE(activated == expected);
+        REQUIRE(std::find(activated.begin(), activated.end(), 7) !=
+                activated.end());
+      }
+    }
+  }
+
+  GIVEN("Substrings wider than the maximum.") {
+    auto addressRegister = sdm::AddressRegisterFactory<128, 4>().get();
+
+    THEN("The index refuses to build.") {
+      REQUIRE_THROWS_AS(
+        (sdm::MultiIndexHashing<128, 4>(addressRegister, 2)),
+        const std::invalid_argument&);
+    }
+  }
+
+  GIVEN("An index over 64 bit to 3000 location addresses.") {
+    auto addressRegister =
+      sdm::AddressRegisterFactory<64, 0>(9, 0, 3000).get();
+    sdm::MultiIndexHashing<64, 0> index(addressRegister);
+
+    THEN("Substrings are at most ceil(log2(3000)) bits.") {
+      REQUIRE(index.getHardLocationCount() == 3000);
+      REQUIRE(index.getSubstringCount() == 6);
+    }
+
+    WHEN("I activate around a hard location.") {
+      std::bitset<64> address(
+        addressRegister->getLocationAddress(2999)[0] ^ 0x8001);
+
+      THEN("The activated locations are the scan's.") {
+        sdm::activationList expected;
+        addressRegister->activate(address, 9, &expected);
+        sdm::activationList activated;
+        index.activate(address, 9, &activated);
+        REQUIRE(expected.back() == 2999);
+        REQUIRE(activated == expected);
+      }
+    }
+  }
+}
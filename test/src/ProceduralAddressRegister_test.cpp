@@ -0,0 +1,138 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <bitset>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Procedural address register activates the same locations as the "
+         "stored one.",
+         "[sdm::ProceduralAddressRegister]") {
+  GIVEN("128 bit addresses to 2^14 hard locations.") {
+    constexpr size_t addressBitCount = 128;
+    constexpr size_t hardLocationBitCount = 14;
+    constexpr uint64_t seed = 2016;
+    sdm::AddressRegister<addressBitCount, hardLocationBitCount>
+      addressRegister(seed);
+    sdm::ProceduralAddressRegister<addressBitCount, hardLocationBitCount>
+      procedural(seed);
+
+    THEN("The regenerated addresses are the stored ones.") {
+      for (size_t location : {0, 1, 12345, 16383}) {
+        auto stored = addressRegister.getLocationAddress(location);
+        auto regenerated = procedural.getLocationAddress(location);
+        REQUIRE(regenerated[0] == stored[0]);
+        REQUIRE(regenerated[1] == stored[1]);
+      }
+    }
+
+    std::mt19937_64 rng(8);
+    for (size_t threshold : {0, 50, 56}) {
+      WHEN("I activate within " + std::to_string(threshold)) {
+        THEN("The activated locations are the same.") {
+          for (size_t query = 0; query < 8; query++) {
+            std::bitset<addressBitCount> address(rng());
+            address <<= 64;
+            address |= std::bitset<addressBitCount>(rng());
+
+            sdm::activationList expected;
+            addressRegister.activate(address, threshold, &expected);
+            sdm::activationList activated;
+            procedural.activate(address, threshold, &activated);
+            REQUIRE(activated == expected);
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("An SDM over a procedural register.") {
+    auto procedural = std::make_shared<sdm::SDM<64, 12>>(
+      std::make_shared<sdm::ProceduralAddressRegister<64, 12>>(1),
+      sdm::UpDownCountersFactory<64, 12>(0.01F).get(), 24);
+    auto stored = std::make_shared<sdm::SDM<64, 12>>(
+      sdm::AddressRegisterFactory<64, 12>(1).get(),
+      sdm::UpDownCountersFactory<64, 12>(0.01F).get(), 24);
+
+    WHEN("I write and read the same data in both.") {
+      const std::bitset<64> address(0x0123456789abcdef);
+      const std::bitset<64> data(0xfedcba9876543210);
+      procedural->write(address, data);
+      stored->write(address, data);
+
+      THEN("They read the same.") {
+        REQUIRE(procedural->read(address) == data);
+        REQUIRE(procedural->read(address) == stored->read(address));
+        REQUIRE(procedural->read(~address) == stored->read(~address));
+      }
+    }
+  }
+
+  GIVEN("128 bit addresses to 3000 hard locations.") {
+    sdm::AddressRegister<128, 0> addressRegister(11, 0, 3000);
+    sdm::ProceduralAddressRegister<128, 0> procedural(11, 3000);
+
+    WHEN("I activate within half the address width.") {
+      THEN("The activated locations are the same.") {
+        std::bitset<128> address(0x00ff00ff00ff00ff);
+        sdm::activationList expected;
+        addressRegister.activate(address, 64, &expected);
+        sdm::activationList activated;
+        procedural.activate(address, 64, &activated);
+        REQUIRE(expected.back() < 3000);
+        REQUIRE(activated == expected);
+      }
+    }
+  }
+
+  GIVEN("The nearest locations of a procedural register.") {
+    sdm::AddressRegister<256, 0> addressRegister(17, 0, 5000);
+    sdm::ProceduralAddressRegister<256, 0> procedural(17, 5000);
+    std::bitset<256> address;
+    address[3] = address[100] = address[200] = 1;
+
+    for (size_t count : {0, 1, 64, 4999, 5000}) {
+      WHEN("I activate the " + std::to_string(count) + " nearest.") {
+        THEN("The threshold search selects the same as the counting "
+             "select.") {
+          sdm::activationList expected;
+          addressRegister.activateNearest(address, count, &expected);
+          sdm::activationList activated;
+          procedural.activateNearest(address, count, &activated);
+          REQUIRE(expected.size() == count);
+          REQUIRE(activated == expected);
+        }
+      }
+    }
+
+    WHEN("I activate more than all the locations.") {
+      THEN("It is refused.") {
+        sdm::activationList activated;
+        REQUIRE_THROWS_AS(procedural.activateNearest(address, 5001,
+                                                     &activated),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+}
@@ -17,6 +17,8 @@
  */
 
 #include <gmpxx.h>
+#include <random>
+#include <vector>
 
 #include "sdm"
 
@@ -171,4 +173,247 @@ SCENARIO("SDM read/write",
       }
     }
   }
+
+  GIVEN("Instantiate 64 bit address to 4096 hard locations with an index") {
+    constexpr size_t hardLocationBitCount = 12;
+    constexpr size_t addressBitCount = 64;
+    constexpr size_t dataBitCount = 64;
+    auto indexed = sdm::SDMFactory<
+      addressBitCount,
+      hardLocationBitCount,
+      dataBitCount>(12).get();
+    auto scanned = sdm::SDMFactory<
+      addressBitCount,
+      hardLocationBitCount,
+      dataBitCount>(12).get();
+    indexed->setIndex(std::make_shared<
+      sdm::MultiIndexHashing<addressBitCount, hardLocationBitCount>>(
+        indexed->getAddressRegister()));
+
+    WHEN("I write and read the same data in both.") {
+      // The register is shared, so read through the const view.
+      const auto& addressRegister = *indexed->getAddressRegister();
+      bitset<64> address = addressRegister.getLocationAddress(5)[0] ^ 0x1010;
+      bitset<64> data = 0x0123456789abcdef;
+      indexed->write(address, data);
+      scanned->write(address, data);
+
+      THEN("They read the same.") {
+        REQUIRE(indexed->read(address) == data);
+        REQUIRE(indexed->read(address) == scanned->read(address));
+        REQUIRE(indexed->read(~address) == scanned->read(~address));
+      }
+    }
+
+    THEN("Both share the address register.") {
+      REQUIRE(indexed->getAddressRegister() == scanned->getAddressRegister());
+      REQUIRE(indexed->getAddressRegister()->isShared());
+    }
+
+    WHEN("I set an index of another address register.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          indexed->setIndex(std::make_shared<
+            sdm::MultiIndexHashing<addressBitCount, hardLocationBitCount>>(
+              sdm::AddressRegisterFactory<
+                addressBitCount, hardLocationBitCount>().get())),
+          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Instantiate 128 bit address to 1024 hard locations") {
+    constexpr size_t hardLocationBitCount = 10;
+    constexpr size_t addressBitCount = 128;
+    constexpr size_t dataBitCount = 64;
+    auto batched = sdm::SDMFactory<
+      addressBitCount,
+      hardLocationBitCount,
+      dataBitCount>(56).get();
+    auto sequential = sdm::SDMFactory<
+      addressBitCount,
+      hardLocationBitCount,
+      dataBitCount>(56).get();
+
+    std::vector<bitset<addressBitCount>> addresses;
+    std::vector<bitset<dataBitCount>> data;
+    for (size_t i = 0; i < 7; i++) {
+      addresses.push_back(
+        (bitset<addressBitCount>(0x9e3779b97f4a7c15 * (i + 1)) << 64) |
+        bitset<addressBitCount>(0xbf58476d1ce4e5b9 * (i + 3)));
+      data.push_back(bitset<dataBitCount>(0x94d049bb133111eb * (i + 5)));
+    }
+
+    WHEN("I write and read a batch.") {
+      batched->writeBatch(addresses, data);
+      for (size_t i = 0; i < addresses.size(); i++) {
+        sequential->write(addresses[i], data[i]);
+      }
+
+      THEN("It is the same as writing and reading one at a time.") {
+        auto acquiredData = batched->readBatch(addresses);
+        REQUIRE(acquiredData.size() == addresses.size());
+        for (size_t i = 0; i < addresses.size(); i++) {
+          REQUIRE(acquiredData[i] == sequential->read(addresses[i]));
+          REQUIRE(acquiredData[i] == batched->read(addresses[i]));
+        }
+      }
+    }
+
+    WHEN("The batch sizes differ.") {
+      THEN("The write is refused.") {
+        data.pop_back();
+        REQUIRE_THROWS_AS(batched->writeBatch(addresses, data),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Instantiate 64 bit address to 3000 hard locations") {
+    auto memory = sdm::SDMFactory<64, 0>(24, 0.01F, 3000, 5).get();
+
+    WHEN("I write an address.") {
+      bitset<64> address = 0x0123456789abcdef;
+      memory->write(address, address);
+
+      THEN("It reads back.") {
+        REQUIRE(memory->getAddressDecoder()->getHardLocationCount() == 3000);
+        REQUIRE(memory->read(address) == address);
+      }
+    }
+
+    WHEN("The counters have another number of hard locations.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          (sdm::SDM<64, 0>(memory->getAddressDecoder(),
+                           sdm::UpDownCountersFactory<64, 0>(0.01F).get(),
+                           24)),
+          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Instantiate 128 bit address to 4096 hard locations activating the "
+        "32 nearest") {
+    auto memory = sdm::SDMFactory<128, 12>(0, 0.01F, 4096, 3).get();
+    memory->setActivationCount(32);
+    std::mt19937_64 rng(21);
+    vector<bitset<128>> addresses(6);
+    for (auto& address : addresses) {
+      address = bitset<128>(rng());
+      address <<= 64;
+      address |= bitset<128>(rng());
+    }
+
+    WHEN("I write each address as its own data.") {
+      // A threshold of 0 would activate nothing.
+      memory->writeBatch(addresses, addresses);
+
+      THEN("Each reads back.") {
+        REQUIRE(memory->getActivationCount() == 32);
+        for (auto& address : addresses) {
+          REQUIRE(memory->read(address) == address);
+        }
+        REQUIRE(memory->readBatch(addresses) == addresses);
+      }
+    }
+
+    WHEN("I activate more than all the hard locations.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(memory->setActivationCount(4097),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("Instantiate 64 bit address to 4096 hard locations with a guessed "
+        "threshold") {
+    auto memory = sdm::SDMFactory<64, 12>(0).get();
+
+    WHEN("I calibrate it to activate 1% of the locations.") {
+      const size_t threshold = memory->calibrateThreshold(0.01);
+
+      THEN("It replaces the guess.") {
+        REQUIRE(memory->getThreshold() == threshold);
+        REQUIRE(threshold ==
+                memory->getAddressRegister()->calibrateThreshold(0.01));
+        REQUIRE(threshold > 15);
+        REQUIRE(threshold < 25);
+      }
+    }
+
+    WHEN("I write then sort the hard locations of its own register.") {
+      sdm::SDM<64, 12> owner(
+        sdm::AddressRegisterFactory<64, 12>(0).get(),
+        sdm::UpDownCountersFactory<64, 12>(0.01F).get(), 20);
+      std::bitset<64> address(0xdeadbeefcafef00dULL);
+      std::bitset<64> data(0x0123456789abcdefULL);
+      owner.write(address, data);
+      owner.sortLocations();
+
+      THEN("The data reads back.") {
+        REQUIRE(owner.read(address) == data);
+      }
+    }
+
+    WHEN("I sort the hard locations of the factory's shared register.") {
+      THEN("It is refused, even with no other SDM holding it.") {
+        REQUIRE_THROWS_AS(memory->sortLocations(),
+                          const std::invalid_argument&);
+      }
+    }
+
+    WHEN("The SDM does not aggregate an AddressRegister.") {
+      sdm::SDM<64, 12> procedural(
+        std::make_shared<sdm::ProceduralAddressRegister<64, 12>>(1),
+        sdm::UpDownCountersFactory<64, 12>(0.01F).get(), 0);
+
+      THEN("It cannot be calibrated.") {
+        REQUIRE_THROWS_AS(procedural.calibrateThreshold(0.01),
+                          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(procedural.sortLocations(),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+}
+
+SCENARIO("SDM with 8 bit counters",
+         "[sdm::SDM]") {
+  GIVEN("An SDM of 4096 hard locations with 8 bit counters.") {
+    auto memory = sdm::SDMFactory<64, 12, 64, int8_t>(
+      20, 0.01F, 4096, 1).get();
+
+    WHEN("I write the same data many times.") {
+      std::bitset<64> address(0xdeadbeefcafef00dULL);
+      std::bitset<64> data(0x0123456789abcdefULL);
+      for (int i = 0; i < 300; i++) {
+        memory->write(address, data);
+      }
+
+      THEN("The data reads back.") {
+        REQUIRE(memory->read(address) == data);
+      }
+    }
+  }
+}
+
+SCENARIO("SDM with bit-sliced counters",
+         "[sdm::SDM]") {
+  GIVEN("An SDM of 4096 hard locations with 4 bit bit-sliced counters.") {
+    auto memory = sdm::SDMFactory<64, 12, 64, sdm::BitSlicedCounter<4>>(
+      20, 0.01F, 4096, 1).get();
+
+    WHEN("I write the same data many times.") {
+      std::bitset<64> address(0xdeadbeefcafef00dULL);
+      std::bitset<64> data(0x0123456789abcdefULL);
+      for (int i = 0; i < 30; i++) {
+        memory->write(address, data);
+      }
+
+      THEN("The data reads back.") {
+        REQUIRE(memory->read(address) == data);
+      }
+    }
+  }
 }
@@ -0,0 +1,154 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <bitset>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Selected-coordinate register activates the locations whose "
+         "selected bits match.",
+         "[sdm::SelectedCoordinateAddressRegister]") {
+  GIVEN("256 bit addresses to 3000 hard locations of 6 selected bits.") {
+    constexpr size_t addressBitCount = 256;
+    sdm::SelectedCoordinateAddressRegister<addressBitCount, 0>
+      addressRegister(7, 6, 3000);
+
+    THEN("Each location selects distinct bits of the address.") {
+      REQUIRE(addressRegister.getHardLocationCount() == 3000);
+      REQUIRE(addressRegister.getSelectedBitCount() == 6);
+      for (size_t i = 0; i < 3000; i++) {
+        std::set<size_t> distinct;
+        for (size_t j = 0; j < 6; j++) {
+          distinct.insert(addressRegister.getSelectedBit(i, j));
+        }
+        REQUIRE(distinct.size() == 6);
+        REQUIRE(*distinct.rbegin() < addressBitCount);
+      }
+    }
+
+    std::mt19937_64 rng(3);
+    for (size_t threshold : {0, 1, 2, 6}) {
+      WHEN("I activate within " + std::to_string(threshold)) {
+        THEN("The activated locations are those within threshold "
+             "mismatches.") {
+          for (size_t query = 0; query < 4; query++) {
+            std::bitset<addressBitCount> address;
+            for (size_t i = 0; i < addressBitCount; i++) {
+              address[i] = rng() & 1;
+            }
+
+            sdm::activationList expected;
+            for (size_t i = 0; i < 3000; i++) {
+              size_t mismatches = 0;
+              for (size_t j = 0; j < 6; j++) {
+                mismatches +=
+                  address[addressRegister.getSelectedBit(i, j)] !=
+                  addressRegister.getRequiredValue(i, j);
+              }
+              if (mismatches <= threshold) {
+                expected.push_back(i);
+              }
+            }
+
+            sdm::activationList activated;
+            addressRegister.activate(address, threshold, &activated);
+            REQUIRE(activated == expected);
+          }
+        }
+      }
+    }
+
+    WHEN("I activate the nearest 100.") {
+      sdm::activationList activated;
+      addressRegister.activateNearest(std::bitset<addressBitCount>(), 100,
+                                      &activated);
+
+      THEN("Exactly 100 are activated.") {
+        REQUIRE(activated.size() == 100);
+      }
+    }
+  }
+
+  GIVEN("Addresses too wide for the mismatch table.") {
+    constexpr size_t addressBitCount = 5000;
+    sdm::SelectedCoordinateAddressRegister<addressBitCount, 0>
+      addressRegister(9, 3, 4000);
+
+    WHEN("I activate within 1.") {
+      std::bitset<addressBitCount> address;
+      for (size_t i = 0; i < addressBitCount; i += 3) {
+        address[i] = 1;
+      }
+      sdm::activationList activated;
+      addressRegister.activate(address, 1, &activated);
+
+      THEN("The activated locations are those within 1 mismatch.") {
+        sdm::activationList expected;
+        for (size_t i = 0; i < 4000; i++) {
+          size_t mismatches = 0;
+          for (size_t j = 0; j < 3; j++) {
+            mismatches += address[addressRegister.getSelectedBit(i, j)] !=
+                          addressRegister.getRequiredValue(i, j);
+          }
+          if (mismatches <= 1) {
+            expected.push_back(i);
+          }
+        }
+        REQUIRE(!expected.empty());
+        REQUIRE(activated == expected);
+      }
+    }
+  }
+
+  GIVEN("An SDM over a selected-coordinate register.") {
+    auto memory = std::make_shared<sdm::SDM<64, 0>>(
+      std::make_shared<sdm::SelectedCoordinateAddressRegister<64, 0>>(
+        1, 4, 2000),
+      sdm::UpDownCountersFactory<64, 0>(0.01F, 2000).get(), 0);
+
+    WHEN("I write data at an address.") {
+      std::bitset<64> address(0x0123456789abcdef);
+      std::bitset<64> data(0xfedcba9876543210);
+      memory->write(address, data);
+
+      THEN("It reads back at the same address.") {
+        REQUIRE(memory->read(address) == data);
+      }
+    }
+  }
+
+  GIVEN("Selected bit counts out of range.") {
+    THEN("The constructor throws.") {
+      REQUIRE_THROWS_AS((sdm::SelectedCoordinateAddressRegister<8, 4>(1, 0)),
+                        const std::invalid_argument&);
+      REQUIRE_THROWS_AS((sdm::SelectedCoordinateAddressRegister<8, 4>(1, 9)),
+                        const std::invalid_argument&);
+      sdm::SelectedCoordinateAddressRegister<8, 4> narrow(1);
+      REQUIRE(narrow.getSelectedBitCount() == 8);
+    }
+  }
+}
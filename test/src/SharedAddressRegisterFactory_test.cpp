@@ -0,0 +1,88 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <memory>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("Shared address registers are interned per dimensions and seed.",
+         "[sdm::SharedAddressRegisterFactory]") {
+  GIVEN("Two registers of the same dimensions and seed.") {
+    auto lhs = sdm::SharedAddressRegisterFactory<128, 0>(5, 3000).get();
+    auto rhs = sdm::SharedAddressRegisterFactory<128, 0>(5, 3000).get();
+
+    THEN("They are the same instance.") {
+      REQUIRE(lhs == rhs);
+      REQUIRE(lhs->getHardLocationCount() == 3000);
+    }
+
+    THEN("Another seed, count or width gets another register.") {
+      auto otherSeed = sdm::SharedAddressRegisterFactory<128, 0>(6, 3000).get();
+      auto otherCount =
+        sdm::SharedAddressRegisterFactory<128, 0>(5, 2000).get();
+      REQUIRE(otherSeed != lhs);
+      REQUIRE(otherCount != lhs);
+      auto wider = sdm::SharedAddressRegisterFactory<256, 0>(5, 3000).get();
+      REQUIRE(wider->getHardLocationCount() == 3000);
+    }
+
+    THEN("They hold the addresses of an unshared register.") {
+      sdm::AddressRegister<128, 0> unshared(5, 0, 3000);
+      const auto& shared = *lhs;
+      REQUIRE(shared.getLocationAddress(2999)[1] ==
+              unshared.getLocationAddress(2999)[1]);
+      REQUIRE(!unshared.isShared());
+    }
+
+    THEN("Their addresses cannot be reordered or written.") {
+      REQUIRE(lhs->isShared());
+      REQUIRE_THROWS_AS(lhs->sortLocations(), const std::invalid_argument&);
+      REQUIRE_THROWS_AS(lhs->getLocationAddresses(),
+                        const std::invalid_argument&);
+      REQUIRE_THROWS_AS(lhs->getLocationAddress(0),
+                        const std::invalid_argument&);
+    }
+
+    WHEN("Every holder lets go of it.") {
+      std::weak_ptr<sdm::AddressRegister<128, 0>> weak = lhs;
+      lhs.reset();
+      rhs.reset();
+
+      THEN("It is freed.") {
+        REQUIRE(weak.expired());
+      }
+    }
+  }
+
+  GIVEN("SDMs built by the factory with the same dimensions.") {
+    auto lhs = sdm::SDMFactory<64, 0>(20, 0.01F, 4096, 1).get();
+    auto rhs = sdm::SDMFactory<64, 0>(20, 0.01F, 4096, 1).get();
+
+    THEN("They share the address register, not the counters.") {
+      REQUIRE(lhs->getAddressDecoder() == rhs->getAddressDecoder());
+      lhs->write(0x1234, 0x1234);
+      REQUIRE(lhs->read(0x1234) == 0x1234);
+      REQUIRE(rhs->read(0x1234) != 0x1234);
+      REQUIRE_THROWS_AS(lhs->sortLocations(), const std::invalid_argument&);
+    }
+  }
+}
@@ -21,6 +21,7 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include "sdm"
 
@@ -82,4 +83,246 @@ SCENARIO("UpDownCounters data storage.",
       }
     }
   }
+
+  GIVEN("Counters updated through activated hard location indices.") {
+    constexpr size_t hardLocationBitCount = 3;
+    sdm::UpDownCounters<64, hardLocationBitCount> upDownCounters(0.1F);
+    sdm::activationList activated { 1, 4, 6 };
+
+    WHEN("I write with the indices.") {
+      Converter c1;
+      c1.d = sdm::FLOAT(1.0F);
+      upDownCounters.write(activated, c1.i);
+
+      THEN("Only those rows are updated.") {
+        Converter c2;
+        c2.i = upDownCounters.read(activated).to_ullong();
+        REQUIRE(c2.d == sdm::FLOAT(1.0F));
+
+        c2.i = upDownCounters.read({0, 1, 0, 0, 1, 0, 1, 0}).to_ullong();
+        REQUIRE(c2.d == sdm::FLOAT(1.0F));
+
+        c2.i = upDownCounters.read({1, 0, 1, 1, 0, 1, 0, 1}).to_ullong();
+        REQUIRE(c2.d == sdm::FLOAT(0.0F));
+      }
+    }
+  }
+
+  GIVEN("Counters of 3 bits, narrower than a cache line.") {
+    sdm::UpDownCounters<3, 0> narrow(0.1F, 100);
+
+    THEN("Rows are padded to a cache line.") {
+      auto counters = narrow.getCounters();
+      REQUIRE(counters.columns() == 3);
+      REQUIRE(counters.stride() == 8);
+      REQUIRE(counters[1].data() - counters[0].data() == 8);
+    }
+
+    WHEN("I write and read adjacent rows.") {
+      narrow.write(sdm::activationList{6}, 0b101);
+      narrow.write(sdm::activationList{7}, 0b011);
+
+      THEN("They do not overlap.") {
+        REQUIRE(narrow.read(sdm::activationList{6}) == 0b101);
+        REQUIRE(narrow.read(sdm::activationList{7}) == 0b011);
+      }
+    }
+  }
+
+  GIVEN("A grid of several huge pages.") {
+    // 4 MiB of counters.
+    sdm::UpDownCounters<64, 13> onHugePages(0.1F);
+    sdm::UpDownCounters<64, 13> offHugePages(0.1F, 8192, false);
+
+    THEN("It starts on a huge page, unless asked not to.") {
+      REQUIRE(reinterpret_cast<uintptr_t>(
+        onHugePages.getCounters().data()) % sdm::HUGE_PAGE_SIZE == 0);
+      REQUIRE(reinterpret_cast<uintptr_t>(
+        offHugePages.getCounters().data()) % sdm::CACHE_LINE_SIZE == 0);
+    }
+  }
+
+  GIVEN("Counters of 5 hard locations.") {
+    sdm::UpDownCounters<64, 0> upDownCounters(0.1F, 5);
+
+    THEN("There is one row per hard location.") {
+      REQUIRE(upDownCounters.getHardLocationCount() == 5);
+      REQUIRE(upDownCounters.getCounters().size() == 5);
+      REQUIRE(upDownCounters.getCounters().columns() == 64);
+    }
+
+    WHEN("I write to the last hard location.") {
+      upDownCounters.write({0, 0, 0, 0, 1}, 0b101);
+
+      THEN("Only that row is updated.") {
+        REQUIRE(upDownCounters.read(sdm::activationList{4}) == 0b101);
+        REQUIRE(upDownCounters.getCounters()[4][0] == 1);
+        REQUIRE(upDownCounters.getCounters()[4][1] == -1);
+        REQUIRE(upDownCounters.getCounters()[3][0] == 0);
+      }
+    }
+
+    THEN("Each row starts on its own cache line.") {
+      auto counters = upDownCounters.getCounters();
+      REQUIRE(counters.stride() == 64);
+      REQUIRE(reinterpret_cast<uintptr_t>(counters[3].data()) %
+              sdm::CACHE_LINE_SIZE == 0);
+    }
+
+    WHEN("I permute the hard locations.") {
+      upDownCounters.write(sdm::activationList{1}, 0b11);
+      upDownCounters.write(sdm::activationList{4}, 0b01);
+      upDownCounters.permuteLocations(std::vector<size_t>{4, 1, 0, 2, 3});
+
+      THEN("The rows move along.") {
+        REQUIRE(upDownCounters.getCounters()[0][1] == -1);
+        REQUIRE(upDownCounters.getCounters()[1][1] == 1);
+        REQUIRE(upDownCounters.getCounters()[4][0] == 0);
+        REQUIRE_THROWS_AS(
+          upDownCounters.permuteLocations(std::vector<size_t>{0, 1, 1, 2, 3}),
+          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(
+          upDownCounters.permuteLocations(std::vector<size_t>{0, 1, 2, 3}),
+          const std::invalid_argument&);
+      }
+    }
+
+    WHEN("I pass an update flag per power of two hard locations.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(upDownCounters.read({0, 0, 0, 0, 1, 0, 0, 0}),
+                          const std::invalid_argument&);
+      }
+    }
+
+    WHEN("I pass an index past the last hard location.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          upDownCounters.write(sdm::activationList{1, 8}, 0b1),
+          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(upDownCounters.read(sdm::activationList{8}),
+                          const std::invalid_argument&);
+      }
+    }
+  }
+
+  GIVEN("No hard locations, or more than LOCATION_INDEX_TYPE indexes.") {
+    const size_t tooMany = size_t(sdm::LOCATION_INDEX_TYPE(-1)) + 2;
+
+    THEN("The counters are refused before the grid is allocated.") {
+      REQUIRE_THROWS_AS((sdm::UpDownCounters<64, 0>(0.1F, 0)),
+                        const std::invalid_argument&);
+      REQUIRE_THROWS_AS((sdm::UpDownCounters<64, 0>(0.1F, tooMany)),
+                        const std::invalid_argument&);
+      REQUIRE_THROWS_AS(
+        (sdm::UpDownCounters<64, 0, sdm::BitSlicedCounter<4>>(0.1F, 0)),
+        const std::invalid_argument&);
+    }
+  }
+}
+
+SCENARIO("Narrow counters saturate",
+         "[sdm::UpDownCounters]") {
+  GIVEN("8 bit counters.") {
+    sdm::UpDownCounters<64, 1, int8_t> upDownCounters(1.0F, 2);
+
+    THEN("A row of 64 counters fills exactly one cache line.") {
+      REQUIRE(upDownCounters.getCounters().stride() == 64);
+    }
+
+    WHEN("I write the same data more times than a counter holds.") {
+      for (int i = 0; i < 200; i++) {
+        upDownCounters.write({1, 0}, 0b01);
+      }
+
+      THEN("The counters stop at their bounds instead of wrapping.") {
+        auto counters = upDownCounters.getCounters();
+        REQUIRE(counters[0][0] == 127);
+        REQUIRE(counters[0][1] == -128);
+        REQUIRE(counters[1][0] == 0);
+        REQUIRE(upDownCounters.read({1, 0}) == 0b01);
+      }
+
+      THEN("They still move back from their bounds.") {
+        upDownCounters.write({1, 0}, 0b10);
+        auto counters = upDownCounters.getCounters();
+        REQUIRE(counters[0][0] == 126);
+        REQUIRE(counters[0][1] == -127);
+      }
+    }
+  }
+
+  GIVEN("8 bit counters read over many saturated hard locations.") {
+    sdm::UpDownCounters<8, 2, int8_t> upDownCounters(1.0F, 4);
+    for (int i = 0; i < 200; i++) {
+      upDownCounters.write({1, 1, 1, 1}, 0b1);
+    }
+
+    THEN("The sum is taken in a wider type.") {
+      REQUIRE(upDownCounters.read({1, 1, 1, 1}) == 0b1);
+    }
+  }
+}
+
+SCENARIO("Weighted writes and reads",
+         "[sdm::UpDownCounters]") {
+  GIVEN("8 bit counters.") {
+    sdm::UpDownCounters<64, 2, int8_t> upDownCounters(1.0F, 4);
+    const sdm::activationList activated = {1, 3};
+
+    WHEN("I write with weights.") {
+      upDownCounters.write(activated, std::vector<int8_t>{3, 100}, 0b01);
+      upDownCounters.write(activated, std::vector<int8_t>{3, 100}, 0b01);
+
+      THEN("The counters move by the weights, saturating.") {
+        auto counters = upDownCounters.getCounters();
+        REQUIRE(counters[1][0] == 6);
+        REQUIRE(counters[1][1] == -6);
+        REQUIRE(counters[3][0] == 127);
+        REQUIRE(counters[3][1] == -128);
+        REQUIRE(counters[0][0] == 0);
+      }
+
+      THEN("A read weighs each hard location.") {
+        upDownCounters.write(sdm::activationList{1}, 0b10);
+        // Row 1 reads 5, -5 then -7, row 3 127 then -128.
+        REQUIRE(upDownCounters.read(activated, std::vector<int8_t>{1, 0}) ==
+                0b01);
+        REQUIRE(upDownCounters.read(activated, std::vector<int8_t>{-1, 0}) ==
+                ~std::bitset<64>(0b01));
+        REQUIRE(upDownCounters.read(activated, std::vector<int8_t>{100, 1}) ==
+                0b01);
+      }
+    }
+
+    WHEN("I pass a weight per hard location instead of per activated one.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          upDownCounters.write(activated, std::vector<int8_t>{1, 1, 1, 1}, 1),
+          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(
+          upDownCounters.read(activated, std::vector<int8_t>{1}),
+          const std::invalid_argument&);
+      }
+    }
+
+    WHEN("I pass an index past the last hard location.") {
+      THEN("It is refused.") {
+        const sdm::activationList outside = {1, 4};
+        REQUIRE_THROWS_AS(
+          upDownCounters.write(outside, std::vector<int8_t>{1, 1}, 1),
+          const std::invalid_argument&);
+        REQUIRE_THROWS_AS(
+          upDownCounters.read(outside, std::vector<int8_t>{1, 1}),
+          const std::invalid_argument&);
+      }
+    }
+
+    WHEN("I pass a weight that cannot be negated.") {
+      THEN("It is refused.") {
+        REQUIRE_THROWS_AS(
+          upDownCounters.write(activated, std::vector<int8_t>{1, -128}, 1),
+          const std::invalid_argument&);
+      }
+    }
+  }
 }
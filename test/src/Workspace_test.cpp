@@ -0,0 +1,99 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <atomic>
+#include <bitset>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+namespace {
+
+std::atomic<size_t> allocationCount(0);
+
+}  // namespace
+
+// Counts every allocation of the test runner, so a test can check that a
+// code path does not allocate.
+void* operator new(size_t size) {
+  allocationCount++;
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+
+SCENARIO("Reads and writes through a workspace do not allocate.",
+         "[sdm::Workspace]") {
+  GIVEN("A 256 bit address to 2^14 hard locations SDM and a workspace.") {
+    auto memory = sdm::SDMFactory<256, 14>(0, 0.01F, 1 << 14, 1).get();
+    memory->calibrateThreshold(0.01);
+    sdm::Workspace workspace;
+
+    std::mt19937_64 rng(31);
+    std::vector<std::bitset<256>> addresses(8);
+    for (auto& address : addresses) {
+      for (size_t i = 0; i < 256; i++) {
+        address[i] = rng() & 1;
+      }
+    }
+    std::vector<std::bitset<256>> data(addresses.size());
+
+    for (size_t activationCount : {0, 64}) {
+      WHEN("Activating " + std::string(activationCount == 0 ?
+                                       "within the threshold" :
+                                       "the 64 nearest") +
+           ", the workspace has served each operation once.") {
+        memory->setActivationCount(activationCount);
+        auto operations = [&]() {
+          for (auto& address : addresses) {
+            memory->write(address, address, &workspace);
+            memory->read(address, &workspace);
+          }
+          memory->writeBatch(addresses, addresses, &workspace);
+          memory->readBatch(addresses, data, &workspace);
+        };
+        operations();
+
+        THEN("Doing them again allocates nothing.") {
+          // Read the count before REQUIRE, which allocates.
+          const size_t before = allocationCount;
+          operations();
+          const size_t after = allocationCount;
+          REQUIRE(after == before);
+          REQUIRE(data == addresses);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Hidden from the default run, run with: testRunner "[benchmark]"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+SCENARIO("UpDownCounters::read over clustered hard locations",
+         "[.][benchmark][sdm::UpDownCounters]") {
+  GIVEN("2^18 256 bit locations scattered around 2048 cluster centers.") {
+    constexpr size_t clusterCount = 2048;
+    constexpr size_t locationCount = clusterCount * 128;
+    constexpr size_t queryCount = 512;
+    constexpr size_t repeatCount = 4;
+    sdm::AddressRegister<256, 0> addressRegister(1, 0, locationCount);
+    std::mt19937_64 rng(3);
+    std::vector<std::array<sdm::WORD_TYPE, 4>> centers(clusterCount);
+    for (auto& center : centers) {
+      for (auto& word : center) {
+        word = rng();
+      }
+    }
+    auto locations = addressRegister.getLocationAddresses();
+    for (size_t i = 0; i < locationCount; i++) {
+      const auto& center = centers[rng() % clusterCount];
+      std::copy(center.begin(), center.end(), locations[i].begin());
+      for (size_t flip = 0; flip < 16; flip++) {
+        const size_t bit = rng() % 256;
+        locations[i][bit / 64] ^= sdm::WORD_TYPE(1) << (bit % 64);
+      }
+    }
+
+    // Addresses a few bits away from random centers.
+    std::vector<std::bitset<256>> addresses(queryCount);
+    for (auto& address : addresses) {
+      const auto& center = centers[rng() % clusterCount];
+      for (size_t bit = 0; bit < 256; bit++) {
+        address[bit] = (center[bit / 64] >> (bit % 64)) & 1;
+      }
+      for (size_t flip = 0; flip < 8; flip++) {
+        address.flip(rng() % 256);
+      }
+    }
+
+    // The grid of 64 bit counters takes 128 MiB, far more than the caches.
+    using UpDownCounters = sdm::UpDownCounters<64, 0>;
+    constexpr size_t rowsPerPage =
+      4096 / sizeof(UpDownCounters::CounterRow);
+
+    // Distinct 4 KiB pages of counters a read touches, and its time.
+    auto measure = [&](double* pageCount, double* microseconds) {
+      UpDownCounters counters(0.01F, locationCount);
+      std::vector<sdm::activationList> activated(queryCount);
+      size_t pages = 0;
+      for (size_t q = 0; q < queryCount; q++) {
+        addressRegister.activate(addresses[q], 48, &activated[q]);
+        counters.write(activated[q], std::bitset<64>(0x5555));
+        std::vector<size_t> rowPages;
+        for (auto location : activated[q]) {
+          rowPages.push_back(location / rowsPerPage);
+        }
+        pages += std::unique(rowPages.begin(), rowPages.end()) -
+                 rowPages.begin();
+      }
+
+      size_t setBitCount = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t repeat = 0; repeat < repeatCount; repeat++) {
+        for (const auto& locations : activated) {
+          setBitCount += counters.read(locations).count();
+        }
+      }
+      auto end = std::chrono::steady_clock::now();
+      REQUIRE(setBitCount == repeatCount * queryCount * 8);
+
+      *pageCount = static_cast<double>(pages) / queryCount;
+      *microseconds =
+        std::chrono::duration<double, std::micro>(end - start).count() /
+        (repeatCount * queryCount);
+    };
+
+    WHEN("I read before and after sorting the locations.") {
+      double unsortedPages, unsortedTime;
+      measure(&unsortedPages, &unsortedTime);
+      addressRegister.sortLocations();
+      double sortedPages, sortedTime;
+      measure(&sortedPages, &sortedTime);
+
+      std::cout << "UpDownCounters::read, clustered locations:" << std::endl
+                << "  unsorted: " << unsortedPages << " pages, "
+                << unsortedTime << " us" << std::endl
+                << "  sorted:   " << sortedPages << " pages, "
+                << sortedTime << " us" << std::endl;
+
+      THEN("A read touches fewer pages of counters.") {
+        REQUIRE(sortedPages < unsortedPages);
+      }
+    }
+  }
+}
@@ -0,0 +1,613 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+using std::vector;
+
+namespace {
+
+const sdm::KernelISA kernelISAs[] = {
+  sdm::KernelISA::GENERIC,
+  sdm::KernelISA::POPCNT,
+  sdm::KernelISA::AVX2,
+  sdm::KernelISA::AVX512_VPOPCNTDQ
+};
+
+/**
+ * Random counters, a quarter of them at a bound.
+ */
+template<typename COUNTER>
+vector<COUNTER> randomCounters(size_t count, std::mt19937_64* rng) {
+  vector<COUNTER> counters(count);
+  for (auto& counter : counters) {
+    const uint64_t r = (*rng)();
+    switch (r % 8) {
+      case 0:
+        counter = std::numeric_limits<COUNTER>::max();
+        break;
+      case 1:
+        counter = std::numeric_limits<COUNTER>::min();
+        break;
+      default:
+        counter = static_cast<COUNTER>(r >> 8);
+    }
+  }
+  return counters;
+}
+
+/**
+ * Writes random data to some rows of a random grid with each kernel and
+ * checks them against a counter at a time.
+ */
+template<typename COUNTER>
+void checkWriteCounterRows(size_t bitCount, std::mt19937_64* rng) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t laneCount = sdm::CACHE_LINE_SIZE / sizeof(COUNTER);
+  const size_t rowStride = (bitCount + laneCount - 1) / laneCount * laneCount;
+  constexpr size_t rowCount = 7;
+  const vector<sdm::LOCATION_INDEX_TYPE> rows = {5, 0, 3, 5, 6};
+
+  // The grid is cache line aligned, as in UpDownCounters.
+  sdm::AlignedBuffer<COUNTER> original(rowCount * rowStride);
+  auto counters = randomCounters<COUNTER>(rowCount * rowStride, rng);
+  std::copy(counters.begin(), counters.end(), original.data());
+  vector<sdm::WORD_TYPE> bits(sdm::wordCount(bitCount));
+  for (auto& word : bits) {
+    word = (*rng)();
+  }
+
+  vector<COUNTER> expected(original.data(),
+                           original.data() + rowCount * rowStride);
+  for (auto row : rows) {
+    for (size_t i = 0; i < bitCount; i++) {
+      COUNTER& counter = expected[row * rowStride + i];
+      if ((bits[i / sdm::WORD_BIT_SIZE] >> (i % sdm::WORD_BIT_SIZE)) & 1) {
+        counter += counter != std::numeric_limits<COUNTER>::max();
+      } else {
+        counter -= counter != std::numeric_limits<COUNTER>::min();
+      }
+    }
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+
+    sdm::AlignedBuffer<COUNTER> grid(original);
+    sdm::setKernelISA(isa);
+    sdm::writeCounterRows(grid.data(), rowStride, rows.data(), rows.size(),
+                          bits.data(), bitCount);
+    sdm::setKernelISA(originalISA);
+
+    INFO("Kernel " << static_cast<int>(isa));
+    REQUIRE(vector<COUNTER>(grid.data(), grid.data() + grid.size()) ==
+            expected);
+  }
+}
+
+}  // namespace
+
+SCENARIO("Counter write kernels agree with a counter at a time.",
+         "[sdm::writeCounterRows]") {
+  std::mt19937_64 rng(42);
+
+  for (size_t bitCount : {1, 3, 64, 100, 256, 1000, 2049, 5000}) {
+    GIVEN("Rows of " + std::to_string(bitCount) + " counters.") {
+      THEN("8-bit counters are written exactly.") {
+        checkWriteCounterRows<int8_t>(bitCount, &rng);
+      }
+      THEN("16-bit counters are written exactly.") {
+        checkWriteCounterRows<int16_t>(bitCount, &rng);
+      }
+      THEN("32-bit counters are written exactly.") {
+        checkWriteCounterRows<int32_t>(bitCount, &rng);
+      }
+      THEN("64-bit counters are written exactly.") {
+        checkWriteCounterRows<int64_t>(bitCount, &rng);
+      }
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Reads random rows of a random grid with each kernel and checks the sign of
+ * each sum, then reads rowCount copies of a row of saturated counters, whose
+ * sums overflow any type narrower than needed.
+ */
+template<typename COUNTER>
+void checkReadCounterRows(size_t bitCount,
+                          size_t rowCount,
+                          std::mt19937_64* rng) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t laneCount = sdm::CACHE_LINE_SIZE / sizeof(COUNTER);
+  const size_t rowStride = (bitCount + laneCount - 1) / laneCount * laneCount;
+  constexpr size_t gridRowCount = 7;
+
+  // 64-bit sums only hold that many 64-bit counters if they are small.
+  const COUNTER scale = sizeof(COUNTER) < sizeof(int64_t) ? 1 : 1024;
+  const bool saturate = sizeof(COUNTER) < sizeof(int64_t) || rowCount <= 1;
+
+  sdm::AlignedBuffer<COUNTER> grid(gridRowCount * rowStride);
+  for (size_t row = 0; row < gridRowCount; row++) {
+    auto counters = randomCounters<COUNTER>(bitCount, rng);
+    for (size_t i = 0; i < bitCount; i++) {
+      grid[row * rowStride + i] = counters[i] / scale;
+    }
+  }
+  // Row 0 is saturated, alternately up and down.
+  for (size_t i = 0; saturate && i < bitCount; i++) {
+    grid[i] = i % 2 ? std::numeric_limits<COUNTER>::max() :
+              std::numeric_limits<COUNTER>::min();
+  }
+
+  vector<sdm::LOCATION_INDEX_TYPE> rows(rowCount);
+  for (auto& row : rows) {
+    row = 1 + (*rng)() % (gridRowCount - 1);
+  }
+  const vector<sdm::LOCATION_INDEX_TYPE> saturatedRows(rowCount, 0);
+
+  vector<sdm::WORD_TYPE> expected(sdm::wordCount(bitCount));
+  vector<sdm::WORD_TYPE> expectedSaturated(sdm::wordCount(bitCount));
+  for (size_t i = 0; i < bitCount; i++) {
+    int64_t sum = 0;
+    for (auto row : rows) {
+      sum += grid[row * rowStride + i];
+    }
+    expected[i / sdm::WORD_BIT_SIZE] |=
+      sdm::WORD_TYPE(sum > 0) << (i % sdm::WORD_BIT_SIZE);
+    expectedSaturated[i / sdm::WORD_BIT_SIZE] |=
+      sdm::WORD_TYPE(rowCount > 0 && i % 2) <<
+      (i % sdm::WORD_BIT_SIZE);
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+
+    // Garbage to check every word is overwritten.
+    vector<sdm::WORD_TYPE> bits(expected.size(), ~sdm::WORD_TYPE(0));
+    vector<sdm::WORD_TYPE> saturatedBits(expected.size(), ~sdm::WORD_TYPE(0));
+    sdm::setKernelISA(isa);
+    sdm::readCounterRows(grid.data(), rowStride, rows.data(), rows.size(),
+                         bitCount, bits.data());
+    sdm::readCounterRows(grid.data(), rowStride, saturatedRows.data(),
+                         saturatedRows.size(), bitCount,
+                         saturatedBits.data());
+    sdm::setKernelISA(originalISA);
+
+    INFO("Kernel " << static_cast<int>(isa));
+    REQUIRE(bits == expected);
+    if (saturate) {
+      REQUIRE(saturatedBits == expectedSaturated);
+    }
+  }
+}
+
+}  // namespace
+
+SCENARIO("Counter read kernels agree with a sum at a time.",
+         "[sdm::readCounterRows]") {
+  std::mt19937_64 rng(42);
+
+  for (size_t bitCount : {1, 3, 64, 100, 256, 1000, 2049, 5000}) {
+    GIVEN("Rows of " + std::to_string(bitCount) + " counters.") {
+      for (size_t rowCount : {0, 1, 5, 255, 256, 300}) {
+        WHEN("I read " + std::to_string(rowCount) + " rows.") {
+          THEN("8-bit counters are summed exactly.") {
+            checkReadCounterRows<int8_t>(bitCount, rowCount, &rng);
+          }
+          THEN("16-bit counters are summed exactly.") {
+            checkReadCounterRows<int16_t>(bitCount, rowCount, &rng);
+          }
+          THEN("32-bit counters are summed exactly.") {
+            checkReadCounterRows<int32_t>(bitCount, rowCount, &rng);
+          }
+          THEN("64-bit counters are summed exactly.") {
+            checkReadCounterRows<int64_t>(bitCount, rowCount, &rng);
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("More 16-bit rows than a 32-bit sum holds.") {
+    THEN("They are summed in 64 bits.") {
+      checkReadCounterRows<int16_t>(64, 70000, &rng);
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Writes random data with random weights to some rows of a random grid with
+ * each kernel and checks them against a counter at a time.
+ */
+template<typename COUNTER>
+void checkWeightedWriteCounterRows(size_t bitCount, std::mt19937_64* rng) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t laneCount = sdm::CACHE_LINE_SIZE / sizeof(COUNTER);
+  const size_t rowStride = (bitCount + laneCount - 1) / laneCount * laneCount;
+  constexpr size_t rowCount = 7;
+  const vector<sdm::LOCATION_INDEX_TYPE> rows = {5, 0, 3, 5, 6, 2};
+
+  sdm::AlignedBuffer<COUNTER> original(rowCount * rowStride);
+  auto counters = randomCounters<COUNTER>(rowCount * rowStride, rng);
+  std::copy(counters.begin(), counters.end(), original.data());
+  // Weights of any size and sign, but for the minimum.
+  auto weights = randomCounters<COUNTER>(rows.size(), rng);
+  for (auto& weight : weights) {
+    weight = std::max<COUNTER>(weight,
+                               std::numeric_limits<COUNTER>::min() + 1);
+  }
+  weights[1] = 1;
+  weights[2] = 0;
+  vector<sdm::WORD_TYPE> bits(sdm::wordCount(bitCount));
+  for (auto& word : bits) {
+    word = (*rng)();
+  }
+
+  vector<COUNTER> expected(original.data(),
+                           original.data() + rowCount * rowStride);
+  for (size_t r = 0; r < rows.size(); r++) {
+    for (size_t i = 0; i < bitCount; i++) {
+      COUNTER& counter = expected[rows[r] * rowStride + i];
+      const bool set =
+        (bits[i / sdm::WORD_BIT_SIZE] >> (i % sdm::WORD_BIT_SIZE)) & 1;
+      const COUNTER delta = set ? weights[r] : -weights[r];
+      COUNTER sum;
+      if (__builtin_add_overflow(counter, delta, &sum)) {
+        sum = counter < 0 ? std::numeric_limits<COUNTER>::min() :
+              std::numeric_limits<COUNTER>::max();
+      }
+      counter = sum;
+    }
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+
+    sdm::AlignedBuffer<COUNTER> grid(original);
+    sdm::setKernelISA(isa);
+    sdm::writeCounterRows(grid.data(), rowStride, rows.data(),
+                          weights.data(), rows.size(), bits.data(),
+                          bitCount);
+    sdm::setKernelISA(originalISA);
+
+    INFO("Kernel " << static_cast<int>(isa));
+    REQUIRE(vector<COUNTER>(grid.data(), grid.data() + grid.size()) ==
+            expected);
+  }
+}
+
+/**
+ * Reads random rows of a random grid with random weights with each kernel
+ * and checks the sign of each sum.
+ */
+template<typename COUNTER>
+void checkWeightedReadCounterRows(size_t bitCount,
+                                  size_t rowCount,
+                                  std::mt19937_64* rng) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t laneCount = sdm::CACHE_LINE_SIZE / sizeof(COUNTER);
+  const size_t rowStride = (bitCount + laneCount - 1) / laneCount * laneCount;
+  constexpr size_t gridRowCount = 7;
+  // Small enough for the weighted sums to hold in 64 bits.
+  const COUNTER scale = sizeof(COUNTER) < sizeof(int64_t) ? 1 : 1 << 30;
+
+  sdm::AlignedBuffer<COUNTER> grid(gridRowCount * rowStride);
+  for (size_t row = 0; row < gridRowCount; row++) {
+    auto counters = randomCounters<COUNTER>(bitCount, rng);
+    for (size_t i = 0; i < bitCount; i++) {
+      grid[row * rowStride + i] = counters[i] / scale;
+    }
+  }
+
+  vector<sdm::LOCATION_INDEX_TYPE> rows(rowCount);
+  vector<COUNTER> weights(rowCount);
+  for (size_t r = 0; r < rowCount; r++) {
+    rows[r] = (*rng)() % gridRowCount;
+    weights[r] = static_cast<COUNTER>(
+      static_cast<int64_t>((*rng)() % 201) - 100);
+  }
+
+  vector<sdm::WORD_TYPE> expected(sdm::wordCount(bitCount));
+  for (size_t i = 0; i < bitCount; i++) {
+    int64_t sum = 0;
+    for (size_t r = 0; r < rowCount; r++) {
+      sum += static_cast<int64_t>(weights[r]) * grid[rows[r] * rowStride + i];
+    }
+    expected[i / sdm::WORD_BIT_SIZE] |=
+      sdm::WORD_TYPE(sum > 0) << (i % sdm::WORD_BIT_SIZE);
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+
+    vector<sdm::WORD_TYPE> bits(expected.size(), ~sdm::WORD_TYPE(0));
+    sdm::setKernelISA(isa);
+    sdm::readCounterRows(grid.data(), rowStride, rows.data(), weights.data(),
+                         rows.size(), bitCount, bits.data());
+    sdm::setKernelISA(originalISA);
+
+    INFO("Kernel " << static_cast<int>(isa));
+    REQUIRE(bits == expected);
+  }
+}
+
+}  // namespace
+
+SCENARIO("Weighted counter kernels agree with a counter at a time.",
+         "[sdm::writeCounterRows][sdm::readCounterRows]") {
+  std::mt19937_64 rng(42);
+
+  for (size_t bitCount : {1, 100, 256, 2049}) {
+    GIVEN("Rows of " + std::to_string(bitCount) + " counters.") {
+      THEN("Weighted writes saturate exactly.") {
+        checkWeightedWriteCounterRows<int8_t>(bitCount, &rng);
+        checkWeightedWriteCounterRows<int16_t>(bitCount, &rng);
+        checkWeightedWriteCounterRows<int32_t>(bitCount, &rng);
+        checkWeightedWriteCounterRows<int64_t>(bitCount, &rng);
+      }
+
+      THEN("Weighted reads are summed exactly.") {
+        for (size_t rowCount : {0, 1, 9, 300}) {
+          checkWeightedReadCounterRows<int8_t>(bitCount, rowCount, &rng);
+          checkWeightedReadCounterRows<int16_t>(bitCount, rowCount, &rng);
+          checkWeightedReadCounterRows<int32_t>(bitCount, rowCount, &rng);
+          checkWeightedReadCounterRows<int64_t>(bitCount, rowCount, &rng);
+        }
+      }
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Reads 2 counters, lane 0 at positive and lane 1 at negative, from each
+ * row with each kernel, with weights too large for the sums to hold in 64
+ * bits. Only the positive lane is set.
+ */
+template<typename COUNTER>
+void checkSaturatedReadCounterRows(COUNTER counter,
+                                   const vector<COUNTER>& weights) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t rowStride = sdm::CACHE_LINE_SIZE / sizeof(COUNTER);
+  sdm::AlignedBuffer<COUNTER> grid(weights.size() * rowStride);
+  vector<sdm::LOCATION_INDEX_TYPE> rows(weights.size());
+  for (size_t r = 0; r < weights.size(); r++) {
+    grid[r * rowStride] = counter;
+    grid[r * rowStride + 1] = -counter;
+    rows[r] = r;
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+
+    sdm::WORD_TYPE bits = ~sdm::WORD_TYPE(0);
+    sdm::setKernelISA(isa);
+    sdm::readCounterRows(grid.data(), rowStride, rows.data(), weights.data(),
+                         rows.size(), 2, &bits);
+    sdm::setKernelISA(originalISA);
+
+    INFO("Kernel " << static_cast<int>(isa));
+    REQUIRE(bits == 0b01);
+  }
+}
+
+}  // namespace
+
+SCENARIO("Weighted reads past the range of 64-bit sums saturate.",
+         "[sdm::readCounterRows]") {
+  GIVEN("Products past the range of int64_t.") {
+    THEN("They saturate instead of wrapping.") {
+      checkSaturatedReadCounterRows<int64_t>(
+        2, vector<int64_t>{int64_t(1) << 62});
+    }
+  }
+
+  GIVEN("Products whose sum is past the range of int64_t.") {
+    THEN("The sum saturates instead of wrapping.") {
+      checkSaturatedReadCounterRows<int64_t>(
+        2, vector<int64_t>{int64_t(1) << 61, int64_t(1) << 61});
+      const int32_t max = std::numeric_limits<int32_t>::max();
+      checkSaturatedReadCounterRows<int32_t>(
+        max, vector<int32_t>{max, max, max});
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Bit-sliced grid of counters, planeCount bit-planes per row, and the same
+ * counters one at a time.
+ */
+struct BitSlicedGrid {
+  BitSlicedGrid(size_t bitCount, size_t planeCount, size_t rowCount) :
+    bitCount(bitCount),
+    planeCount(planeCount),
+    planeWordCount(sdm::wordCount(bitCount)),
+    rowStride(planeCount * planeWordCount),
+    planes(rowCount * rowStride),
+    counters(rowCount * bitCount) {
+  }
+
+  void set(size_t row, size_t i, int64_t counter) {
+    counters[row * bitCount + i] = counter;
+    for (size_t k = 0; k < planeCount; k++) {
+      sdm::WORD_TYPE& word =
+        planes[row * rowStride + k * planeWordCount + i / sdm::WORD_BIT_SIZE];
+      const sdm::WORD_TYPE bit = sdm::WORD_TYPE(1) << (i % sdm::WORD_BIT_SIZE);
+      word = (counter >> k) & 1 ? word | bit : word & ~bit;
+    }
+  }
+
+  int64_t get(size_t row, size_t i) const {
+    int64_t counter = 0;
+    for (size_t k = 0; k < planeCount; k++) {
+      counter |= static_cast<int64_t>(
+        (planes[row * rowStride + k * planeWordCount +
+                i / sdm::WORD_BIT_SIZE] >> (i % sdm::WORD_BIT_SIZE)) & 1) << k;
+    }
+    const int64_t sign = int64_t(1) << (planeCount - 1);
+    return (counter ^ sign) - sign;
+  }
+
+  size_t bitCount;
+  size_t planeCount;
+  size_t planeWordCount;
+  size_t rowStride;
+  vector<sdm::WORD_TYPE> planes;
+  vector<int64_t> counters;
+};
+
+/**
+ * Writes random data to some rows of a random bit-sliced grid, then reads
+ * random rows, with each kernel and checks them against a counter at a
+ * time.
+ */
+void checkBitSlicedCounterRows(size_t bitCount,
+                               size_t planeCount,
+                               std::mt19937_64* rng) {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  constexpr size_t gridRowCount = 7;
+  const int64_t max = (int64_t(1) << (planeCount - 1)) - 1;
+  const int64_t min = -max - 1;
+
+  // A quarter of the counters at a bound, as in randomCounters.
+  BitSlicedGrid original(bitCount, planeCount, gridRowCount);
+  for (size_t row = 0; row < gridRowCount; row++) {
+    for (size_t i = 0; i < bitCount; i++) {
+      const uint64_t r = (*rng)();
+      original.set(row, i, r % 8 == 0 ? max : r % 8 == 1 ? min :
+                   static_cast<int64_t>((r >> 8) % (max - min + 1)) + min);
+    }
+  }
+  vector<sdm::WORD_TYPE> bits(sdm::wordCount(bitCount));
+  for (auto& word : bits) {
+    word = (*rng)();
+  }
+  const vector<sdm::LOCATION_INDEX_TYPE> writtenRows = {5, 0, 3, 5, 6};
+
+  vector<int64_t> expected(original.counters);
+  for (auto row : writtenRows) {
+    for (size_t i = 0; i < bitCount; i++) {
+      int64_t& counter = expected[row * bitCount + i];
+      if ((bits[i / sdm::WORD_BIT_SIZE] >> (i % sdm::WORD_BIT_SIZE)) & 1) {
+        counter += counter != max;
+      } else {
+        counter -= counter != min;
+      }
+    }
+  }
+
+  for (sdm::KernelISA isa : kernelISAs) {
+    if (!sdm::isKernelISASupported(isa)) {
+      continue;
+    }
+    INFO("Kernel " << static_cast<int>(isa));
+
+    BitSlicedGrid grid(original);
+    sdm::setKernelISA(isa);
+    sdm::writeBitSlicedCounterRows(grid.planes.data(), grid.rowStride,
+                                   planeCount, writtenRows.data(),
+                                   writtenRows.size(), bits.data(), bitCount);
+    sdm::setKernelISA(originalISA);
+
+    vector<int64_t> written(gridRowCount * bitCount);
+    for (size_t row = 0; row < gridRowCount; row++) {
+      for (size_t i = 0; i < bitCount; i++) {
+        written[row * bitCount + i] = grid.get(row, i);
+      }
+    }
+    REQUIRE(written == expected);
+    // The padding of the last word of each bit-plane is left clear.
+    const size_t paddingShift = bitCount % sdm::WORD_BIT_SIZE;
+    for (size_t w = grid.planeWordCount - 1; paddingShift != 0 &&
+         w < grid.planes.size(); w += grid.planeWordCount) {
+      REQUIRE(grid.planes[w] >> paddingShift == 0);
+    }
+
+    for (size_t rowCount : {0, 1, 5, 300}) {
+      vector<sdm::LOCATION_INDEX_TYPE> rows(rowCount);
+      for (auto& row : rows) {
+        row = (*rng)() % gridRowCount;
+      }
+      vector<sdm::WORD_TYPE> expectedBits(bits.size());
+      for (size_t i = 0; i < bitCount; i++) {
+        int64_t sum = 0;
+        for (auto row : rows) {
+          sum += grid.get(row, i);
+        }
+        expectedBits[i / sdm::WORD_BIT_SIZE] |=
+          sdm::WORD_TYPE(sum > 0) << (i % sdm::WORD_BIT_SIZE);
+      }
+
+      // Garbage to check every word is overwritten.
+      vector<sdm::WORD_TYPE> readBits(bits.size(), ~sdm::WORD_TYPE(0));
+      sdm::setKernelISA(isa);
+      sdm::readBitSlicedCounterRows(grid.planes.data(), grid.rowStride,
+                                    planeCount, rows.data(), rows.size(),
+                                    bitCount, readBits.data());
+      sdm::setKernelISA(originalISA);
+
+      INFO("Rows " << rowCount);
+      REQUIRE(readBits == expectedBits);
+    }
+  }
+}
+
+}  // namespace
+
+SCENARIO("Bit-sliced counter kernels agree with a counter at a time.",
+         "[sdm::writeBitSlicedCounterRows][sdm::readBitSlicedCounterRows]") {
+  std::mt19937_64 rng(42);
+
+  for (size_t bitCount : {1, 3, 64, 100, 256, 600, 1000}) {
+    GIVEN("Rows of " + std::to_string(bitCount) + " counters.") {
+      for (size_t planeCount : {2, 4, 8, 16}) {
+        THEN(std::to_string(planeCount) + "-bit counters are written and "
+             "summed exactly.") {
+          checkBitSlicedCounterRows(bitCount, planeCount, &rng);
+        }
+      }
+    }
+  }
+}
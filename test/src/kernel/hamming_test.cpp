@@ -0,0 +1,537 @@
+/**
+ * sdm - Sparse Distributed Memory
+ * Copyright (C) 2016  Joey Andres<yeojserdna@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "sdm"
+
+#include "catch.hpp"
+
+using std::vector;
+
+namespace {
+
+const sdm::KernelISA kernelISAs[] = {
+  sdm::KernelISA::GENERIC,
+  sdm::KernelISA::POPCNT,
+  sdm::KernelISA::AVX2,
+  sdm::KernelISA::AVX512_VPOPCNTDQ
+};
+
+vector<sdm::WORD_TYPE> randomWords(size_t count, std::mt19937_64* rng) {
+  vector<sdm::WORD_TYPE> words(count);
+  for (auto& word : words) {
+    word = (*rng)();
+  }
+  return words;
+}
+
+}  // namespace
+
+SCENARIO("Hamming distance kernels agree with the reference distance.",
+         "[sdm::hammingDistances]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(42);
+
+  GIVEN("The generic kernel.") {
+    THEN("It is always supported.") {
+      REQUIRE(sdm::isKernelISASupported(sdm::KernelISA::GENERIC));
+    }
+  }
+
+  for (size_t wordCount : {1, 2, 3, 4, 5, 7, 8, 9, 16, 17}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      constexpr size_t locationCount = 37;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto address = randomWords(wordCount, &rng);
+
+      for (sdm::KernelISA isa : kernelISAs) {
+        if (!sdm::isKernelISASupported(isa)) {
+          continue;
+        }
+
+        WHEN("I compute the distances with kernel " +
+             std::to_string(static_cast<int>(isa))) {
+          sdm::setKernelISA(isa);
+          vector<size_t> distances(locationCount);
+          sdm::hammingDistances(locations.data(), locationCount, wordCount,
+                                address.data(), distances.data());
+          sdm::setKernelISA(originalISA);
+
+          THEN("Each distance matches the reference.") {
+            for (size_t i = 0; i < locationCount; i++) {
+              REQUIRE(distances[i] == sdm::hammingDistance(
+                locations.data() + i * wordCount,
+                address.data(),
+                wordCount));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Activation kernels keep exactly the locations within threshold.",
+         "[sdm::activateLocations]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(7);
+
+  for (size_t wordCount : {1, 2, 3, 4, 5, 8, 16}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      // More than one activation chunk, and not a multiple of 16.
+      constexpr size_t locationCount = 5003;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto address = randomWords(wordCount, &rng);
+      const size_t threshold = wordCount * sdm::WORD_BIT_SIZE / 2 - 4;
+
+      sdm::activationList expected;
+      for (size_t i = 0; i < locationCount; i++) {
+        if (sdm::hammingDistance(locations.data() + i * wordCount,
+                                 address.data(), wordCount) <= threshold) {
+          expected.push_back(i);
+        }
+      }
+
+      for (sdm::KernelISA isa : kernelISAs) {
+        if (!sdm::isKernelISASupported(isa)) {
+          continue;
+        }
+
+        WHEN("I activate with kernel " +
+             std::to_string(static_cast<int>(isa))) {
+          sdm::setKernelISA(isa);
+          sdm::activationList activated(3, 42);
+          sdm::activateLocations(locations.data(), locationCount, wordCount,
+                                 address.data(), threshold, &activated);
+          sdm::activationList all;
+          sdm::activateLocations(locations.data(), locationCount, wordCount,
+                                 address.data(), size_t(-1), &all);
+          sdm::setKernelISA(originalISA);
+
+          THEN("The activated indices match the reference.") {
+            REQUIRE(!expected.empty());
+            REQUIRE(activated == expected);
+            REQUIRE(all.size() == locationCount);
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Nearest activation keeps exactly the count nearest locations.",
+         "[sdm::activateNearestLocations]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(13);
+
+  for (size_t wordCount : {1, 2, 4, 5}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      constexpr size_t locationCount = 3001;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      // Only a few differing bits, so many locations tie.
+      for (size_t i = 0; i < locations.size(); i += 2) {
+        locations[i] &= 0xff;
+      }
+      auto address = randomWords(wordCount, &rng);
+      address[0] &= 0xff;
+
+      // Reference: the first count by (distance, index).
+      vector<sdm::LOCATION_INDEX_TYPE> order(locationCount);
+      for (size_t i = 0; i < locationCount; i++) {
+        order[i] = i;
+      }
+      std::stable_sort(order.begin(), order.end(),
+                       [&](sdm::LOCATION_INDEX_TYPE lhs,
+                           sdm::LOCATION_INDEX_TYPE rhs) {
+                         return sdm::hammingDistance(
+                                  locations.data() + lhs * wordCount,
+                                  address.data(), wordCount) <
+                                sdm::hammingDistance(
+                                  locations.data() + rhs * wordCount,
+                                  address.data(), wordCount);
+                       });
+
+      for (size_t count : {0, 1, 17, 1000, 3001, 5000}) {
+        WHEN("I activate the " + std::to_string(count) + " nearest.") {
+          sdm::activationList expected(
+            order.begin(),
+            order.begin() + std::min<size_t>(count, locationCount));
+          std::sort(expected.begin(), expected.end());
+
+          THEN("Every kernel activates the reference locations.") {
+            for (sdm::KernelISA isa : kernelISAs) {
+              if (!sdm::isKernelISASupported(isa)) {
+                continue;
+              }
+              sdm::setKernelISA(isa);
+              sdm::activationList activated(3, 42);
+              sdm::activateNearestLocations(locations.data(), locationCount,
+                                            wordCount, address.data(), count,
+                                            &activated);
+              sdm::setKernelISA(originalISA);
+              REQUIRE(activated == expected);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Early exit activation keeps exactly the locations within threshold.",
+         "[sdm::activateLocations]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(11);
+
+  for (size_t wordCount : {2, 5, 8, 16, 17}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      constexpr size_t locationCount = 3001;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto address = randomWords(wordCount, &rng);
+      const size_t threshold = wordCount * sdm::WORD_BIT_SIZE / 2 - 4;
+
+      // Blocks in reverse order, so the partial last block comes first.
+      vector<size_t> blockOrder(sdm::hammingBlockCount(wordCount));
+      for (size_t b = 0; b < blockOrder.size(); b++) {
+        blockOrder[b] = blockOrder.size() - 1 - b;
+      }
+
+      sdm::activationList expected;
+      sdm::activateLocations(locations.data(), locationCount, wordCount,
+                             address.data(), threshold, &expected);
+
+      for (sdm::KernelISA isa : kernelISAs) {
+        if (!sdm::isKernelISASupported(isa)) {
+          continue;
+        }
+
+        WHEN("I activate with kernel " +
+             std::to_string(static_cast<int>(isa))) {
+          sdm::setKernelISA(isa);
+          sdm::activationList activated;
+          sdm::activateLocations(locations.data(), locationCount, wordCount,
+                                 address.data(), threshold, blockOrder.data(),
+                                 &activated);
+          sdm::setKernelISA(originalISA);
+
+          THEN("The activated indices match the full scan.") {
+            REQUIRE(!expected.empty());
+            REQUIRE(activated == expected);
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Batch activation matches one activation per address.",
+         "[sdm::activateLocationsBatch]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(13);
+
+  for (size_t wordCount : {1, 2, 3, 4, 8, 9, 16}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      // Several tiles, and not a multiple of the vector widths.
+      constexpr size_t locationCount = 9001;
+      constexpr size_t addressCount = 9;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto addresses = randomWords(addressCount * wordCount, &rng);
+      const size_t threshold = wordCount * sdm::WORD_BIT_SIZE / 2 - 4;
+
+      vector<sdm::activationList> expected(addressCount);
+      for (size_t q = 0; q < addressCount; q++) {
+        sdm::activateLocations(locations.data(), locationCount, wordCount,
+                               addresses.data() + q * wordCount, threshold,
+                               &expected[q]);
+      }
+
+      for (sdm::KernelISA isa : kernelISAs) {
+        if (!sdm::isKernelISASupported(isa)) {
+          continue;
+        }
+
+        WHEN("I activate the batch with kernel " +
+             std::to_string(static_cast<int>(isa))) {
+          sdm::setKernelISA(isa);
+          vector<sdm::activationList> activated(addressCount);
+          sdm::activateLocationsBatch(
+            locations.data(), locationCount, wordCount, addresses.data(),
+            addressCount, threshold, activated.data());
+          sdm::setKernelISA(originalISA);
+
+          THEN("Each address activates the same locations.") {
+            for (size_t q = 0; q < addressCount; q++) {
+              REQUIRE(!expected[q].empty());
+              REQUIRE(activated[q] == expected[q]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Distance histogram counts the distance of every pair.",
+         "[sdm::hammingDistanceHistogram]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(19);
+
+  for (size_t wordCount : {1, 3, 4, 40}) {
+    GIVEN("Locations of " + std::to_string(wordCount) + " words.") {
+      // More than one tile for the widest locations.
+      constexpr size_t locationCount = 5003;
+      constexpr size_t addressCount = 3;
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto addresses = randomWords(addressCount * wordCount, &rng);
+
+      vector<size_t> expected(wordCount * sdm::WORD_BIT_SIZE + 1);
+      for (size_t q = 0; q < addressCount; q++) {
+        for (size_t i = 0; i < locationCount; i++) {
+          expected[sdm::hammingDistance(locations.data() + i * wordCount,
+                                        addresses.data() + q * wordCount,
+                                        wordCount)]++;
+        }
+      }
+
+      THEN("Every kernel counts the reference distances.") {
+        for (sdm::KernelISA isa : kernelISAs) {
+          if (!sdm::isKernelISASupported(isa)) {
+            continue;
+          }
+          sdm::setKernelISA(isa);
+          vector<size_t> histogram(expected.size(), 42);
+          sdm::hammingDistanceHistogram(locations.data(), locationCount,
+                                        wordCount, addresses.data(),
+                                        addressCount, histogram.data());
+          sdm::setKernelISA(originalISA);
+          REQUIRE(histogram == expected);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Bit-sliced activation matches the row-major activation.",
+         "[sdm::activateBitSliced]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(17);
+
+  for (size_t bitCount : {1, 7, 16, 64, 100, 256}) {
+    GIVEN("Locations of " + std::to_string(bitCount) + " bits.") {
+      // More than one chunk of slices, the last slice partial.
+      constexpr size_t locationCount = 2600;
+      const size_t wordCount = sdm::wordCount(bitCount);
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto address = randomWords(wordCount, &rng);
+      for (size_t i = 0; i < locationCount; i++) {
+        locations[i * wordCount + wordCount - 1] &=
+          sdm::lastWordMask(bitCount);
+      }
+      address[wordCount - 1] &= sdm::lastWordMask(bitCount);
+
+      vector<sdm::WORD_TYPE> planes(sdm::bitSliceCount(locationCount) *
+                                    bitCount * sdm::BIT_SLICE_WORD_COUNT);
+      sdm::transposeToBitSlices(locations.data(), locationCount, bitCount,
+                                planes.data());
+
+      THEN("Each bit-plane holds the bits of the locations.") {
+        for (size_t i : {size_t(0), locationCount / 2, locationCount - 1}) {
+          for (size_t b = 0; b < bitCount; b++) {
+            const size_t s = i / sdm::BIT_SLICE_LOCATION_COUNT;
+            const size_t j = i % sdm::BIT_SLICE_LOCATION_COUNT;
+            const sdm::WORD_TYPE* plane = planes.data() +
+              (s * bitCount + b) * sdm::BIT_SLICE_WORD_COUNT;
+            REQUIRE(((plane[j / 64] >> (j % 64)) & 1) ==
+                    ((locations[i * wordCount + b / 64] >> (b % 64)) & 1));
+          }
+        }
+      }
+
+      for (size_t threshold : {size_t(0), bitCount / 2 - bitCount / 8,
+                               bitCount / 2, bitCount, size_t(-1)}) {
+        sdm::activationList expected;
+        sdm::activateLocations(locations.data(), locationCount, wordCount,
+                               address.data(), threshold, &expected);
+
+        for (sdm::KernelISA isa : kernelISAs) {
+          if (!sdm::isKernelISASupported(isa)) {
+            continue;
+          }
+
+          WHEN("I activate within " + std::to_string(threshold) +
+               " with kernel " + std::to_string(static_cast<int>(isa))) {
+            sdm::setKernelISA(isa);
+            sdm::activationList activated(3, 42);
+            sdm::activateBitSliced(planes.data(), locationCount, bitCount,
+                                   address.data(), threshold, &activated);
+            sdm::setKernelISA(originalISA);
+
+            THEN("The activated indices match the row-major scan.") {
+              REQUIRE(activated == expected);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Incremental bit-sliced distances match a full recomputation.",
+         "[sdm::updateBitSlicedDistances]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+  std::mt19937_64 rng(23);
+
+  for (size_t bitCount : {1, 7, 64, 100, 256}) {
+    GIVEN("Locations of " + std::to_string(bitCount) + " bits.") {
+      // More than one chunk of slices, the last slice partial.
+      constexpr size_t locationCount = 2600;
+      const size_t wordCount = sdm::wordCount(bitCount);
+      auto locations = randomWords(locationCount * wordCount, &rng);
+      auto initialAddress = randomWords(wordCount, &rng);
+      for (size_t i = 0; i < locationCount; i++) {
+        locations[i * wordCount + wordCount - 1] &=
+          sdm::lastWordMask(bitCount);
+      }
+      initialAddress[wordCount - 1] &= sdm::lastWordMask(bitCount);
+
+      vector<sdm::WORD_TYPE> planes(sdm::bitSliceCount(locationCount) *
+                                    bitCount * sdm::BIT_SLICE_WORD_COUNT);
+      sdm::transposeToBitSlices(locations.data(), locationCount, bitCount,
+                                planes.data());
+      const size_t planeCount = sdm::bitSlicedDistancePlaneCount(bitCount);
+
+      for (sdm::KernelISA isa : kernelISAs) {
+        if (!sdm::isKernelISASupported(isa)) {
+          continue;
+        }
+
+        WHEN("I flip a few bits at a time and update the distances with "
+             "kernel " + std::to_string(static_cast<int>(isa))) {
+          sdm::setKernelISA(isa);
+          auto address = initialAddress;
+          vector<sdm::WORD_TYPE> distances(
+            sdm::bitSliceCount(locationCount) * planeCount *
+            sdm::BIT_SLICE_WORD_COUNT);
+          sdm::bitSlicedDistances(planes.data(), locationCount, bitCount,
+                                  address.data(), distances.data());
+          auto unsliced = [&]() {
+            vector<size_t> rv(locationCount);
+            for (size_t i = 0; i < locationCount; i++) {
+              rv[i] = sdm::bitSlicedDistance(distances.data(), bitCount, i);
+            }
+            return rv;
+          };
+          auto rowMajor = [&]() {
+            vector<size_t> rv(locationCount);
+            sdm::hammingDistances(locations.data(), locationCount, wordCount,
+                                  address.data(), rv.data());
+            return rv;
+          };
+          const vector<size_t> initialDistances = unsliced();
+          const vector<size_t> initialExpected = rowMajor();
+
+          vector<vector<size_t>> updatedDistances, expectedDistances;
+          vector<sdm::activationList> activated, expectedActivated;
+          for (size_t step = 0; step < 5; step++) {
+            vector<size_t> flippedBits;
+            for (size_t b = 0; b < bitCount; b++) {
+              if (rng() % 16 == 0 || b == step % bitCount) {
+                flippedBits.push_back(b);
+                address[b / 64] ^= sdm::WORD_TYPE(1) << (b % 64);
+              }
+            }
+            const size_t threshold = bitCount / 2 - bitCount / 8;
+            activated.emplace_back(3, 42);
+            sdm::updateBitSlicedDistances(
+              planes.data(), locationCount, bitCount, address.data(),
+              flippedBits.data(), flippedBits.size(), threshold,
+              distances.data(), &activated.back());
+            updatedDistances.push_back(unsliced());
+            expectedDistances.push_back(rowMajor());
+            expectedActivated.emplace_back();
+            sdm::activateLocations(locations.data(), locationCount,
+                                   wordCount, address.data(), threshold,
+                                   &expectedActivated.back());
+          }
+          sdm::setKernelISA(originalISA);
+
+          THEN("The initial distances match the row-major distances.") {
+            REQUIRE(initialDistances == initialExpected);
+          }
+
+          THEN("They match the distances to the new address.") {
+            REQUIRE(updatedDistances == expectedDistances);
+            REQUIRE(activated == expectedActivated);
+          }
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Procedural activation matches the activation of the generated "
+         "locations.",
+         "[sdm::activateProceduralLocations]") {
+  const sdm::KernelISA originalISA = sdm::getKernelISA();
+
+  for (size_t bitCount : {1, 64, 100, 256, 300}) {
+    GIVEN("Locations of " + std::to_string(bitCount) + " bits.") {
+      // More than one chunk, and not a multiple of the vector widths.
+      constexpr size_t locationCount = 2053;
+      constexpr uint64_t seed = 99;
+      const size_t wordCount = sdm::wordCount(bitCount);
+      vector<sdm::WORD_TYPE> locations(locationCount * wordCount);
+      sdm::generateRandomRows(seed, locationCount, bitCount,
+                              locations.data());
+      vector<sdm::WORD_TYPE> address(
+        locations.begin() + 7 * wordCount, locations.begin() + 8 * wordCount);
+
+      for (size_t threshold : {size_t(0), bitCount / 2 - bitCount / 16,
+                               bitCount}) {
+        sdm::activationList expected;
+        sdm::activateLocations(locations.data(), locationCount, wordCount,
+                               address.data(), threshold, &expected);
+
+        for (sdm::KernelISA isa : kernelISAs) {
+          if (!sdm::isKernelISASupported(isa)) {
+            continue;
+          }
+
+          WHEN("I activate within " + std::to_string(threshold) +
+               " with kernel " + std::to_string(static_cast<int>(isa))) {
+            sdm::setKernelISA(isa);
+            sdm::activationList activated(3, 42);
+            sdm::activateProceduralLocations(seed, locationCount, bitCount,
+                                             address.data(), threshold,
+                                             &activated);
+            sdm::setKernelISA(originalISA);
+
+            THEN("The activated indices match the stored locations'.") {
+              REQUIRE(!expected.empty());
+              REQUIRE(activated == expected);
+            }
+          }
+        }
+      }
+    }
+  }
+}